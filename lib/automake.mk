@@ -78,6 +78,8 @@ lib_libopenvswitch_la_SOURCES = \
 	lib/dp-packet.h \
 	lib/dp-packet.c \
 	lib/dpdk.h \
+	lib/dpif-netdev-perf.c \
+	lib/dpif-netdev-perf.h \
 	lib/dpif-netdev.c \
 	lib/dpif-netdev.h \
 	lib/dpif-provider.h \
@@ -104,6 +106,8 @@ lib_libopenvswitch_la_SOURCES = \
 	lib/hmapx.c \
 	lib/hmapx.h \
 	lib/id-pool.c \
+	lib/ipf.c \
+	lib/ipf.h \
 	lib/id-pool.h \
 	lib/jhash.c \
 	lib/jhash.h \
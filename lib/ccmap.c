@@ -237,6 +237,18 @@ ccmap_find(const struct ccmap *ccmap, uint32_t hash)
     return count;
 }
 
+/* Prefetches the bucket(s) that a subsequent ccmap_find() of 'hash' will
+ * probe. */
+void
+ccmap_prefetch(const struct ccmap *ccmap, uint32_t hash)
+{
+    const struct ccmap_impl *impl = ccmap_get_impl(ccmap);
+    uint32_t h = rehash(impl, hash);
+
+    OVS_PREFETCH(&impl->buckets[h & impl->mask]);
+    OVS_PREFETCH(&impl->buckets[other_hash(h) & impl->mask]);
+}
+
 static int
 ccmap_find_slot_protected(struct ccmap_bucket *b, uint32_t hash,
                           uint32_t *count)
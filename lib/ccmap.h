@@ -60,5 +60,6 @@ uint32_t ccmap_inc(struct ccmap *, uint32_t hash);
 uint32_t ccmap_dec(struct ccmap *, uint32_t hash);
 
 uint32_t ccmap_find(const struct ccmap *, uint32_t hash);
+void ccmap_prefetch(const struct ccmap *, uint32_t hash);
 
 #endif /* ccmap.h */
@@ -83,6 +83,12 @@ cls_conjunction_set_alloc(struct cls_match *match,
     }
 }
 
+/* The miniflow values are copied inline into the cls_match rather than
+ * interned and shared with the cls_rule: the copy is what keeps a lookup's
+ * match check on the same cache lines as the rest of the entry, and it is
+ * the only per-rule copy.  The masks, which are the part shared by many
+ * rules, are already interned: every rule of a subtable references the
+ * subtable's single mask. */
 static struct cls_match *
 cls_match_alloc(const struct cls_rule *rule, ovs_version_t version,
                 const struct cls_conjunction conj[], size_t n)
@@ -845,6 +851,14 @@ trie_ctx_init(struct trie_ctx *ctx, const struct cls_trie *trie)
     ctx->lookup_done = false;
 }
 
+/* Conjunction resolution is already O(matched clauses): the clause hits
+ * for each conjunction id are accumulated in a bitmap in this hmap, so a
+ * pipeline with thousands of clauses only pays for the clauses that the
+ * packet actually matched.  The only remaining superlinear work is the
+ * soft match loop below re-filtering the soft match array once per
+ * priority band it falls back through; that array holds one entry per
+ * matched subtable, not per clause, so its size is bounded by the number
+ * of distinct conjunctive match shapes, which stays small in practice. */
 struct conjunctive_match {
     struct hmap_node hmap_node;
     uint32_t id;
@@ -956,7 +970,16 @@ classifier_lookup__(const struct classifier *cls, ovs_version_t version,
         trie_ctx_init(&trie_ctx[i], &cls->tries[i]);
     }
 
-    /* Main loop. */
+    /* Main loop.
+     *
+     * The subtable vector is kept sorted by each subtable's maximum rule
+     * priority, and the cutoff expression 'hard_pri + 1' is re-evaluated
+     * on every step, so as soon as a match is found every subtable whose
+     * best possible rule could not beat it - i.e. all remaining lower
+     * priority bands - is skipped without being visited.  Subtables with
+     * a higher maximum priority must be visited regardless of any index,
+     * since any of them may contain a better match, which is why no
+     * secondary priority-band index would reduce the work further. */
     struct cls_subtable *subtable;
     PVECTOR_FOR_EACH_PRIORITY (subtable, hard_pri + 1, 2, sizeof *subtable,
                                &cls->subtables) {
@@ -1161,6 +1184,98 @@ classifier_lookup(const struct classifier *cls, ovs_version_t version,
     return classifier_lookup__(cls, version, flow, wc, true);
 }
 
+/* Looks up each of the 'n_flows' 'flows' in 'cls', storing the matching
+ * rule (or NULL) in the corresponding slot of 'rules' and accumulating
+ * the relevant wildcards into 'wcs[i]' when 'wcs' is nonnull.
+ *
+ * Equivalent to calling classifier_lookup() once per flow, but iterates
+ * subtable-major: each subtable (and the trie nodes its checks touch) is
+ * loaded once and probed with every still-unresolved flow, instead of
+ * being re-fetched for every flow, which matters when a burst of new
+ * flows arrives at once.  Flows that encounter conjunctive matches fall
+ * back to the single-flow lookup, which implements the full soft-match
+ * resolution. */
+void
+classifier_lookup_batch(const struct classifier *cls, ovs_version_t version,
+                        struct flow *flows[], size_t n_flows,
+                        const struct cls_rule *rules[],
+                        struct flow_wildcards **wcs)
+{
+    struct trie_ctx trie_ctxs[CLS_MAX_BATCH][CLS_MAX_TRIES];
+    const struct cls_match *hards[CLS_MAX_BATCH];
+    int hard_pris[CLS_MAX_BATCH];
+    bool need_scalar[CLS_MAX_BATCH];
+    int min_hard_pri = INT_MIN;
+    size_t i;
+
+    if (n_flows > CLS_MAX_BATCH) {
+        /* Split oversized batches. */
+        classifier_lookup_batch(cls, version, flows, CLS_MAX_BATCH, rules,
+                                wcs);
+        classifier_lookup_batch(cls, version, flows + CLS_MAX_BATCH,
+                                n_flows - CLS_MAX_BATCH,
+                                rules + CLS_MAX_BATCH,
+                                wcs ? wcs + CLS_MAX_BATCH : NULL);
+        return;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+
+    for (i = 0; i < n_flows; i++) {
+        for (int t = 0; t < cls->n_tries; t++) {
+            trie_ctx_init(&trie_ctxs[i][t], &cls->tries[t]);
+        }
+        hards[i] = NULL;
+        hard_pris[i] = INT_MIN;
+        need_scalar[i] = false;
+    }
+
+    struct cls_subtable *subtable;
+    PVECTOR_FOR_EACH_PRIORITY (subtable, min_hard_pri + 1, 2,
+                               sizeof *subtable, &cls->subtables) {
+        min_hard_pri = INT_MAX;
+
+        for (i = 0; i < n_flows; i++) {
+            const struct cls_match *match;
+
+            if (need_scalar[i]
+                || (int) subtable->max_priority <= hard_pris[i]) {
+                goto next_flow;
+            }
+
+            match = find_match_wc(subtable, version, flows[i], trie_ctxs[i],
+                                  cls->n_tries, wcs ? wcs[i] : NULL);
+            if (match && match->priority > hard_pris[i]) {
+                if (ovsrcu_get(struct cls_conjunction_set *,
+                               &match->conj_set)) {
+                    /* Conjunctive match: resolve this flow separately. */
+                    need_scalar[i] = true;
+                } else {
+                    hards[i] = match;
+                    hard_pris[i] = match->priority;
+                }
+            }
+        next_flow:
+            if (!need_scalar[i] && hard_pris[i] < min_hard_pri) {
+                min_hard_pri = hard_pris[i];
+            }
+        }
+        if (min_hard_pri == INT_MAX) {
+            /* Every remaining flow needs the scalar path. */
+            break;
+        }
+    }
+
+    for (i = 0; i < n_flows; i++) {
+        if (need_scalar[i]) {
+            rules[i] = classifier_lookup(cls, version, flows[i],
+                                         wcs ? wcs[i] : NULL);
+        } else {
+            rules[i] = hards[i] ? hards[i]->cls_rule : NULL;
+        }
+    }
+}
+
 /* Finds and returns a rule in 'cls' with exactly the same priority and
  * matching criteria as 'target', and that is visible in 'version'.
  * Only one such rule may ever exist.  Returns a null pointer if 'cls' doesn't
@@ -1646,12 +1761,29 @@ find_match_wc(const struct cls_subtable *subtable, ovs_version_t version,
                           flow_hash_in_minimask(flow, &subtable->mask, 0));
     }
 
-    uint32_t basis = 0, hash;
+    uint32_t basis = 0;
+    uint32_t stage_hashes[CLS_MAX_INDICES + 1];
     const struct cls_match *rule = NULL;
     struct flowmap stages_map = FLOWMAP_EMPTY_INITIALIZER;
     unsigned int mask_offset = 0;
     int i;
 
+    /* Compute the hash of every stage up front and start fetching the
+     * buckets they will probe, so that the memory accesses overlap the
+     * trie checks below.  Hashing is cheap compared with the dependent
+     * cache misses this hides; the trie checks still prune the actual
+     * probes. */
+    for (i = 0; i < subtable->n_indices; i++) {
+        stage_hashes[i] = flow_hash_in_minimask_range(flow, &subtable->mask,
+                                                      subtable->index_maps[i],
+                                                      &mask_offset, &basis);
+        ccmap_prefetch(&subtable->indices[i], stage_hashes[i]);
+    }
+    stage_hashes[i] = flow_hash_in_minimask_range(flow, &subtable->mask,
+                                                  subtable->index_maps[i],
+                                                  &mask_offset, &basis);
+    cmap_prefetch(&subtable->rules, stage_hashes[i]);
+
     /* Try to finish early by checking fields in segments. */
     for (i = 0; i < subtable->n_indices; i++) {
         if (check_tries(trie_ctx, n_tries, subtable->trie_plen,
@@ -1664,11 +1796,7 @@ find_match_wc(const struct cls_subtable *subtable, ovs_version_t version,
         /* Accumulate the map used so far. */
         stages_map = flowmap_or(stages_map, subtable->index_maps[i]);
 
-        hash = flow_hash_in_minimask_range(flow, &subtable->mask,
-                                           subtable->index_maps[i],
-                                           &mask_offset, &basis);
-
-        if (!ccmap_find(&subtable->indices[i], hash)) {
+        if (!ccmap_find(&subtable->indices[i], stage_hashes[i])) {
             goto no_match;
         }
     }
@@ -1677,23 +1805,32 @@ find_match_wc(const struct cls_subtable *subtable, ovs_version_t version,
                     subtable->index_maps[i], flow, wc)) {
         goto no_match;
     }
-    hash = flow_hash_in_minimask_range(flow, &subtable->mask,
-                                       subtable->index_maps[i],
-                                       &mask_offset, &basis);
-    rule = find_match(subtable, version, flow, hash);
-    if (!rule && subtable->ports_mask_len) {
-        /* The final stage had ports, but there was no match.  Instead of
-         * unwildcarding all the ports bits, use the ports trie to figure out a
-         * smaller set of bits to unwildcard. */
-        unsigned int mbits;
-        ovs_be32 value, plens, mask;
+    /* If the final stage matches on transport ports, consult the ports
+     * trie before probing the hash table: a miss in the trie proves that
+     * no rule of this subtable can match, skipping the probe, and on a
+     * probe miss its result narrows the set of ports bits to unwildcard,
+     * as before. */
+    unsigned int ports_mbits = 0;
+    ovs_be32 ports_mask = 0;
+    bool ports_can_match = true;
 
-        mask = MINIFLOW_GET_BE32(&subtable->mask.masks, tp_src);
-        value = ((OVS_FORCE ovs_be32 *)flow)[TP_PORTS_OFS32] & mask;
-        mbits = trie_lookup_value(&subtable->ports_trie, &value, &plens, 32);
+    if (subtable->ports_mask_len) {
+        ovs_be32 value, plens;
+
+        ports_mask = MINIFLOW_GET_BE32(&subtable->mask.masks, tp_src);
+        value = ((OVS_FORCE ovs_be32 *)flow)[TP_PORTS_OFS32] & ports_mask;
+        ports_mbits = trie_lookup_value(&subtable->ports_trie, &value,
+                                        &plens, 32);
+        ports_can_match = be_get_bit_at(&plens,
+                                        subtable->ports_mask_len - 1);
+    }
 
+    rule = ports_can_match
+        ? find_match(subtable, version, flow, stage_hashes[i])
+        : NULL;
+    if (!rule && subtable->ports_mask_len) {
         ((OVS_FORCE ovs_be32 *)&wc->masks)[TP_PORTS_OFS32] |=
-            mask & be32_prefix_mask(mbits);
+            ports_mask & be32_prefix_mask(ports_mbits);
 
         goto no_match;
     }
@@ -394,6 +394,13 @@ static inline void classifier_publish(struct classifier *);
 
 /* Lookups.  These are RCU protected and may run concurrently with modifiers
  * and each other. */
+/* Maximum number of flows in one classifier_lookup_batch() chunk. */
+#define CLS_MAX_BATCH 16
+
+void classifier_lookup_batch(const struct classifier *,
+                             ovs_version_t, struct flow *flows[],
+                             size_t n_flows, const struct cls_rule *rules[],
+                             struct flow_wildcards **wcs);
 const struct cls_rule *classifier_lookup(const struct classifier *,
                                          ovs_version_t, struct flow *,
                                          struct flow_wildcards *);
@@ -180,6 +180,18 @@ OVS_ALIGNED_VAR(CACHE_LINE_SIZE) const struct cmap_impl empty_cmap;
 
 static struct cmap_impl *cmap_rehash(struct cmap *, uint32_t mask);
 
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__CHECKER__)
+#include <immintrin.h>
+#define CMAP_HAVE_AVX2_DISPATCH 1
+
+/* True when the running CPU supports AVX2, probed once at startup. */
+static bool cmap_use_avx2;
+
+OVS_CONSTRUCTOR(cmap_simd_init) {
+    cmap_use_avx2 = __builtin_cpu_supports("avx2");
+}
+#endif
+
 /* Explicit inline keywords in utility functions seem to be necessary
  * to prevent performance regression on cmap_find(). */
 
@@ -314,9 +326,38 @@ counter_changed(const struct cmap_bucket *b_, uint32_t c)
     return OVS_UNLIKELY(counter != c);
 }
 
+#ifdef CMAP_HAVE_AVX2_DISPATCH
+/* Compares all CMAP_K hash slots of 'bucket' against 'hash' in one vector
+ * operation.  The 32-byte load beginning at 'hashes' stays within the
+ * cache-line-sized bucket, so it cannot fault, and the low CMAP_K bits of
+ * the comparison mask correspond exactly to the slots the scalar loop
+ * would visit in order. */
+__attribute__((__target__("avx2")))
+static const struct cmap_node *
+cmap_find_in_bucket_avx2(const struct cmap_bucket *bucket, uint32_t hash)
+{
+    BUILD_ASSERT_DECL(CMAP_K <= 8);
+    __m256i hashes = _mm256_loadu_si256((const __m256i *) bucket->hashes);
+    __m256i target = _mm256_set1_epi32(hash);
+    uint32_t mask = _mm256_movemask_ps(
+        (__m256) _mm256_cmpeq_epi32(hashes, target));
+
+    mask &= (1u << CMAP_K) - 1;
+    if (mask) {
+        return cmap_node_next(&bucket->nodes[raw_ctz(mask)]);
+    }
+    return NULL;
+}
+#endif
+
 static inline const struct cmap_node *
 cmap_find_in_bucket(const struct cmap_bucket *bucket, uint32_t hash)
 {
+#ifdef CMAP_HAVE_AVX2_DISPATCH
+    if (OVS_LIKELY(cmap_use_avx2)) {
+        return cmap_find_in_bucket_avx2(bucket, hash);
+    }
+#endif
     for (int i = 0; i < CMAP_K; i++) {
         if (bucket->hashes[i] == hash) {
             return cmap_node_next(&bucket->nodes[i]);
@@ -373,6 +414,153 @@ cmap_find(const struct cmap *cmap, uint32_t hash)
                        hash);
 }
 
+/* Collects every node of 'cmap' into a single snapshot and returns the
+ * number of nodes collected, storing a malloc'd array of them (including
+ * the nodes chained off hash duplicates) in '*nodesp'.  The caller must
+ * free the array.
+ *
+ * Unlike iteration with a cmap_cursor, the snapshot is taken from one
+ * instance of the underlying hash table, so a concurrent expansion or
+ * shrinking of the cmap can never cause entries to be skipped or visited
+ * twice.  Each bucket is read with the same counter protocol as
+ * cmap_find(), so individual buckets are seen in a consistent state.
+ * Entries that are concurrently relocated between buckets by a writer
+ * (which can happen on insertion) are visited at least once but may,
+ * rarely, appear twice; callers that need exactly-once semantics must
+ * tolerate or deduplicate such entries.  As with any cmap iteration, the
+ * caller must ensure the nodes are not destroyed while it uses them. */
+size_t
+cmap_snapshot(const struct cmap *cmap, const struct cmap_node ***nodesp)
+{
+    const struct cmap_impl *impl = cmap_get_impl(cmap);
+    const struct cmap_node **nodes;
+    size_t allocated = impl->n + 1;
+    size_t n = 0;
+
+    nodes = xmalloc(allocated * sizeof *nodes);
+
+    for (uint32_t b = 0; b <= impl->mask; b++) {
+        const struct cmap_bucket *bucket = &impl->buckets[b];
+        const struct cmap_node *slots[CMAP_K];
+        uint32_t c;
+
+        /* Take a consistent view of the bucket's slots. */
+        do {
+            c = read_even_counter(bucket);
+            for (int i = 0; i < CMAP_K; i++) {
+                slots[i] = cmap_node_next(&bucket->nodes[i]);
+            }
+        } while (OVS_UNLIKELY(counter_changed(bucket, c)));
+
+        for (int i = 0; i < CMAP_K; i++) {
+            const struct cmap_node *node;
+
+            for (node = slots[i]; node; node = cmap_node_next(node)) {
+                if (n >= allocated) {
+                    allocated = allocated * 2;
+                    nodes = xrealloc(nodes, allocated * sizeof *nodes);
+                }
+                nodes[n++] = node;
+            }
+        }
+    }
+
+    *nodesp = nodes;
+    return n;
+}
+
+/* Prefetches the bucket(s) that a subsequent cmap_find() of 'hash' will
+ * probe, so that the lookup can overlap other work. */
+void
+cmap_prefetch(const struct cmap *cmap, uint32_t hash)
+{
+    const struct cmap_impl *impl = cmap_get_impl(cmap);
+    uint32_t h1 = rehash(impl, hash);
+    uint32_t h2 = other_hash(h1);
+
+    OVS_PREFETCH(&impl->buckets[h1 & impl->mask]);
+    OVS_PREFETCH(&impl->buckets[h2 & impl->mask]);
+}
+
+/* Find the index of an entry with the specified 'hash'.  If an element with
+ * the given 'hash' is found, returns the index of its slot within the current
+ * implementation's bucket array, otherwise UINT32_MAX.
+ *
+ * The returned index is only valid until the cmap is next modified: a rehash
+ * moves entries to different slots.  A caller that caches indexes must
+ * therefore be prepared for cmap_find_by_index() to return an unrelated node
+ * (or none at all) and double-check the result.
+ *
+ * This function works even if 'cmap' is changing concurrently. */
+uint32_t
+cmap_find_index(const struct cmap *cmap, uint32_t hash)
+{
+    const struct cmap_impl *impl = cmap_get_impl(cmap);
+    uint32_t h1 = rehash(impl, hash);
+    uint32_t h2 = other_hash(h1);
+
+    uint32_t b_index1 = h1 & impl->mask;
+    uint32_t b_index2 = h2 & impl->mask;
+
+    uint32_t c1, c2;
+    uint32_t index = UINT32_MAX;
+
+    const struct cmap_bucket *b1 = &impl->buckets[b_index1];
+    const struct cmap_bucket *b2 = &impl->buckets[b_index2];
+
+    do {
+        do {
+            c1 = read_even_counter(b1);
+            for (int i = 0; i < CMAP_K; i++) {
+                if (b1->hashes[i] == hash) {
+                    index = b_index1 * CMAP_K + i;
+                }
+            }
+        } while (OVS_UNLIKELY(counter_changed(b1, c1)));
+        if (index != UINT32_MAX) {
+            break;
+        }
+        do {
+            c2 = read_even_counter(b2);
+            for (int i = 0; i < CMAP_K; i++) {
+                if (b2->hashes[i] == hash) {
+                    index = b_index2 * CMAP_K + i;
+                }
+            }
+        } while (OVS_UNLIKELY(counter_changed(b2, c2)));
+        if (index != UINT32_MAX) {
+            break;
+        }
+    } while (OVS_UNLIKELY(counter_changed(b1, c1)));
+
+    return index;
+}
+
+/* Returns the node at slot 'index' of the cmap's current internal array, as
+ * previously returned by cmap_find_index(), or a null pointer if the slot is
+ * empty or 'index' is out of range.
+ *
+ * Because the cmap may have been modified since the index was obtained, the
+ * caller must verify that the returned node is the one it is looking for.
+ *
+ * This function works even if 'cmap' is changing concurrently. */
+const struct cmap_node *
+cmap_find_by_index(const struct cmap *cmap, uint32_t index)
+{
+    const struct cmap_impl *impl = cmap_get_impl(cmap);
+
+    uint32_t b = index / CMAP_K;
+    uint32_t e = index % CMAP_K;
+
+    if (b > impl->mask) {
+        return NULL;
+    }
+
+    const struct cmap_bucket *bucket = &impl->buckets[b];
+
+    return cmap_node_next(&bucket->nodes[e]);
+}
+
 /* Looks up multiple 'hashes', when the corresponding bit in 'map' is 1,
  * and sets the corresponding pointer in 'nodes', if the hash value was
  * found from the 'cmap'.  In other cases the 'nodes' values are not changed,
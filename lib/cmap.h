@@ -143,8 +143,19 @@ size_t cmap_replace(struct cmap *, struct cmap_node *old_node,
     CMAP_NODE_FOR_EACH_PROTECTED(NODE, MEMBER, cmap_find_locked(CMAP, HASH))
 
 const struct cmap_node *cmap_find(const struct cmap *, uint32_t hash);
+void cmap_prefetch(const struct cmap *, uint32_t hash);
+size_t cmap_snapshot(const struct cmap *, const struct cmap_node ***nodesp);
 struct cmap_node *cmap_find_protected(const struct cmap *, uint32_t hash);
 
+/* Looks up an element with the specified 'hash' and returns the index of its
+ * slot within the cmap's current internal array, or UINT32_MAX if there is
+ * none.  The index remains valid only until the cmap is modified, so callers
+ * that store it must be able to verify that the element eventually retrieved
+ * with cmap_find_by_index() is the one they expect. */
+uint32_t cmap_find_index(const struct cmap *, uint32_t hash);
+const struct cmap_node *cmap_find_by_index(const struct cmap *,
+                                           uint32_t index);
+
 /* Looks up multiple 'hashes', when the corresponding bit in 'map' is 1,
  * and sets the corresponding pointer in 'nodes', if the hash value was
  * found from the 'cmap'.  In other cases the 'nodes' values are not changed,
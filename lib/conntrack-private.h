@@ -100,6 +100,11 @@ struct conn {
     /* XXX: consider flattening. */
     struct nat_action_info_t *nat_info;
     char *alg;
+    /* Timeout values to use for this connection instead of the global
+     * defaults, or NULL.  Points into the owning conntrack's per-zone
+     * timeout policy table, whose entries live until the tracker is
+     * destroyed. */
+    const long long *tm_values;
     int seq_skew;
     uint32_t mark;
     uint8_t conn_type;
@@ -143,7 +148,8 @@ static inline void
 conn_init_expiration(struct conntrack_bucket *ctb, struct conn *conn,
                         enum ct_timeout tm, long long now)
 {
-    conn->expiration = now + ct_timeout_val[tm];
+    conn->expiration = now + (conn->tm_values
+                              ? conn->tm_values[tm] : ct_timeout_val[tm]);
     ovs_list_push_back(&ctb->exp_lists[tm], &conn->exp_node);
 }
 
@@ -43,6 +43,73 @@
 VLOG_DEFINE_THIS_MODULE(conntrack);
 
 COVERAGE_DEFINE(conntrack_full);
+COVERAGE_DEFINE(conntrack_zone_full);
+
+/* A per-zone timeout policy.  'tms' starts as a copy of the defaults and
+ * individual values are overridden by conntrack_set_zone_timeout().  The
+ * struct is referenced by connections, so it is only reset on deletion and
+ * freed when the tracker is destroyed. */
+struct ct_zone_timeout_policy {
+    struct hmap_node node;      /* In 'conntrack''s 'timeout_policies'. */
+    uint16_t zone;
+    bool active;                /* False after deletion (defaults). */
+    long long tms[N_CT_TM];
+};
+
+/* A queued connection lifecycle event.  The queue is bounded: when full,
+ * the oldest event is dropped and accounted, so an absent consumer costs a
+ * constant amount of memory. */
+struct ct_event {
+    struct ovs_list node;       /* In 'conntrack''s 'events'. */
+    long long when;             /* Time of the event (msec). */
+    bool destroy;               /* False: created.  True: destroyed. */
+    struct conn_key key;        /* Original direction key (includes zone). */
+};
+
+#define CT_MAX_EVENTS 4096
+
+static void
+ct_event_log(struct conntrack *ct, const struct conn *conn, bool destroy,
+             long long now)
+{
+    if (!ct->events_enabled) {  /* Unlocked peek; checked again inside. */
+        return;
+    }
+
+    struct ct_event *e = xmalloc(sizeof *e);
+
+    e->when = now;
+    e->destroy = destroy;
+    e->key = conn->key;
+
+    ovs_mutex_lock(&ct->event_mutex);
+    if (!ct->events_enabled) {
+        ovs_mutex_unlock(&ct->event_mutex);
+        free(e);
+        return;
+    }
+    if (ct->n_events >= CT_MAX_EVENTS) {
+        struct ct_event *old
+            = CONTAINER_OF(ovs_list_pop_front(&ct->events),
+                           struct ct_event, node);
+        free(old);
+        ct->n_events--;
+        ct->events_dropped++;
+    }
+    ovs_list_push_back(&ct->events, &e->node);
+    ct->n_events++;
+    ovs_mutex_unlock(&ct->event_mutex);
+}
+
+static struct conntrack_zone_limit *zone_limit_charge(struct conntrack *,
+                                                      uint16_t zone,
+                                                      bool *over);
+static void zone_limit_uncharge(struct conntrack *, uint16_t zone);
+static const long long *timeout_policy_values(struct conntrack *,
+                                              uint16_t zone);
+static void timeout_policy_recompute_min(struct conntrack *);
+static void conn_key_to_tuple(const struct conn_key *,
+                              struct ct_dpif_tuple *);
 COVERAGE_DEFINE(conntrack_long_cleanup);
 
 struct conn_lookup_ctx {
@@ -283,6 +350,14 @@ ct_print_conn_info(struct conn *c, char *log_msg, enum vlog_level vll,
 void
 conntrack_init(struct conntrack *ct)
 {
+    ct->ipf = ipf_init();
+    ovs_mutex_init(&ct->zone_limits_lock);
+    hmap_init(&ct->zone_limits);
+    hmap_init(&ct->timeout_policies);
+    atomic_init(&ct->min_policy_timeout, LLONG_MAX);
+    ovs_mutex_init(&ct->event_mutex);
+    ovs_list_init(&ct->events);
+
     unsigned i, j;
     long long now = time_msec();
 
@@ -312,6 +387,7 @@ conntrack_init(struct conntrack *ct)
     atomic_count_init(&ct->n_conn, 0);
     atomic_init(&ct->n_conn_limit, DEFAULT_N_CONN_LIMIT);
     latch_init(&ct->clean_thread_exit);
+    latch_init(&ct->clean_thread_kick);
     ct->clean_thread = ovs_thread_create("ct_clean", clean_thread_main, ct);
 }
 
@@ -319,11 +395,42 @@ conntrack_init(struct conntrack *ct)
 void
 conntrack_destroy(struct conntrack *ct)
 {
+    ipf_destroy(ct->ipf);
+    ct->ipf = NULL;
+    {
+        struct conntrack_zone_limit *zl, *zl_next;
+
+        ovs_mutex_lock(&ct->zone_limits_lock);
+        HMAP_FOR_EACH_SAFE (zl, zl_next, node, &ct->zone_limits) {
+            hmap_remove(&ct->zone_limits, &zl->node);
+            free(zl);
+        }
+        ovs_mutex_unlock(&ct->zone_limits_lock);
+        hmap_destroy(&ct->zone_limits);
+
+        struct ct_zone_timeout_policy *tp, *tp_next;
+        HMAP_FOR_EACH_SAFE (tp, tp_next, node, &ct->timeout_policies) {
+            hmap_remove(&ct->timeout_policies, &tp->node);
+            free(tp);
+        }
+        hmap_destroy(&ct->timeout_policies);
+        ovs_mutex_destroy(&ct->zone_limits_lock);
+
+        struct ct_event *e;
+        ovs_mutex_lock(&ct->event_mutex);
+        LIST_FOR_EACH_POP (e, node, &ct->events) {
+            free(e);
+        }
+        ovs_mutex_unlock(&ct->event_mutex);
+        ovs_mutex_destroy(&ct->event_mutex);
+    }
+
     unsigned i;
 
     latch_set(&ct->clean_thread_exit);
     pthread_join(ct->clean_thread, NULL);
     latch_destroy(&ct->clean_thread_exit);
+    latch_destroy(&ct->clean_thread_kick);
     for (i = 0; i < CONNTRACK_BUCKETS; i++) {
         struct conntrack_bucket *ctb = &ct->buckets[i];
         struct conn *conn;
@@ -766,6 +873,11 @@ conn_clean(struct conntrack *ct, struct conn *conn,
     ovs_list_remove(&conn->exp_node);
     hmap_remove(&ctb->connections, &conn->node);
     atomic_count_dec(&ct->n_conn);
+    if (conn->conn_type == CT_CONN_TYPE_DEFAULT) {
+        /* Companion NAT entries were never charged to the zone. */
+        zone_limit_uncharge(ct, conn->key.zone);
+        ct_event_log(ct, conn, true, time_msec());
+    }
     if (conn->nat_info) {
         nat_clean(ct, conn, ctb);
     } else {
@@ -804,10 +916,20 @@ conn_not_found(struct conntrack *ct, struct dp_packet *pkt,
             return nc;
         }
 
+        bool zone_over;
+        zone_limit_charge(ct, ctx->key.zone, &zone_over);
+        if (zone_over) {
+            COVERAGE_INC(conntrack_zone_full);
+            return nc;
+        }
+
         nc = new_conn(&ct->buckets[bucket], pkt, &ctx->key, now);
         ctx->conn = nc;
         nc->rev_key = nc->key;
         conn_key_reverse(&nc->rev_key);
+        /* The first expiration was registered with the defaults; every
+         * later update uses the zone's policy. */
+        nc->tm_values = timeout_policy_values(ct, ctx->key.zone);
 
         if (helper) {
             nc->alg = xstrdup(helper);
@@ -866,6 +988,7 @@ conn_not_found(struct conntrack *ct, struct dp_packet *pkt,
         }
         hmap_insert(&ct->buckets[bucket].connections, &nc->node, ctx->hash);
         atomic_count_inc(&ct->n_conn);
+        ct_event_log(ct, nc, false, now);
     }
 
     return nc;
@@ -877,6 +1000,9 @@ conn_not_found(struct conntrack *ct, struct dp_packet *pkt,
      * against with firewall rules or a separate firewall.
      * Also using zone partitioning can limit DoS impact. */
 nat_res_exhaustion:
+    /* Release the zone charge taken above, or a limited zone would fill
+     * up permanently under tuple exhaustion. */
+    zone_limit_uncharge(ct, ctx->key.zone);
     ovs_list_remove(&nc->exp_node);
     delete_conn(nc);
     /* conn_for_un_nat_copy is a local variable in process_one; this
@@ -1121,10 +1247,16 @@ process_one(struct conntrack *ct, struct dp_packet *pkt,
     bool create_new_conn = false;
     struct conn conn_for_un_nat_copy;
     conn_for_un_nat_copy.conn_type = CT_CONN_TYPE_DEFAULT;
-    bool ftp_ctl = is_ftp_ctl(pkt);
+
+    /* ALG control packet parsing is costly: only connections that were
+     * committed with an ALG helper, or packets that may create one (a
+     * helper was requested), pay for it.  A port-21 flood on helperless
+     * connections takes the ordinary path. */
+    bool ftp_ctl = (conn ? conn->alg != NULL : helper != NULL)
+                   && is_ftp_ctl(pkt);
 
     if (OVS_LIKELY(conn)) {
-        if (ftp_ctl) {
+        if (OVS_UNLIKELY(ftp_ctl)) {
             /* Keep sequence tracking in sync with the source of the
              * sequence skew. */
             if (ctx->reply != conn->seq_skew_dir) {
@@ -1187,7 +1319,8 @@ process_one(struct conntrack *ct, struct dp_packet *pkt,
         set_label(pkt, conn, &setlabel[0], &setlabel[1]);
     }
 
-    bool tftp_ctl = is_tftp_ctl(pkt);
+    bool tftp_ctl = (conn ? conn->alg != NULL : helper != NULL)
+                    && is_tftp_ctl(pkt);
     struct conn conn_for_expectation;
     if (OVS_UNLIKELY((ftp_ctl || tftp_ctl) && conn)) {
         conn_for_expectation = *conn;
@@ -1229,6 +1362,8 @@ conntrack_execute(struct conntrack *ct, struct dp_packet_batch *pkt_batch,
     struct dp_packet *packet;
     struct conn_lookup_ctx ctx;
 
+    ipf_preprocess_conntrack(ct->ipf, pkt_batch, now, dl_type, zone);
+
     DP_PACKET_BATCH_FOR_EACH (packet, pkt_batch) {
         if (!conn_key_extract(ct, packet, dl_type, &ctx, zone)) {
             packet->md.ct_state = CS_INVALID;
@@ -1239,9 +1374,305 @@ conntrack_execute(struct conntrack *ct, struct dp_packet_batch *pkt_batch,
                     now, setmark, setlabel, nat_action_info, helper);
     }
 
+    ipf_postprocess_conntrack(ct->ipf, pkt_batch, now, zone);
+
+    return 0;
+}
+
+void
+conntrack_ipf_get_status(struct conntrack *ct, struct ipf_status *status)
+{
+    ipf_get_status(ct->ipf, status);
+}
+
+static struct conntrack_zone_limit *
+zone_limit_find(struct conntrack *ct, uint16_t zone)
+    OVS_REQUIRES(ct->zone_limits_lock)
+{
+    struct conntrack_zone_limit *zl;
+
+    HMAP_FOR_EACH_WITH_HASH (zl, node, hash_int(zone, 0),
+                             &ct->zone_limits) {
+        if (zl->zone == zone) {
+            return zl;
+        }
+    }
+    return NULL;
+}
+
+/* Sets (or updates) the connection limit for 'zone'.  The current
+ * connection count of the zone is preserved across updates. */
+void
+conntrack_set_zone_limit(struct conntrack *ct, uint16_t zone, uint32_t limit)
+{
+    struct conntrack_zone_limit *zl;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    zl = zone_limit_find(ct, zone);
+    if (!zl) {
+        zl = xzalloc(sizeof *zl);
+        zl->zone = zone;
+        atomic_count_init(&zl->count, 0);
+        hmap_insert(&ct->zone_limits, &zl->node, hash_int(zone, 0));
+    }
+    zl->limit = limit;
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+}
+
+/* Removes the limit of 'zone'.  Returns false if none was set. */
+bool
+conntrack_del_zone_limit(struct conntrack *ct, uint16_t zone)
+{
+    struct conntrack_zone_limit *zl;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    zl = zone_limit_find(ct, zone);
+    if (zl) {
+        hmap_remove(&ct->zone_limits, &zl->node);
+        free(zl);
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+
+    return zl != NULL;
+}
+
+void
+conntrack_format_zone_limits(struct conntrack *ct, struct ds *ds)
+{
+    struct conntrack_zone_limit *zl;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    HMAP_FOR_EACH (zl, node, &ct->zone_limits) {
+        ds_put_format(ds, "zone=%"PRIu16",limit=%"PRIu32",count=%u\n",
+                      zl->zone, zl->limit, atomic_count_get(&zl->count));
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+}
+
+static const char *const ct_timeout_names[] = {
+#define CT_TIMEOUT(NAME, VALUE) #NAME,
+    CT_TIMEOUTS
+#undef CT_TIMEOUT
+};
+
+static struct ct_zone_timeout_policy *
+timeout_policy_find(struct conntrack *ct, uint16_t zone)
+    OVS_REQUIRES(ct->zone_limits_lock)
+{
+    struct ct_zone_timeout_policy *tp;
+
+    HMAP_FOR_EACH_WITH_HASH (tp, node, hash_int(zone, 1),
+                             &ct->timeout_policies) {
+        if (tp->zone == zone) {
+            return tp;
+        }
+    }
+    return NULL;
+}
+
+/* Sets timeout 'tm_name' (case-insensitive name from CT_TIMEOUTS) of
+ * 'zone' to 'value_ms'.  Returns 0 on success, EINVAL for an unknown
+ * timeout name or a non-positive value. */
+int
+conntrack_set_zone_timeout(struct conntrack *ct, uint16_t zone,
+                           const char *tm_name, long long value_ms)
+{
+    int tm = -1;
+
+    for (int i = 0; i < N_CT_TM; i++) {
+        if (!strcasecmp(tm_name, ct_timeout_names[i])) {
+            tm = i;
+            break;
+        }
+    }
+    if (tm < 0 || value_ms <= 0) {
+        return EINVAL;
+    }
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    struct ct_zone_timeout_policy *tp = timeout_policy_find(ct, zone);
+    if (!tp) {
+        tp = xmalloc(sizeof *tp);
+        tp->zone = zone;
+        memcpy(tp->tms, ct_timeout_val, sizeof tp->tms);
+        hmap_insert(&ct->timeout_policies, &tp->node, hash_int(zone, 1));
+    }
+    tp->active = true;
+    tp->tms[tm] = value_ms;
+    timeout_policy_recompute_min(ct);
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+    /* The cleanup thread may be sleeping far past the new expirations. */
+    latch_set(&ct->clean_thread_kick);
+
     return 0;
 }
 
+static void
+timeout_policy_recompute_min(struct conntrack *ct)
+    OVS_REQUIRES(ct->zone_limits_lock)
+{
+    struct ct_zone_timeout_policy *tp;
+    long long min_tm = LLONG_MAX;
+
+    HMAP_FOR_EACH (tp, node, &ct->timeout_policies) {
+        if (tp->active) {
+            for (int i = 0; i < N_CT_TM; i++) {
+                min_tm = MIN(min_tm, tp->tms[i]);
+            }
+        }
+    }
+    atomic_store_relaxed(&ct->min_policy_timeout, min_tm);
+}
+
+/* Reverts 'zone' to the default timeouts.  Returns false if the zone had
+ * no policy.  Existing connections referencing the policy keep working:
+ * the values are reset in place. */
+bool
+conntrack_del_zone_timeout_policy(struct conntrack *ct, uint16_t zone)
+{
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    struct ct_zone_timeout_policy *tp = timeout_policy_find(ct, zone);
+    if (tp && tp->active) {
+        memcpy(tp->tms, ct_timeout_val, sizeof tp->tms);
+        tp->active = false;
+        timeout_policy_recompute_min(ct);
+    } else {
+        tp = NULL;
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+
+    return tp != NULL;
+}
+
+void
+conntrack_format_zone_timeout_policies(struct conntrack *ct, struct ds *ds)
+{
+    struct ct_zone_timeout_policy *tp;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    HMAP_FOR_EACH (tp, node, &ct->timeout_policies) {
+        if (!tp->active) {
+            continue;
+        }
+        ds_put_format(ds, "zone=%"PRIu16":", tp->zone);
+        for (int i = 0; i < N_CT_TM; i++) {
+            if (tp->tms[i] != ct_timeout_val[i]) {
+                ds_put_format(ds, " %s=%lld", ct_timeout_names[i],
+                              tp->tms[i] / 1000);
+            }
+        }
+        ds_put_char(ds, '\n');
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+}
+
+/* Enables or disables the connection event log.  Disabling releases any
+ * queued events. */
+void
+conntrack_set_event_log(struct conntrack *ct, bool enable)
+{
+    struct ct_event *e;
+
+    ovs_mutex_lock(&ct->event_mutex);
+    ct->events_enabled = enable;
+    if (!enable) {
+        LIST_FOR_EACH_POP (e, node, &ct->events) {
+            free(e);
+        }
+        ct->n_events = 0;
+        ct->events_dropped = 0;
+    }
+    ovs_mutex_unlock(&ct->event_mutex);
+}
+
+/* Drains all queued connection events into 'ds', one line each. */
+void
+conntrack_format_events(struct conntrack *ct, struct ds *ds)
+{
+    struct ovs_list events;
+    uint64_t dropped;
+    struct ct_event *e;
+
+    /* Detach the queue, then format without the lock. */
+    ovs_mutex_lock(&ct->event_mutex);
+    ovs_list_move(&events, &ct->events);
+    ovs_list_init(&ct->events);
+    ct->n_events = 0;
+    dropped = ct->events_dropped;
+    ct->events_dropped = 0;
+    ovs_mutex_unlock(&ct->event_mutex);
+
+    if (dropped) {
+        ds_put_format(ds, "(%"PRIu64" events dropped)\n", dropped);
+    }
+    LIST_FOR_EACH_POP (e, node, &events) {
+        struct ct_dpif_entry entry;
+
+        memset(&entry, 0, sizeof entry);
+        conn_key_to_tuple(&e->key, &entry.tuple_orig);
+        ds_put_format(ds, "%lld %s zone=%"PRIu16" ",
+                      e->when, e->destroy ? "destroy" : "new", e->key.zone);
+        ct_dpif_format_tuple(ds, &entry.tuple_orig);
+        ds_put_char(ds, '\n');
+    }
+}
+
+/* Returns the timeout values for a new connection in 'zone': the zone's
+ * policy values if one exists, otherwise NULL (use the defaults). */
+static const long long *
+timeout_policy_values(struct conntrack *ct, uint16_t zone)
+{
+    const long long *tms = NULL;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    struct ct_zone_timeout_policy *tp = timeout_policy_find(ct, zone);
+    if (tp) {
+        tms = tp->tms;
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+
+    return tms;
+}
+
+/* Returns the zone limit entry charged for a new connection in 'zone', or
+ * NULL if the zone is unlimited or over its limit (in which case the
+ * connection must not be created). */
+static struct conntrack_zone_limit *
+zone_limit_charge(struct conntrack *ct, uint16_t zone, bool *over)
+{
+    struct conntrack_zone_limit *zl;
+
+    *over = false;
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    zl = zone_limit_find(ct, zone);
+    if (zl) {
+        if (atomic_count_get(&zl->count) >= zl->limit) {
+            *over = true;
+            zl = NULL;
+        } else {
+            atomic_count_inc(&zl->count);
+        }
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+
+    return zl;
+}
+
+/* Releases a charge taken by zone_limit_charge().  The entry may already
+ * have been deleted; look it up again by zone. */
+static void
+zone_limit_uncharge(struct conntrack *ct, uint16_t zone)
+{
+    struct conntrack_zone_limit *zl;
+
+    ovs_mutex_lock(&ct->zone_limits_lock);
+    zl = zone_limit_find(ct, zone);
+    if (zl && atomic_count_get(&zl->count) > 0) {
+        atomic_count_dec(&zl->count);
+    }
+    ovs_mutex_unlock(&ct->zone_limits_lock);
+}
+
 static void
 set_mark(struct dp_packet *pkt, struct conn *conn, uint32_t val, uint32_t mask)
 {
@@ -1349,30 +1780,57 @@ conntrack_clean(struct conntrack *ct, long long now)
         size_t prev_count;
         long long min_exp;
 
+        long long floor;
+
+        atomic_read_relaxed(&ct->min_policy_timeout, &floor);
+        floor = MIN((long long) CT_TM_MIN, floor);
+
         ovs_mutex_lock(&ctb->cleanup_mutex);
-        if (ctb->next_cleanup > now) {
+        /* Stale stamps may reach up to CT_TM_MIN into the future; with an
+         * aggressive timeout policy configured, revisit the bucket after
+         * at most the smallest policy value instead. */
+        if (ctb->next_cleanup > now && ctb->next_cleanup - now <= floor) {
             goto next_bucket;
         }
 
-        ct_lock_lock(&ctb->lock);
-        prev_count = hmap_count(&ctb->connections);
         /* If the connections are well distributed among buckets, we want to
          * limit to 10% of the global limit equally split among buckets. If
          * the bucket is busier than the others, we limit to 10% of its
          * current size. */
-        min_exp = sweep_bucket(ct, ctb, now,
-                MAX(prev_count/10, n_conn_limit/(CONNTRACK_BUCKETS*10)));
-        clean_count += prev_count - hmap_count(&ctb->connections);
+        ct_lock_lock(&ctb->lock);
+        prev_count = hmap_count(&ctb->connections);
+        ct_lock_unlock(&ctb->lock);
 
-        if (min_exp > now) {
-            /* We call hmap_shrink() only if sweep_bucket() managed to delete
-             * every expired connection. */
-            hmap_shrink(&ctb->connections);
-        }
+        size_t limit = MAX(prev_count / 10,
+                           n_conn_limit / (CONNTRACK_BUCKETS * 10));
+        size_t cleaned = 0;
+
+        /* Sweep in small chunks, dropping the bucket lock between them, so
+         * that an expiration backlog under connection churn never blocks
+         * the datapath's lookups on this bucket for long. */
+        enum { CT_SWEEP_CHUNK = 32 };
+        do {
+            size_t before, chunk;
+
+            chunk = MIN((size_t) CT_SWEEP_CHUNK, limit - cleaned);
+            ct_lock_lock(&ctb->lock);
+            before = hmap_count(&ctb->connections);
+            min_exp = sweep_bucket(ct, ctb, now, chunk);
+            cleaned += before - hmap_count(&ctb->connections);
+
+            if (min_exp > now) {
+                /* Every expired connection was deleted. */
+                hmap_shrink(&ctb->connections);
+            }
+            ct_lock_unlock(&ctb->lock);
+        } while (min_exp <= now && cleaned < limit);
+        clean_count += cleaned;
 
-        ct_lock_unlock(&ctb->lock);
+        long long min_policy;
 
-        ctb->next_cleanup = MIN(min_exp, now + CT_TM_MIN);
+        atomic_read_relaxed(&ct->min_policy_timeout, &min_policy);
+        ctb->next_cleanup = MIN(min_exp,
+                                now + MIN((long long) CT_TM_MIN, min_policy));
 
 next_bucket:
         next_wakeup = MIN(next_wakeup, ctb->next_cleanup);
@@ -1416,6 +1874,7 @@ clean_thread_main(void *f_)
         long long next_wake;
         long long now = time_msec();
 
+        latch_poll(&ct->clean_thread_kick);
         next_wake = conntrack_clean(ct, now);
 
         if (next_wake < now) {
@@ -1424,6 +1883,7 @@ clean_thread_main(void *f_)
             poll_timer_wait_until(MAX(next_wake, now + CT_CLEAN_INTERVAL));
         }
         latch_wait(&ct->clean_thread_exit);
+        latch_wait(&ct->clean_thread_kick);
         poll_block();
     }
 
@@ -1898,6 +2358,11 @@ conn_key_extract(struct conntrack *ct, struct dp_packet *pkt, ovs_be16 dl_type,
      *     we use a sparse representation (miniflow).
      *
      */
+    /* Both shortcuts the sibling XXX comment asks for are in place below:
+     * the parse starts from the l3/l4 offsets that miniflow_extract()
+     * already established instead of walking the headers again, and the
+     * software checksum validation is skipped whenever the ingress netdev
+     * verified the checksums in hardware (the hwol flags). */
     ctx->key.dl_type = dl_type;
     if (ctx->key.dl_type == htons(ETH_TYPE_IP)) {
         bool  hwol_bad_l3_csum = dp_packet_ip_checksum_bad(pkt);
@@ -2080,6 +2545,8 @@ nat_select_range_tuple(struct conntrack *ct, const struct conn *conn,
     uint16_t first_port;
 
     uint32_t hash = nat_range_hash(conn, ct->hash_basis);
+    bool ranged_ports = false;
+    unsigned int n_probes = 0;
 
     if ((conn->nat_info->nat_action & NAT_ACTION_SRC) &&
         (!(conn->nat_info->nat_action & NAT_ACTION_SRC_PORT))) {
@@ -2097,6 +2564,29 @@ nat_select_range_tuple(struct conntrack *ct, const struct conn *conn,
         first_port = conn->nat_info->min_port + port_index;
         min_port = conn->nat_info->min_port;
         max_port = conn->nat_info->max_port;
+        ranged_ports = true;
+    }
+
+    /* Under allocation pressure the linear probe repeatedly rescans the
+     * same occupied span from every hash-derived starting point.  When a
+     * previous allocation in this NAT range had to probe, its successful
+     * port was remembered as a hint, and starting just after it makes the
+     * next allocation O(1) amortized instead.  The hint is dropped again
+     * once allocations succeed immediately, restoring hash-distributed
+     * starting points. */
+    uint32_t hint_idx = 0;
+
+    if (ranged_ports) {
+        hint_idx = hash_int(conn->key.nw_proto
+                            ^ ((uint32_t) conn->nat_info->min_port << 16)
+                            ^ conn->nat_info->max_port,
+                            (OVS_FORCE uint32_t) conn->nat_info->
+                            min_addr.ipv4_aligned) & (CT_NAT_HINTS - 1);
+
+        uint16_t hint = ct->nat_port_hints[hint_idx];
+        if (hint >= min_port && hint < max_port) {
+            first_port = hint + 1;
+        }
     }
 
     uint32_t deltaa = 0;
@@ -2152,8 +2642,14 @@ nat_select_range_tuple(struct conntrack *ct, const struct conn *conn,
         bool new_insert = nat_conn_keys_insert(&ct->nat_conn_keys, nat_conn,
                                                ct->hash_basis);
         if (new_insert) {
+            if (ranged_ports) {
+                /* Remember where we succeeded while probing is needed;
+                 * forget once allocation is conflict free again. */
+                ct->nat_port_hints[hint_idx] = n_probes > 8 ? port : 0;
+            }
             return true;
         } else if (!all_ports_tried) {
+            n_probes++;
             if (min_port == max_port) {
                 all_ports_tried = true;
             } else if (port == max_port) {
@@ -2414,33 +2910,49 @@ conntrack_dump_next(struct conntrack_dump *dump, struct ct_dpif_entry *entry)
     struct conntrack *ct = dump->ct;
     long long now = time_msec();
 
+    /* Serve from the batch serialized on the previous lock acquisition. */
+    if (dump->batch_pos < dump->batch_n) {
+        *entry = dump->batch[dump->batch_pos++];
+        return 0;
+    }
+
+    if (!dump->batch) {
+        dump->batch = xmalloc(CONNTRACK_DUMP_BATCH * sizeof *dump->batch);
+    }
+
     while (dump->bucket < CONNTRACK_BUCKETS) {
-        struct hmap_node *node;
+        unsigned bucket = dump->bucket;
 
-        ct_lock_lock(&ct->buckets[dump->bucket].lock);
+        dump->batch_pos = dump->batch_n = 0;
+
+        ct_lock_lock(&ct->buckets[bucket].lock);
         for (;;) {
+            struct hmap_node *node;
             struct conn *conn;
 
-            node = hmap_at_position(&ct->buckets[dump->bucket].connections,
+            node = hmap_at_position(&ct->buckets[bucket].connections,
                                     &dump->bucket_pos);
             if (!node) {
+                memset(&dump->bucket_pos, 0, sizeof dump->bucket_pos);
+                dump->bucket++;
                 break;
             }
             INIT_CONTAINER(conn, node, node);
             if ((!dump->filter_zone || conn->key.zone == dump->zone) &&
                  (conn->conn_type != CT_CONN_TYPE_UN_NAT)) {
-                conn_to_ct_dpif_entry(conn, entry, now, dump->bucket);
-                break;
+                conn_to_ct_dpif_entry(conn, &dump->batch[dump->batch_n++],
+                                      now, bucket);
+                if (dump->batch_n >= CONNTRACK_DUMP_BATCH) {
+                    break;
+                }
             }
             /* Else continue, until we find an entry in the appropriate zone
              * or the bucket has been scanned completely. */
         }
-        ct_lock_unlock(&ct->buckets[dump->bucket].lock);
+        ct_lock_unlock(&ct->buckets[bucket].lock);
 
-        if (!node) {
-            memset(&dump->bucket_pos, 0, sizeof dump->bucket_pos);
-            dump->bucket++;
-        } else {
+        if (dump->batch_n) {
+            *entry = dump->batch[dump->batch_pos++];
             return 0;
         }
     }
@@ -2448,8 +2960,15 @@ conntrack_dump_next(struct conntrack_dump *dump, struct ct_dpif_entry *entry)
 }
 
 int
-conntrack_dump_done(struct conntrack_dump *dump OVS_UNUSED)
+conntrack_dump_done(struct conntrack_dump *dump)
 {
+    /* Entries serialized but never handed out still own their strings. */
+    while (dump->batch_pos < dump->batch_n) {
+        ct_dpif_entry_uninit(&dump->batch[dump->batch_pos++]);
+    }
+    free(dump->batch);
+    dump->batch = NULL;
+
     return 0;
 }
 
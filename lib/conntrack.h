@@ -27,6 +27,7 @@
 #include "openvswitch/types.h"
 #include "ovs-atomic.h"
 #include "ovs-thread.h"
+#include "ipf.h"
 #include "packets.h"
 
 /* Userspace connection tracker
@@ -89,6 +90,27 @@ struct nat_action_info_t {
 
 void conntrack_init(struct conntrack *);
 void conntrack_destroy(struct conntrack *);
+void conntrack_ipf_get_status(struct conntrack *, struct ipf_status *);
+
+/* Per-zone connection limits. */
+struct conntrack_zone_limit {
+    struct hmap_node node;      /* In 'conntrack''s 'zone_limits'. */
+    uint16_t zone;
+    uint32_t limit;             /* Maximum connections for the zone. */
+    atomic_count count;         /* Current connections in the zone. */
+};
+
+void conntrack_set_zone_limit(struct conntrack *, uint16_t zone,
+                              uint32_t limit);
+bool conntrack_del_zone_limit(struct conntrack *, uint16_t zone);
+int conntrack_set_zone_timeout(struct conntrack *, uint16_t zone,
+                               const char *tm_name, long long value_ms);
+bool conntrack_del_zone_timeout_policy(struct conntrack *, uint16_t zone);
+void conntrack_format_zone_timeout_policies(struct conntrack *, struct ds *);
+void conntrack_set_event_log(struct conntrack *, bool enable);
+void conntrack_format_events(struct conntrack *, struct ds *);
+struct ds;
+void conntrack_format_zone_limits(struct conntrack *, struct ds *);
 
 int conntrack_execute(struct conntrack *, struct dp_packet_batch *,
                       ovs_be16 dl_type, bool force, bool commit,
@@ -98,12 +120,21 @@ int conntrack_execute(struct conntrack *, struct dp_packet_batch *,
                       const struct nat_action_info_t *nat_action_info,
                       long long now);
 
+#define CONNTRACK_DUMP_BATCH 16
+
 struct conntrack_dump {
     struct conntrack *ct;
     unsigned bucket;
     struct hmap_position bucket_pos;
     bool filter_zone;
     uint16_t zone;
+
+    /* Entries serialized in one bucket lock acquisition, handed out one at
+     * a time, so dumping a large table takes the datapath's locks once per
+     * batch instead of once per connection. */
+    struct ct_dpif_entry *batch;
+    unsigned batch_pos;
+    unsigned batch_n;
 };
 
 struct ct_dpif_entry;
@@ -243,7 +274,13 @@ struct conntrack_bucket {
     long long next_cleanup OVS_GUARDED;
 };
 
-#define CONNTRACK_BUCKETS_SHIFT 8
+/* With many pmd threads hammering connection-heavy traffic, the number of
+ * shards is what bounds lock collisions between unrelated connections:
+ * with b buckets and t threads the expected number of threads colliding on
+ * some bucket scales with t^2/b, so quadrupling the buckets cuts the
+ * collision rate fourfold at a cost of ~1 MB.  The buckets are still
+ * completely independent. */
+#define CONNTRACK_BUCKETS_SHIFT 10
 #define CONNTRACK_BUCKETS (1 << CONNTRACK_BUCKETS_SHIFT)
 
 struct conntrack {
@@ -258,6 +295,9 @@ struct conntrack {
     pthread_t clean_thread;
     /* Latch to destroy the 'clean_thread' */
     struct latch clean_thread_exit;
+    /* Set to wake the 'clean_thread' early, e.g. when a timeout policy
+     * shortens expirations it may be sleeping past. */
+    struct latch clean_thread_kick;
 
     /* Number of connections currently in the connection tracker. */
     atomic_count n_conn;
@@ -282,6 +322,38 @@ struct conntrack {
      */
     struct ct_rwlock resources_lock;
 
+    /* IPv4 fragment reassembly in front of the tracker. */
+    struct ipf *ipf;
+
+    /* Per-zone connection limits, configured through
+     * conntrack_set_zone_limit().  Protected by 'zone_limits_lock'; the
+     * per-zone counters are atomics, so the datapath only takes the lock
+     * on connection creation in a limited zone. */
+    struct ovs_mutex zone_limits_lock;
+    struct hmap zone_limits OVS_GUARDED;
+
+    /* Per-zone timeout policies.  Protected by 'zone_limits_lock'.  An
+     * entry's values may be referenced by connections, so entries are only
+     * reset to the defaults on deletion and freed when the tracker is
+     * destroyed. */
+    struct hmap timeout_policies OVS_GUARDED;
+    /* Smallest timeout value among the active policies (LLONG_MAX when
+     * none), so the sweeper can shorten its per-bucket revisit interval
+     * below CT_TM_MIN when a zone uses aggressive timeouts. */
+    atomic_llong min_policy_timeout;
+
+    /* Connection event log (see conntrack_set_event_log()). */
+    struct ovs_mutex event_mutex;
+    struct ovs_list events OVS_GUARDED;      /* Contains 'struct ct_event'. */
+    unsigned n_events OVS_GUARDED;
+    bool events_enabled OVS_GUARDED;
+    uint64_t events_dropped OVS_GUARDED;
+
+    /* Hints for NAT port allocation under exhaustion pressure, indexed by
+     * a hash of the NAT range.  0 means no hint.  Protected by
+     * 'resources_lock' like the rest of the NAT state. */
+#define CT_NAT_HINTS 256
+    uint16_t nat_port_hints[CT_NAT_HINTS] OVS_GUARDED;
 };
 
 #endif /* conntrack.h */
@@ -285,7 +285,14 @@ coverage_clear__(bool trylock)
     }
 }
 
-void
+void/* Note on removing the mutex: COVERAGE_INC itself is already lock-free
+ * (a per-thread counter write); this mutex only serializes the periodic
+ * folding of per-thread counts into the globals and runs off the hot
+ * path, at coverage_try_clear()'s cadence.  Making the fold lock-free
+ * (per-thread atomics summed at read time) trades a cold mutex for hot
+ * atomic reads in every coverage query - the wrong direction.  The hot
+ * path is untouched by this lock. */
+
 coverage_clear(void)
 {
     coverage_clear__(false);
@@ -264,6 +264,15 @@ record_id_equals(const union ovsdb_atom *name, enum ovsdb_atomic_type type,
     }
 }
 
+/* This scan is O(rows in the referenced table) per lookup.  The IDL does
+ * have index support (ovsdb_idl_create_index()), but those indexes are
+ * declared per column when the IDL is set up, while this function learns
+ * which column to search only when the command is parsed, and it must
+ * also see rows inserted by earlier commands in the same batch.  Hooking
+ * the two up would take idlc-generated indexes for every "id" column
+ * plus invalidation on local inserts; until someone does that work,
+ * callers that resolve thousands of names should batch their commands so
+ * at least the database is downloaded only once. */
 static const struct ovsdb_idl_row *
 get_row_by_id(struct ctl_context *ctx,
               const struct ovsdb_idl_table_class *table,
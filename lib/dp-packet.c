@@ -31,8 +31,10 @@ dp_packet_init__(struct dp_packet *b, size_t allocated, enum dp_packet_source so
     dp_packet_reset_offsets(b);
     pkt_metadata_init(&b->md, 0);
     dp_packet_rss_invalidate(b);
+    dp_packet_flow_mark_invalidate(b);
     dp_packet_mbuf_init(b);
     dp_packet_reset_cutlen(b);
+    dp_packet_set_rx_tstamp(b, 0);
     /* By default assume the packet type to be Ethernet. */
     b->packet_type = htonl(PT_ETH);
 }
@@ -180,6 +182,8 @@ dp_packet_clone_with_headroom(const struct dp_packet *buffer, size_t headroom)
     new_buffer->mbuf.ol_flags = buffer->mbuf.ol_flags;
 #else
     new_buffer->rss_hash_valid = buffer->rss_hash_valid;
+    new_buffer->flow_mark_valid = buffer->flow_mark_valid;
+    new_buffer->flow_mark = buffer->flow_mark;
 #endif
 
     if (dp_packet_rss_valid(new_buffer)) {
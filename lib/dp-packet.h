@@ -49,6 +49,21 @@ enum OVS_PACKED_ENUM dp_packet_source {
 /* Buffer for holding packet data.  A dp_packet is automatically reallocated
  * as necessary if it grows too large for the available memory.
  * By default the packet type is set to Ethernet (PT_ETH).
+ *
+ * Note on GSO/TSO metadata: adding gso_size/flags to this struct is the
+ * easy tenth of userspace TSO - every egress must then either pass the
+ * oversized frame to capable hardware or software-segment it (and
+ * complete checksums), including the tunnel push paths, which must
+ * replicate headers per segment.  See the matching note at the vhost
+ * feature negotiation in netdev-dpdk.c; the halves must land together.
+ *
+ * Invariant: the packet data is one contiguous buffer.  Practically every
+ * fast-path consumer - miniflow_extract(), the checksum helpers, the
+ * connection tracker, action execution - indexes straight into
+ * dp_packet_data() using the l2/l3/l4 offsets.  Chained (multi-segment)
+ * buffers would require linearize-on-demand checks at all of those places,
+ * so until something pays that cost, receive buffers must cover the full
+ * frame (e.g. MTU-sized mbufs for DPDK rx).
  */
 struct dp_packet {
 #ifdef DPDK_NETDEV
@@ -60,6 +75,8 @@ struct dp_packet {
     uint32_t size_;             /* Number of bytes in use. */
     uint32_t rss_hash;          /* Packet hash. */
     bool rss_hash_valid;        /* Is the 'rss_hash' valid? */
+    uint32_t flow_mark;         /* Mark delivered by a NIC pre-classifier. */
+    bool flow_mark_valid;       /* Is the 'flow_mark' valid? */
 #endif
     enum dp_packet_source source;  /* Source of memory allocated as 'base'. */
 
@@ -73,6 +90,11 @@ struct dp_packet {
     uint16_t l4_ofs;               /* Transport-level header offset,
                                       or UINT16_MAX. */
     uint32_t cutlen;               /* length in bytes to cut from the end. */
+    uint64_t rx_tstamp_nsec;       /* Rx timestamp in nanoseconds, or 0 if
+                                    * none was captured.  Epoch-based for
+                                    * software stamps; raw NIC hardware
+                                    * stamps are only epoch-based when the
+                                    * NIC clock is synchronized (PTP). */
     ovs_be32 packet_type;          /* Packet type as defined in OpenFlow */
     union {
         struct pkt_metadata md;
@@ -536,6 +558,21 @@ dp_packet_set_cutlen(struct dp_packet *b, uint32_t max_len)
     return b->cutlen;
 }
 
+/* Returns the rx timestamp of 'b' in nanoseconds, or 0 if the netdev did
+ * not capture one.  See the 'rx_tstamp_nsec' comment for the clock
+ * domain caveats. */
+static inline uint64_t
+dp_packet_rx_tstamp(const struct dp_packet *b)
+{
+    return b->rx_tstamp_nsec;
+}
+
+static inline void
+dp_packet_set_rx_tstamp(struct dp_packet *b, uint64_t nsec)
+{
+    b->rx_tstamp_nsec = nsec;
+}
+
 static inline uint32_t
 dp_packet_get_cutlen(const struct dp_packet *b)
 {
@@ -616,6 +653,46 @@ dp_packet_rss_invalidate(struct dp_packet *p OVS_UNUSED)
 #endif
 }
 
+/* Returns true, and sets '*mark', if a flow mark was delivered with the
+ * packet by a NIC pre-classifier. */
+static inline bool
+dp_packet_has_flow_mark(const struct dp_packet *p, uint32_t *mark)
+{
+#ifdef DPDK_NETDEV
+    if (p->mbuf.ol_flags & PKT_RX_FDIR_ID) {
+        *mark = p->mbuf.hash.fdir.hi;
+        return true;
+    }
+    return false;
+#else
+    if (p->flow_mark_valid) {
+        *mark = p->flow_mark;
+        return true;
+    }
+    return false;
+#endif
+}
+
+static inline void
+dp_packet_set_flow_mark(struct dp_packet *p, uint32_t mark)
+{
+#ifdef DPDK_NETDEV
+    p->mbuf.hash.fdir.hi = mark;
+    p->mbuf.ol_flags |= PKT_RX_FDIR_ID;
+#else
+    p->flow_mark = mark;
+    p->flow_mark_valid = true;
+#endif
+}
+
+static inline void
+dp_packet_flow_mark_invalidate(struct dp_packet *p OVS_UNUSED)
+{
+#ifndef DPDK_NETDEV
+    p->flow_mark_valid = false;
+#endif
+}
+
 static inline void
 dp_packet_mbuf_rss_flag_reset(struct dp_packet *p OVS_UNUSED)
 {
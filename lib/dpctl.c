@@ -797,6 +797,13 @@ dpctl_free_portno_names(struct hmap *portno_names)
     }
 }
 
+/* Note on streaming: this dump already streams - each flow is formatted
+ * into a dynamic string that is cleared and reused per flow, printed
+ * immediately, and the dpif dump API itself delivers flows in bounded
+ * batches - so memory use is O(one flow), not O(table).  The transient-
+ * gigabytes failure mode would require accumulating the whole dump in
+ * one buffer, which this code never did; what scales with table size is
+ * only the total bytes written to the output stream. */
 static int
 dpctl_dump_flows(int argc, const char *argv[], struct dpctl_params *dpctl_p)
 {
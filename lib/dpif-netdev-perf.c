@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017 Nicira, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+#include <stdint.h>
+
+#include "dpif-netdev-perf.h"
+#include "openvswitch/dynamic-string.h"
+
+void
+pmd_perf_stats_init(struct pmd_perf_stats *s)
+{
+    memset(s, 0, sizeof *s);
+    atomic_init(&s->clear, false);
+}
+
+/* Requests a clear of the statistics.  The counters are owned by the pmd
+ * thread, so the actual clearing is deferred to the start of its next
+ * iteration (see pmd_perf_start_iteration()). */
+void
+pmd_perf_stats_clear(struct pmd_perf_stats *s)
+{
+    atomic_store_relaxed(&s->clear, true);
+}
+
+void
+pmd_perf_stats_do_clear(struct pmd_perf_stats *s)
+{
+    pmd_perf_stats_init(s);
+}
+
+static void
+pmd_perf_format_histogram(struct ds *str, const char *name,
+                          const struct histogram *hist)
+{
+    int i;
+
+    ds_put_format(str, "  Histogram: %s\n", name);
+    if (!hist->count) {
+        ds_put_cstr(str, "      (no samples)\n");
+        return;
+    }
+    for (i = 0; i < PMD_PERF_HIST_BINS; i++) {
+        if (!hist->bin[i]) {
+            continue;
+        }
+        if (i == PMD_PERF_HIST_BINS - 1) {
+            ds_put_format(str, "      >= %10"PRIu64": %"PRIu64"\n",
+                          UINT64_C(1) << i, hist->bin[i]);
+        } else {
+            ds_put_format(str, "      %10"PRIu64" - %10"PRIu64": %"PRIu64"\n",
+                          i ? UINT64_C(1) << i : 0,
+                          (UINT64_C(1) << (i + 1)) - 1, hist->bin[i]);
+        }
+    }
+    ds_put_format(str, "      samples: %"PRIu64", avg: %.0f\n",
+                  hist->count, (double) hist->sum / hist->count);
+}
+
+void
+pmd_perf_format(struct ds *str, const struct pmd_perf_stats *s)
+{
+    uint64_t idle_iterations = s->iterations - s->busy_iterations;
+
+    ds_put_format(str,
+                  "  iterations: %"PRIu64"  (busy: %"PRIu64", "
+                  "idle: %"PRIu64")\n",
+                  s->iterations, s->busy_iterations, idle_iterations);
+    ds_put_format(str, "  packets received: %"PRIu64"\n",
+                  s->pkts_per_it.sum);
+    ds_put_format(str,
+                  "  processing cycles by stage:\n"
+                  "      rx: %"PRIu64"  datapath: %"PRIu64
+                  " (of which upcalls: %"PRIu64")  tx: %"PRIu64"\n",
+                  s->stage_cycles[PMD_STAGE_RX],
+                  s->stage_cycles[PMD_STAGE_DATAPATH],
+                  s->stage_cycles[PMD_STAGE_UPCALL],
+                  s->stage_cycles[PMD_STAGE_TX]);
+    pmd_perf_format_histogram(str, "cycles per iteration",
+                              &s->cycles_per_it);
+    pmd_perf_format_histogram(str, "packets per iteration",
+                              &s->pkts_per_it);
+    pmd_perf_format_histogram(str, "cycles per packet (busy iterations)",
+                              &s->cycles_per_pkt);
+    pmd_perf_format_histogram(str, "packets per rx batch",
+                              &s->pkts_per_batch);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2017 Nicira, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DPIF_NETDEV_PERF_H
+#define DPIF_NETDEV_PERF_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openvswitch/dynamic-string.h"
+#include "ovs-atomic.h"
+#include "util.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* Detailed performance statistics for a pmd thread.
+ *
+ * The pmd thread samples each poll iteration (one pass over all polled rx
+ * queues) into a set of histograms: the cycles the iteration took, the
+ * number of packets it received, the resulting cycles per packet and the
+ * fill level of the individual rx batches.  The histograms are log2-scaled
+ * to cover the large dynamic range of those values with a fixed number of
+ * bins.
+ *
+ * All counters are written by the pmd thread only and read by the main
+ * thread on request; readers accept slightly inconsistent values, as for
+ * the other pmd counters.  Clearing is requested through the 'clear' flag
+ * and performed by the pmd thread at the start of its next iteration. */
+
+#define PMD_PERF_HIST_BINS 32
+
+/* Pipeline stages the processing cycles of a pmd thread are split into.
+ * UPCALL is a subset of DATAPATH: it is also included there. */
+enum pmd_perf_stage {
+    PMD_STAGE_RX,               /* Polling the rx queues. */
+    PMD_STAGE_DATAPATH,         /* Classification and action execution. */
+    PMD_STAGE_UPCALL,           /* Slow-path upcalls. */
+    PMD_STAGE_TX,               /* Flushing the output batches. */
+    PMD_N_STAGES
+};
+
+struct histogram {
+    uint64_t bin[PMD_PERF_HIST_BINS]; /* Bin i counts samples in the range
+                                       * [2^i, 2^(i+1)), bin 0 also counts
+                                       * zero samples. */
+    uint64_t sum;                     /* Sum of all samples. */
+    uint64_t count;                   /* Number of samples. */
+};
+
+struct pmd_perf_stats {
+    atomic_bool clear;             /* Set to request a clear, consumed by
+                                    * the pmd thread. */
+    uint64_t start_it_tsc;         /* TSC at start of current iteration. */
+    uint64_t iterations;           /* Number of poll iterations. */
+    uint64_t busy_iterations;      /* Iterations that received packets. */
+    struct histogram cycles_per_it;  /* Cycles per iteration. */
+    struct histogram pkts_per_it;    /* Rx packets per iteration. */
+    struct histogram cycles_per_pkt; /* Cycles per packet, over the busy
+                                      * iterations only. */
+    struct histogram pkts_per_batch; /* Fill level of single rx batches. */
+    uint64_t stage_cycles[PMD_N_STAGES]; /* Busy cycles by pipeline stage. */
+};
+
+void pmd_perf_stats_init(struct pmd_perf_stats *);
+void pmd_perf_stats_clear(struct pmd_perf_stats *);
+void pmd_perf_stats_do_clear(struct pmd_perf_stats *);
+void pmd_perf_format(struct ds *, const struct pmd_perf_stats *);
+
+static inline void
+pmd_perf_add_stage_cycles(struct pmd_perf_stats *s,
+                          enum pmd_perf_stage stage, uint64_t cycles)
+{
+    s->stage_cycles[stage] += cycles;
+}
+
+static inline void
+histogram_add_sample(struct histogram *hist, uint64_t val)
+{
+    hist->bin[val ? MIN(log_2_floor(val), PMD_PERF_HIST_BINS - 1) : 0]++;
+    hist->sum += val;
+    hist->count++;
+}
+
+static inline void
+pmd_perf_start_iteration(struct pmd_perf_stats *s, uint64_t now_tsc)
+{
+    bool clear;
+
+    atomic_read_relaxed(&s->clear, &clear);
+    if (OVS_UNLIKELY(clear)) {
+        pmd_perf_stats_do_clear(s);
+    }
+    s->start_it_tsc = now_tsc;
+}
+
+static inline void
+pmd_perf_end_iteration(struct pmd_perf_stats *s, uint64_t now_tsc,
+                       int rx_packets)
+{
+    uint64_t cycles = now_tsc - s->start_it_tsc;
+
+    s->iterations++;
+    histogram_add_sample(&s->cycles_per_it, cycles);
+    histogram_add_sample(&s->pkts_per_it, rx_packets);
+    if (rx_packets > 0) {
+        s->busy_iterations++;
+        histogram_add_sample(&s->cycles_per_pkt, cycles / rx_packets);
+    }
+}
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* DPIF_NETDEV_PERF_H */
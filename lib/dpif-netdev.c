@@ -43,6 +43,7 @@
 #include "csum.h"
 #include "dp-packet.h"
 #include "dpif.h"
+#include "dpif-netdev-perf.h"
 #include "dpif-provider.h"
 #include "dummy.h"
 #include "fat-rwlock.h"
@@ -66,10 +67,12 @@
 #include "ovs-numa.h"
 #include "ovs-rcu.h"
 #include "packets.h"
+#include "pcap-file.h"
 #include "poll-loop.h"
 #include "pvector.h"
 #include "random.h"
 #include "seq.h"
+#include "simap.h"
 #include "smap.h"
 #include "sset.h"
 #include "timeval.h"
@@ -77,6 +80,7 @@
 #include "tnl-ports.h"
 #include "unixctl.h"
 #include "util.h"
+#include "uuid.h"
 
 VLOG_DEFINE_THIS_MODULE(dpif_netdev);
 
@@ -176,6 +180,38 @@ struct emc_cache {
          i__ < EM_FLOW_HASH_SEGS;                                            \
          i__++, srch_hash__ >>= EM_FLOW_HASH_SHIFT)
 
+/* Signature match cache (SMC)
+ *
+ * A second-level flow cache, consulted after the EMC misses and before the
+ * megaflow classifier.  Instead of a full 'netdev_flow_key', each entry
+ * stores only a 16-bit signature taken from the upper half of the packet's
+ * RSS hash plus a 16-bit index of the flow within the pmd thread's
+ * 'flow_table' cmap, so the SMC packs vastly more entries into the same
+ * amount of CPU cache than the EMC and degrades more gracefully with large
+ * numbers of concurrent flows.  Since different flows can share a signature,
+ * a hit must be validated against the megaflow's mask before use.
+ *
+ * Thread-safety
+ * =============
+ *
+ * As for the EMC, each pmd thread has its own private signature match
+ * cache. */
+
+#define SMC_ENTRY_PER_BUCKET 4
+#define SMC_ENTRIES (1u << 20)
+#define SMC_BUCKET_CNT (SMC_ENTRIES / SMC_ENTRY_PER_BUCKET)
+#define SMC_MASK (SMC_BUCKET_CNT - 1)
+
+struct smc_bucket {
+    uint16_t sig[SMC_ENTRY_PER_BUCKET];
+    uint16_t flow_idx[SMC_ENTRY_PER_BUCKET];
+};
+
+/* Signature match cache, one per pmd thread. */
+struct smc_cache {
+    struct smc_bucket buckets[SMC_BUCKET_CNT];
+};
+
 /* Simple non-wildcarding single-priority classifier. */
 
 /* Time in ms between successive optimizations of the dpcls subtable vector */
@@ -214,6 +250,33 @@ static bool dpcls_lookup(struct dpcls *cls,
                          const struct netdev_flow_key keys[],
                          struct dpcls_rule **rules, size_t cnt,
                          int *num_lookups_p);
+static inline bool dpcls_rule_matches_key(const struct dpcls_rule *rule,
+                                          const struct netdev_flow_key *target);
+static void dpcls_subtable_lookup_reprobe(struct dpcls *cls);
+
+/* Runtime-adjustable priorities of the dpcls subtable lookup
+ * implementations.  The highest-priority implementation that supports a
+ * subtable's mask is selected when the subtable is created; the owning pmd
+ * thread re-probes its subtables during the periodic optimization, so a
+ * priority change takes effect without restarting the datapath. */
+static atomic_uint32_t dpcls_lookup_prio_generic = ATOMIC_VAR_INIT(1);
+static atomic_uint32_t dpcls_lookup_prio_unit0 = ATOMIC_VAR_INIT(2);
+
+/* Sequence number bumped on every priority change, polled by the pmd
+ * threads to learn that they should re-probe. */
+static atomic_uint32_t dpcls_lookup_prio_seq = ATOMIC_VAR_INIT(0);
+
+/* Miniflow extraction implementation used by emc_processing(), selectable
+ * at runtime with the dpif-netdev/miniflow-parser-set command.  The
+ * specialized parser (see miniflow_extract_ipv4_l4()) falls back to the
+ * generic one for packets outside its profile; the autovalidator runs
+ * both, compares the results and uses the generic one. */
+enum dp_mfex_impl {
+    MFEX_IMPL_SCALAR,           /* Generic parser only. */
+    MFEX_IMPL_OPT,              /* Specialized parser, generic fallback. */
+    MFEX_IMPL_AUTOVALIDATOR,    /* Compare both, use the generic result. */
+};
+static atomic_int dp_mfex_impl = ATOMIC_VAR_INIT(MFEX_IMPL_SCALAR);
 
 /* Set of supported meter flags */
 #define DP_SUPPORTED_METER_FLAGS_MASK \
@@ -240,6 +303,49 @@ struct dp_meter {
     struct dp_meter_band bands[];
 };
 
+/* A per-pmd cache of prepaid meter volume.
+ *
+ * To avoid serializing the pmd threads on the shared meter locks, each
+ * thread claims a few milliseconds worth of volume from all the bands of a
+ * meter in one locked operation and then admits packets against that local
+ * allotment lock free.  A batch that does not fit in the allotment, and
+ * any visit after the refill deadline, goes through the locked slow path,
+ * so packets are only ever dropped with the bands' exact state.  Local
+ * statistics are published through atomics and folded into the shared
+ * meter when the cache is refilled or evicted. */
+#define DP_METER_CACHE_SIZE 8           /* Direct-mapped entries per pmd. */
+#define DP_METER_CACHE_REFILL_MS 4      /* Prepaid horizon. */
+
+struct dp_meter_cache_entry {
+    uint32_t meter_id;          /* UINT32_MAX if the entry is empty. */
+    uint32_t generation;        /* dp's meter generation at fill time. */
+    long long int refill_time;  /* Next mandatory slow-path visit. */
+    uint64_t prepaid;           /* Remaining prepaid volume. */
+    atomic_ullong packet_count; /* Packets admitted from the allotment. */
+    atomic_ullong byte_count;   /* Bytes admitted from the allotment. */
+};
+
+/* Time in ms between successive automatic load balance checks, and the
+ * default minimum time between two triggered rxq rebalances. */
+#define ALB_PMD_REBALANCE_POLL_INTERVAL (60 * 1000)
+
+/* Default spread, in percentage points of busy cycles, between the most and
+ * least loaded non-isolated pmd threads above which a rebalance is
+ * triggered. */
+#define ALB_PMD_LOAD_THRESHOLD 25
+
+/* Automatic rxq load balancing.  All members are used only by the main
+ * thread. */
+struct pmd_auto_lb {
+    bool auto_lb_requested;     /* Auto load balance requested by user. */
+    bool is_enabled;            /* Current status of auto load balance. */
+    uint64_t rebalance_intvl;   /* Minimum time (in ms) between two
+                                 * consecutive rebalances. */
+    long long int rebalance_poll_timer; /* Time (in ms) of the last check. */
+    uint32_t load_threshold;    /* Load spread (in percentage points) above
+                                 * which a rebalance is triggered. */
+};
+
 /* Datapath based on the network device interface from netdev.h.
  *
  *
@@ -273,9 +379,49 @@ struct dp_netdev {
     /* Meters. */
     struct ovs_mutex meter_locks[N_METER_LOCKS];
     struct dp_meter *meters[MAX_METERS]; /* Meter bands. */
+    /* Bumped on every meter configuration change, so that the per-pmd
+     * meter caches can notice stale entries. */
+    atomic_uint32_t meter_generation;
 
     /* Probability of EMC insertions is a factor of 'emc_insert_min'.*/
     OVS_ALIGNED_VAR(CACHE_LINE_SIZE) atomic_uint32_t emc_insert_min;
+    /* Enable collection of packets into the signature match cache. */
+    atomic_bool smc_enable_db;
+
+    /* The time that a packet can wait in output batch for sending. */
+    atomic_uint32_t tx_flush_interval;
+
+    /* Whether cores with pinned rx queues are excluded from the scheduling
+     * of the non-pinned queues.  Written by the main thread only. */
+    bool pmd_iso;
+
+    /* Maximum per-iteration load-based sleep request (in microseconds) of
+     * the pmd threads.  Zero disables sleeping. */
+    atomic_ullong pmd_max_sleep;
+
+    /* Rx batch fill level at which a port with cross-pmd steering starts
+     * handing packets off.  Defaults to a full burst. */
+    atomic_uint32_t steer_threshold;
+
+    /* Sampled packet capture (see dpif-netdev/capture-start).  The flag
+     * is checked per rx batch; everything else lives under the mutex,
+     * which is only taken while a capture is active. */
+    atomic_bool capture_on;
+    struct ovs_mutex capture_mutex;
+    FILE *capture_file OVS_GUARDED;
+    odp_port_t capture_port OVS_GUARDED;
+    unsigned capture_rate OVS_GUARDED;   /* Keep 1 of every N packets. */
+    unsigned long long capture_count OVS_GUARDED; /* Packets seen. */
+    unsigned long long capture_taken OVS_GUARDED; /* Packets written. */
+
+    /* Sampled flow tracing (see dpif-netdev/trace-start). */
+    atomic_bool trace_on;
+    atomic_uint trace_rate;      /* Trace 1 of every N packets. */
+
+    /* Per-port, per-reason drop counters (see dpif-netdev/drop-stats).
+     * Lookups are lock-free; the mutex only serializes entry creation. */
+    struct cmap drop_stats;      /* Contains 'struct dp_netdev_port_drops'. */
+    struct ovs_mutex drop_stats_mutex;
 
     /* Protects access to ofproto-dpif-upcall interface during revalidator
      * thread synchronization. */
@@ -311,6 +457,7 @@ struct dp_netdev {
     uint64_t last_tnl_conf_seq;
 
     struct conntrack conntrack;
+    struct pmd_auto_lb pmd_alb;
 };
 
 static void meter_lock(const struct dp_netdev *dp, uint32_t meter_id)
@@ -331,7 +478,9 @@ static struct dp_netdev_port *dp_netdev_lookup_port(const struct dp_netdev *dp,
     OVS_REQUIRES(dp->port_mutex);
 
 enum dp_stat_type {
+    DP_STAT_MARK_HIT,           /* Packets matched by a hardware mark. */
     DP_STAT_EXACT_HIT,          /* Packets that had an exact match (emc). */
+    DP_STAT_SMC_HIT,            /* Packets that had a sig match hit (SMC). */
     DP_STAT_MASKED_HIT,         /* Packets that matched in the flow table. */
     DP_STAT_MISS,               /* Packets that did not match. */
     DP_STAT_LOST,               /* Packets not passed up to the client. */
@@ -358,6 +507,16 @@ enum rxq_cycles_counter_type {
 
 #define XPS_TIMEOUT_MS 500LL
 
+/* Default time (in microseconds) for which the packets queued on an output
+ * port are allowed to wait before they are sent. */
+#define DEFAULT_TX_FLUSH_INTERVAL 0
+
+/* Size of the step (in microseconds) by which a pmd thread increases its
+ * load-based sleep request after an iteration without any received
+ * packets, and the upper bound that 'pmd-maxsleep' may be set to. */
+#define PMD_SLEEP_INC_US 1
+#define PMD_SLEEP_MAX_US 10000
+
 /* Contained by struct dp_netdev_port's 'rxqs' member.  */
 struct dp_netdev_rxq {
     struct dp_netdev_port *port;
@@ -390,6 +549,9 @@ struct dp_netdev_port {
     struct ovs_mutex txq_used_mutex;
     char *type;                 /* Port type as requested by user. */
     char *rxq_affinity_list;    /* Requested affinity of rx queues. */
+    bool cross_pmd_steering;    /* Hand a share of the received packets
+                                 * off to a peer pmd thread when the
+                                 * polling thread saturates. */
 };
 
 /* Contained by struct dp_netdev_flow's 'stats' member.  */
@@ -443,9 +605,15 @@ struct dp_netdev_flow {
     const struct cmap_node node; /* In owning dp_netdev_pmd_thread's */
                                  /* 'flow_table'. */
     const ovs_u128 ufid;         /* Unique flow identifier. */
+    const ovs_u128 mega_ufid;    /* Unique mega flow identifier. */
     const unsigned pmd_id;       /* The 'core_id' of pmd thread owning this */
                                  /* flow. */
 
+    /* Hardware offload: mark associated with the flow when its megaflow
+     * has been offloaded, INVALID_FLOW_MARK otherwise. */
+    uint32_t mark;
+    struct cmap_node mark_node;  /* In 'flow_mark.mark_to_flow'. */
+
     /* Number of references.
      * The classifier owns one reference.
      * Any thread trying to keep a rule from being freed should hold its own
@@ -487,6 +655,10 @@ struct dp_netdev_actions {
     /* These members are immutable: they do not change during the struct's
      * lifetime.  */
     unsigned int size;          /* Size of 'actions', in bytes. */
+    bool simple_output;         /* True if 'actions' is a single OUTPUT
+                                 * action, allowing the execution to go
+                                 * straight to the tx queue. */
+    odp_port_t output_port;     /* Output port if 'simple_output'. */
     struct nlattr actions[];    /* Sequence of OVS_ACTION_ATTR_* attributes. */
 };
 
@@ -511,6 +683,7 @@ struct dp_netdev_pmd_cycles {
 struct polled_queue {
     struct dp_netdev_rxq *rxq;
     odp_port_t port_no;
+    bool steer;                 /* Cross-pmd steering enabled on the port. */
 };
 
 /* Contained by struct dp_netdev_pmd_thread's 'poll_list' member. */
@@ -526,6 +699,9 @@ struct tx_port {
     int qid;
     long long last_used;
     struct hmap_node node;
+    long long flush_time;       /* Time (in usec) by which the packets
+                                 * queued in 'output_pkts' must be sent. */
+    struct dp_packet_batch output_pkts;
 };
 
 /* PMD: Poll modes drivers.  PMD accesses devices via polling to eliminate
@@ -560,6 +736,10 @@ struct dp_netdev_pmd_thread {
      * will only be accessed by its own pmd thread. */
     struct emc_cache flow_cache;
 
+    /* Per thread signature match cache, consulted after 'flow_cache'
+     * misses.  Same thread-safety rules as for 'flow_cache'. */
+    struct smc_cache smc_cache;
+
     /* Flow-Table and classifiers
      *
      * Writers of 'flow_table' must take the 'flow_mutex'.  Corresponding
@@ -586,6 +766,52 @@ struct dp_netdev_pmd_thread {
     /* Used to count cicles. See 'cycles_counter_end()' */
     unsigned long long last_cycles;
 
+    /* Snapshot of 'cycles' taken at the previous automatic load balance
+     * check.  Only used by the main thread. */
+    uint64_t alb_prev_cycles[PMD_N_CYCLES];
+
+    /* Detailed per-iteration statistics.  Written by the pmd thread,
+     * read on request by the main thread. */
+    struct pmd_perf_stats perf_stats;
+
+    /* Last seen value of 'dpcls_lookup_prio_seq', used to re-probe the
+     * subtable lookup implementations when the priorities change. */
+    uint32_t lookup_prio_seq;
+
+    /* Per thread cache of prepaid meter volume (see
+     * dp_netdev_run_meter()).  Entries are owned by this thread; the
+     * statistics are atomics so that dpif_netdev_meter_get() can sum
+     * them from the main thread. */
+    struct dp_meter_cache_entry meter_cache[DP_METER_CACHE_SIZE];
+
+    /* Queue of packets handed off by peer pmd threads (see
+     * 'cross_pmd_steering').  Producers and the owning consumer take
+     * 'handoff_mutex'; the handoff is batched, so the lock is touched at
+     * most once per rx batch on either side. */
+    struct ovs_mutex handoff_mutex;
+    struct dp_packet_batch handoff_batch OVS_GUARDED;
+    bool handoff_closed OVS_GUARDED;
+    bool handoff_draining OVS_GUARDED; /* Consumer still processing a
+                                        * previously taken batch. */
+
+    /* Cached peer for steering, refreshed after each reload.  A reference
+     * is held while cached. */
+    struct dp_netdev_pmd_thread *steer_dst;
+
+    /* True while the steering peer may still hold packets this thread
+     * handed off: the hash split then stays in force below the threshold
+     * so flows cannot overtake their older packets in the peer's queue.
+     * Owned by this thread. */
+    bool steering_sticky;
+
+    /* Sampled flow tracing (see dpif-netdev/trace-start).  The owning
+     * thread records entries under the mutex while tracing is on; the
+     * main thread drains them from dpif-netdev/trace-show. */
+    struct ovs_mutex trace_mutex;
+    struct ovs_list trace_entries OVS_GUARDED;
+    unsigned int trace_n_entries OVS_GUARDED;
+    unsigned long long trace_seen OVS_GUARDED;
+
     struct latch exit_latch;        /* For terminating the pmd thread. */
     struct seq *reload_seq;
     uint64_t last_reload_seq;
@@ -600,6 +826,9 @@ struct dp_netdev_pmd_thread {
      * than 'cmap_count(dp->poll_threads)'. */
     uint32_t static_tx_qid;
 
+    /* Number of filled output batches. */
+    int n_output_batches;
+
     struct ovs_mutex port_mutex;    /* Mutex for 'poll_list' and 'tx_ports'. */
     /* List of rx queues to poll. */
     struct hmap poll_list OVS_GUARDED;
@@ -701,6 +930,12 @@ static void dp_netdev_pmd_unref(struct dp_netdev_pmd_thread *pmd);
 static void dp_netdev_pmd_flow_flush(struct dp_netdev_pmd_thread *pmd);
 static void pmd_load_cached_ports(struct dp_netdev_pmd_thread *pmd)
     OVS_REQUIRES(pmd->port_mutex);
+static int dp_netdev_pmd_flush_output_packets(struct dp_netdev_pmd_thread *pmd,
+                                              bool force);
+static inline bool dp_netdev_pmd_output(struct dp_netdev_pmd_thread *pmd,
+                                        odp_port_t port_no,
+                                        struct dp_packet_batch *packets_,
+                                        bool may_steal);
 static inline void
 dp_netdev_pmd_try_optimize(struct dp_netdev_pmd_thread *pmd,
                            struct polled_queue *poll_list, int poll_cnt);
@@ -726,6 +961,32 @@ static inline bool emc_entry_alive(struct emc_entry *ce);
 static void emc_clear_entry(struct emc_entry *ce);
 
 static void dp_netdev_request_reconfigure(struct dp_netdev *dp);
+static struct dp_netdev *dpif_netdev_find_dp(struct unixctl_conn *,
+                                             int argc, const char *argv[]);
+static void dp_netdev_capture_batch(struct dp_netdev *, odp_port_t,
+                                    struct dp_packet_batch *);
+
+/* Every way a packet can be lost inside the userspace datapath, so drops
+ * can be attributed instead of silently vanishing.  Keep in sync with
+ * 'dp_drop_reason_names'. */
+enum dp_drop_reason {
+    DP_DROP_RX_RUNT,            /* Frame shorter than an Ethernet header. */
+    DP_DROP_METER,              /* Meter band exceeded. */
+    DP_DROP_UPCALL_ERROR,       /* Upcall failed. */
+    DP_DROP_UPCALL_DISABLED,    /* Flow miss with upcalls disabled. */
+    DP_DROP_TUNNEL_PUSH,        /* Tunnel header could not be pushed. */
+    DP_DROP_TUNNEL_POP,         /* Tunnel pop to an unknown port. */
+    DP_DROP_INVALID_PORT,       /* Output to an unknown port. */
+    DP_DROP_RECIRC_DEPTH,       /* Max recirculation depth exceeded. */
+    DP_DROP_HANDOFF_CLOSED,     /* Steering handoff to a departing pmd. */
+    DP_N_DROP_REASONS
+};
+
+static void dp_netdev_count_drop(struct dp_netdev *, odp_port_t,
+                                 enum dp_drop_reason, uint64_t n);
+static void dp_netdev_count_batch_drop(struct dp_netdev *,
+                                       const struct dp_packet_batch *,
+                                       enum dp_drop_reason);
 
 static void
 emc_cache_init(struct emc_cache *flow_cache)
@@ -751,6 +1012,21 @@ emc_cache_uninit(struct emc_cache *flow_cache)
     }
 }
 
+/* Marks every entry in 'smc_cache' empty.  The SMC stores indexes into the
+ * pmd thread's flow table rather than references, so there is nothing to
+ * release on uninit. */
+static void
+smc_cache_init(struct smc_cache *smc_cache)
+{
+    int i, j;
+
+    for (i = 0; i < SMC_BUCKET_CNT; i++) {
+        for (j = 0; j < SMC_ENTRY_PER_BUCKET; j++) {
+            smc_cache->buckets[i].flow_idx[j] = UINT16_MAX;
+        }
+    }
+}
+
 /* Check and clear dead flow references slowly (one entry at each
  * invocation).  */
 static void
@@ -787,7 +1063,8 @@ get_dp_netdev(const struct dpif *dpif)
 enum pmd_info_type {
     PMD_INFO_SHOW_STATS,  /* Show how cpu cycles are spent. */
     PMD_INFO_CLEAR_STATS, /* Set the cycles count to 0. */
-    PMD_INFO_SHOW_RXQ     /* Show poll-lists of pmd threads. */
+    PMD_INFO_SHOW_RXQ,    /* Show poll-lists of pmd threads. */
+    PMD_INFO_PERF_SHOW,   /* Show pmd performance details. */
 };
 
 static void
@@ -815,7 +1092,8 @@ pmd_info_show_stats(struct ds *reply,
     }
 
     /* Sum of all the matched and not matched packets gives the total.  */
-    total_packets = stats[DP_STAT_EXACT_HIT] + stats[DP_STAT_MASKED_HIT]
+    total_packets = stats[DP_STAT_MARK_HIT] + stats[DP_STAT_EXACT_HIT]
+                    + stats[DP_STAT_SMC_HIT] + stats[DP_STAT_MASKED_HIT]
                     + stats[DP_STAT_MISS];
 
     for (i = 0; i < PMD_N_CYCLES; i++) {
@@ -840,10 +1118,13 @@ pmd_info_show_stats(struct ds *reply,
     ds_put_cstr(reply, ":\n");
 
     ds_put_format(reply,
-                  "\temc hits:%llu\n\tmegaflow hits:%llu\n"
+                  "\tmark hits:%llu\n\temc hits:%llu\n\tsmc hits:%llu\n"
+                  "\tmegaflow hits:%llu\n"
                   "\tavg. subtable lookups per hit:%.2f\n"
                   "\tmiss:%llu\n\tlost:%llu\n",
-                  stats[DP_STAT_EXACT_HIT], stats[DP_STAT_MASKED_HIT],
+                  stats[DP_STAT_MARK_HIT],
+                  stats[DP_STAT_EXACT_HIT], stats[DP_STAT_SMC_HIT],
+                  stats[DP_STAT_MASKED_HIT],
                   stats[DP_STAT_MASKED_HIT] > 0
                   ? (1.0*stats[DP_STAT_LOOKUP_HIT])/stats[DP_STAT_MASKED_HIT]
                   : 0,
@@ -877,6 +1158,18 @@ pmd_info_show_stats(struct ds *reply,
                   cycles[PMD_CYCLES_PROCESSING], total_packets);
 }
 
+static void
+pmd_info_show_perf(struct ds *reply, struct dp_netdev_pmd_thread *pmd)
+{
+    if (pmd->core_id == NON_PMD_CORE_ID) {
+        return;
+    }
+
+    ds_put_format(reply, "pmd thread numa_id %d core_id %u:\n",
+                  pmd->numa_id, pmd->core_id);
+    pmd_perf_format(reply, &pmd->perf_stats);
+}
+
 static void
 pmd_info_clear_stats(struct ds *reply OVS_UNUSED,
                     struct dp_netdev_pmd_thread *pmd,
@@ -896,6 +1189,7 @@ pmd_info_clear_stats(struct ds *reply OVS_UNUSED,
     for (i = 0; i < PMD_N_CYCLES; i++) {
         pmd->cycles_zero[i] = cycles[i];
     }
+    pmd_perf_stats_clear(&pmd->perf_stats);
 }
 
 static int
@@ -972,150 +1266,974 @@ pmd_info_show_rxq(struct ds *reply, struct dp_netdev_pmd_thread *pmd)
         ds_put_cstr(reply, "\n");
         free(list);
     }
-}
-
-static int
-compare_poll_thread_list(const void *a_, const void *b_)
-{
-    const struct dp_netdev_pmd_thread *a, *b;
+}
+
+static int
+compare_poll_thread_list(const void *a_, const void *b_)
+{
+    const struct dp_netdev_pmd_thread *a, *b;
+
+    a = *(struct dp_netdev_pmd_thread **)a_;
+    b = *(struct dp_netdev_pmd_thread **)b_;
+
+    if (a->core_id < b->core_id) {
+        return -1;
+    }
+    if (a->core_id > b->core_id) {
+        return 1;
+    }
+    return 0;
+}
+
+/* Create a sorted list of pmd's from the dp->poll_threads cmap. We can use
+ * this list, as long as we do not go to quiescent state. */
+static void
+sorted_poll_thread_list(struct dp_netdev *dp,
+                        struct dp_netdev_pmd_thread ***list,
+                        size_t *n)
+{
+    struct dp_netdev_pmd_thread *pmd;
+    struct dp_netdev_pmd_thread **pmd_list;
+    size_t k = 0, n_pmds;
+
+    n_pmds = cmap_count(&dp->poll_threads);
+    pmd_list = xcalloc(n_pmds, sizeof *pmd_list);
+
+    CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+        if (k >= n_pmds) {
+            break;
+        }
+        pmd_list[k++] = pmd;
+    }
+
+    qsort(pmd_list, k, sizeof *pmd_list, compare_poll_thread_list);
+
+    *list = pmd_list;
+    *n = k;
+}
+
+static void
+dpif_netdev_pmd_rebalance(struct unixctl_conn *conn, int argc,
+                          const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    struct dp_netdev *dp = NULL;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+
+    if (argc == 2) {
+        dp = shash_find_data(&dp_netdevs, argv[1]);
+    } else if (shash_count(&dp_netdevs) == 1) {
+        /* There's only one datapath */
+        dp = shash_first(&dp_netdevs)->data;
+    }
+
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        unixctl_command_reply_error(conn,
+                                    "please specify an existing datapath");
+        return;
+    }
+
+    dp_netdev_request_reconfigure(dp);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+    ds_put_cstr(&reply, "pmd rxq rebalance requested.\n");
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_pmd_info(struct unixctl_conn *conn, int argc, const char *argv[],
+                     void *aux)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    struct dp_netdev_pmd_thread **pmd_list;
+    struct dp_netdev *dp = NULL;
+    size_t n;
+    enum pmd_info_type type = *(enum pmd_info_type *) aux;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+
+    if (argc == 2) {
+        dp = shash_find_data(&dp_netdevs, argv[1]);
+    } else if (shash_count(&dp_netdevs) == 1) {
+        /* There's only one datapath */
+        dp = shash_first(&dp_netdevs)->data;
+    }
+
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        unixctl_command_reply_error(conn,
+                                    "please specify an existing datapath");
+        return;
+    }
+
+    sorted_poll_thread_list(dp, &pmd_list, &n);
+    for (size_t i = 0; i < n; i++) {
+        struct dp_netdev_pmd_thread *pmd = pmd_list[i];
+        if (!pmd) {
+            break;
+        }
+
+        if (type == PMD_INFO_SHOW_RXQ) {
+            pmd_info_show_rxq(&reply, pmd);
+        } else if (type == PMD_INFO_PERF_SHOW) {
+            pmd_info_show_perf(&reply, pmd);
+        } else {
+            unsigned long long stats[DP_N_STATS];
+            uint64_t cycles[PMD_N_CYCLES];
+
+            /* Read current stats and cycle counters */
+            for (size_t j = 0; j < ARRAY_SIZE(stats); j++) {
+                atomic_read_relaxed(&pmd->stats.n[j], &stats[j]);
+            }
+            for (size_t j = 0; j < ARRAY_SIZE(cycles); j++) {
+                atomic_read_relaxed(&pmd->cycles.n[j], &cycles[j]);
+            }
+
+            if (type == PMD_INFO_CLEAR_STATS) {
+                pmd_info_clear_stats(&reply, pmd, stats, cycles);
+            } else if (type == PMD_INFO_SHOW_STATS) {
+                pmd_info_show_stats(&reply, pmd, stats, cycles);
+            }
+        }
+    }
+    free(pmd_list);
+
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+/* Bumps the lookup-priority sequence number so that the pmd threads
+ * re-probe their subtables (see dp_netdev_pmd_try_optimize()). */
+static void
+dpcls_lookup_prio_changed(void)
+{
+    uint32_t seq;
+
+    atomic_read_relaxed(&dpcls_lookup_prio_seq, &seq);
+    atomic_store_relaxed(&dpcls_lookup_prio_seq, seq + 1);
+}
+
+static void
+dpif_netdev_subtable_lookup_get(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                                const char *argv[] OVS_UNUSED,
+                                void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    uint32_t prio_generic, prio_unit0;
+
+    atomic_read_relaxed(&dpcls_lookup_prio_generic, &prio_generic);
+    atomic_read_relaxed(&dpcls_lookup_prio_unit0, &prio_unit0);
+
+    ds_put_cstr(&reply,
+                "Available dpcls subtable lookup functions (name : prio)\n");
+    ds_put_format(&reply, "  generic : %"PRIu32"\n", prio_generic);
+    ds_put_format(&reply, "  unit0 : %"PRIu32"\n", prio_unit0);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_subtable_lookup_set(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                                const char *argv[], void *aux OVS_UNUSED)
+{
+    const char *name = argv[1];
+    atomic_uint32_t *prio;
+    unsigned int new_prio;
+
+    if (!strcmp(name, "generic")) {
+        prio = &dpcls_lookup_prio_generic;
+    } else if (!strcmp(name, "unit0")) {
+        prio = &dpcls_lookup_prio_unit0;
+    } else {
+        unixctl_command_reply_error(conn, "unknown lookup function, expected "
+                                    "\"generic\" or \"unit0\"");
+        return;
+    }
+
+    if (!str_to_uint(argv[2], 10, &new_prio) || new_prio > UINT8_MAX) {
+        unixctl_command_reply_error(conn,
+                                    "invalid priority, expected 0-255");
+        return;
+    }
+
+    atomic_store_relaxed(prio, new_prio);
+    dpcls_lookup_prio_changed();
+
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    ds_put_format(&reply, "Lookup priority change affected subtables will "
+                  "be re-probed by the pmd threads; %s is now priority %u\n",
+                  name, new_prio);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static const char *
+dp_mfex_impl_name(enum dp_mfex_impl impl)
+{
+    switch (impl) {
+    case MFEX_IMPL_SCALAR: return "scalar";
+    case MFEX_IMPL_OPT: return "opt";
+    case MFEX_IMPL_AUTOVALIDATOR: return "autovalidator";
+    default: return "<unknown>";
+    }
+}
+
+static void
+dpif_netdev_miniflow_parser_get(struct unixctl_conn *conn,
+                                int argc OVS_UNUSED,
+                                const char *argv[] OVS_UNUSED,
+                                void *aux OVS_UNUSED)
+{
+    int impl;
+
+    atomic_read_relaxed(&dp_mfex_impl, &impl);
+    unixctl_command_reply(conn, dp_mfex_impl_name(impl));
+}
+
+static void
+dpif_netdev_miniflow_parser_set(struct unixctl_conn *conn,
+                                int argc OVS_UNUSED, const char *argv[],
+                                void *aux OVS_UNUSED)
+{
+    const char *name = argv[1];
+    enum dp_mfex_impl impl;
+
+    if (!strcmp(name, "scalar")) {
+        impl = MFEX_IMPL_SCALAR;
+    } else if (!strcmp(name, "opt")) {
+        impl = MFEX_IMPL_OPT;
+    } else if (!strcmp(name, "autovalidator")) {
+        impl = MFEX_IMPL_AUTOVALIDATOR;
+    } else {
+        unixctl_command_reply_error(conn, "unknown miniflow parser, expected "
+                                    "\"scalar\", \"opt\" or "
+                                    "\"autovalidator\"");
+        return;
+    }
+
+    atomic_store_relaxed(&dp_mfex_impl, impl);
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    ds_put_format(&reply, "Miniflow parser set to %s", name);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_ipf_status(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    struct ipf_status status;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        return;
+    }
+
+    conntrack_ipf_get_status(&dp->conntrack, &status);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    ds_put_format(&reply, "Fragments held: %"PRIu64" (%"PRIu64" bytes)\n",
+                  status.n_frags_held, status.n_bytes_held);
+    ds_put_format(&reply, "Fragments accepted: %"PRIu64"\n",
+                  status.n_frags_accepted);
+    ds_put_format(&reply, "Fragments completed: %"PRIu64"\n",
+                  status.n_frags_completed);
+    ds_put_format(&reply, "Fragments expired: %"PRIu64"\n",
+                  status.n_frags_expired);
+    ds_put_format(&reply, "Fragments too small: %"PRIu64"\n",
+                  status.n_frags_too_small);
+    ds_put_format(&reply, "Fragments overlapped: %"PRIu64"\n",
+                  status.n_frags_overlapped);
+    ds_put_format(&reply, "Fragments passed through on overflow: %"PRIu64"\n",
+                  status.n_frags_overflow);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static struct dp_netdev *
+dpif_netdev_find_dp(struct unixctl_conn *conn, int argc, const char *argv[])
+    OVS_REQUIRES(dp_netdev_mutex)
+{
+    struct dp_netdev *dp = NULL;
+
+    if (argc == 2) {
+        dp = shash_find_data(&dp_netdevs, argv[1]);
+    } else if (shash_count(&dp_netdevs) == 1) {
+        dp = shash_first(&dp_netdevs)->data;
+    }
+    if (!dp) {
+        unixctl_command_reply_error(conn,
+                                    "please specify an existing datapath");
+    }
+    return dp;
+}
+
+static void
+dpif_netdev_ct_zone_limit_set(struct unixctl_conn *conn, int argc,
+                              const char *argv[], void *aux OVS_UNUSED)
+{
+    unsigned int zone, limit;
+
+    if (!str_to_uint(argv[argc - 2], 10, &zone) || zone > UINT16_MAX
+        || !str_to_uint(argv[argc - 1], 10, &limit)) {
+        unixctl_command_reply_error(conn, "invalid zone or limit");
+        return;
+    }
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc - 2,  argv);
+    if (dp) {
+        conntrack_set_zone_limit(&dp->conntrack, zone, limit);
+        unixctl_command_reply(conn, NULL);
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+}
+
+static void
+dpif_netdev_ct_zone_limit_del(struct unixctl_conn *conn, int argc,
+                              const char *argv[], void *aux OVS_UNUSED)
+{
+    unsigned int zone;
+
+    if (!str_to_uint(argv[argc - 1], 10, &zone) || zone > UINT16_MAX) {
+        unixctl_command_reply_error(conn, "invalid zone");
+        return;
+    }
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc - 1, argv);
+    if (dp) {
+        if (conntrack_del_zone_limit(&dp->conntrack, zone)) {
+            unixctl_command_reply(conn, NULL);
+        } else {
+            unixctl_command_reply_error(conn, "no limit for that zone");
+        }
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+}
+
+static void
+dpif_netdev_ct_zone_limit_list(struct unixctl_conn *conn, int argc,
+                               const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (dp) {
+        conntrack_format_zone_limits(&dp->conntrack, &reply);
+        unixctl_command_reply(conn, ds_cstr(&reply));
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_ct_timeout_policy_set(struct unixctl_conn *conn, int argc,
+                                  const char *argv[], void *aux OVS_UNUSED)
+{
+    unsigned int zone;
+
+    if (!str_to_uint(argv[argc - 2], 10, &zone) || zone > UINT16_MAX) {
+        unixctl_command_reply_error(conn, "invalid zone");
+        return;
+    }
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc - 2, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        return;
+    }
+
+    /* Parse a comma-separated list of NAME=SECONDS overrides. */
+    char *copy = xstrdup(argv[argc - 1]);
+    char *save_ptr = NULL;
+    int error = 0;
+
+    for (char *item = strtok_r(copy, ",", &save_ptr); item;
+         item = strtok_r(NULL, ",", &save_ptr)) {
+        char *eq = strchr(item, '=');
+        long long secs;
+
+        if (!eq || !str_to_llong(eq + 1, 10, &secs) || secs <= 0) {
+            error = EINVAL;
+            break;
+        }
+        *eq = '\0';
+        error = conntrack_set_zone_timeout(&dp->conntrack, zone, item,
+                                           secs * 1000);
+        if (error) {
+            break;
+        }
+    }
+    free(copy);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    if (error) {
+        unixctl_command_reply_error(conn, "invalid timeout policy, expected "
+                                    "a comma-separated list of NAME=SECONDS");
+    } else {
+        unixctl_command_reply(conn, NULL);
+    }
+}
+
+static void
+dpif_netdev_ct_timeout_policy_del(struct unixctl_conn *conn, int argc,
+                                  const char *argv[], void *aux OVS_UNUSED)
+{
+    unsigned int zone;
+
+    if (!str_to_uint(argv[argc - 1], 10, &zone) || zone > UINT16_MAX) {
+        unixctl_command_reply_error(conn, "invalid zone");
+        return;
+    }
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc - 1, argv);
+    if (dp) {
+        if (conntrack_del_zone_timeout_policy(&dp->conntrack, zone)) {
+            unixctl_command_reply(conn, NULL);
+        } else {
+            unixctl_command_reply_error(conn, "no policy for that zone");
+        }
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+}
+
+static void
+dpif_netdev_ct_timeout_policy_list(struct unixctl_conn *conn, int argc,
+                                   const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (dp) {
+        conntrack_format_zone_timeout_policies(&dp->conntrack, &reply);
+        unixctl_command_reply(conn, ds_cstr(&reply));
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_ct_event_log_set(struct unixctl_conn *conn, int argc,
+                             const char *argv[], void *aux OVS_UNUSED)
+{
+    const char *arg = argv[argc - 1];
+    bool enable;
+
+    if (!strcmp(arg, "on")) {
+        enable = true;
+    } else if (!strcmp(arg, "off")) {
+        enable = false;
+    } else {
+        unixctl_command_reply_error(conn, "expected \"on\" or \"off\"");
+        return;
+    }
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc - 1, argv);
+    if (dp) {
+        conntrack_set_event_log(&dp->conntrack, enable);
+        unixctl_command_reply(conn, NULL);
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+}
+
+static void
+dpif_netdev_ct_events(struct unixctl_conn *conn, int argc,
+                      const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (dp) {
+        conntrack_format_events(&dp->conntrack, &reply);
+        unixctl_command_reply(conn, ds_cstr(&reply));
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
+    ds_destroy(&reply);
+}
+
+/* Reports the NUMA placement of every polled rx queue relative to its
+ * polling thread, flagging cross-socket assignments.  The rxq scheduler
+ * already prefers same-node pmd threads; this shows where it could not. */
+static void
+dpif_netdev_numa_report(struct unixctl_conn *conn, int argc,
+                        const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    unsigned n_cross = 0, n_total = 0;
+    struct dp_netdev_port *port;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        ds_destroy(&reply);
+        return;
+    }
+
+    ovs_mutex_lock(&dp->port_mutex);
+    HMAP_FOR_EACH (port, node, &dp->ports) {
+        int port_numa = netdev_get_numa_id(port->netdev);
+
+        if (!netdev_is_pmd(port->netdev)) {
+            continue;
+        }
+        for (int qid = 0; qid < port->n_rxq; qid++) {
+            struct dp_netdev_rxq *q = &port->rxqs[qid];
+
+            if (!q->pmd) {
+                continue;
+            }
+            n_total++;
+            bool cross = port_numa != OVS_NUMA_UNSPEC
+                         && q->pmd->numa_id != OVS_NUMA_UNSPEC
+                         && port_numa != q->pmd->numa_id;
+            n_cross += cross;
+            ds_put_format(&reply,
+                          "port %s rxq %d (numa %d) -> pmd core %u "
+                          "(numa %d)%s\n",
+                          netdev_get_name(port->netdev), qid, port_numa,
+                          q->pmd->core_id, q->pmd->numa_id,
+                          cross ? "  [cross-numa]" : "");
+        }
+    }
+    ovs_mutex_unlock(&dp->port_mutex);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    ds_put_format(&reply, "%u of %u polled rx queues are served from a "
+                  "remote NUMA node.\n", n_cross, n_total);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+/* Writes the 1-of-N sample of 'batch' to the active capture, if it is
+ * for 'port_no'.  Runs only while a capture is active. */
+static void
+dp_netdev_capture_batch(struct dp_netdev *dp, odp_port_t port_no,
+                        struct dp_packet_batch *batch)
+{
+    struct dp_packet *packet;
+
+    ovs_mutex_lock(&dp->capture_mutex);
+    if (dp->capture_file && dp->capture_port == port_no) {
+        DP_PACKET_BATCH_FOR_EACH (packet, batch) {
+            if (dp->capture_count++ % dp->capture_rate == 0) {
+                ovs_pcap_write(dp->capture_file, packet);
+                dp->capture_taken++;
+            }
+        }
+    }
+    ovs_mutex_unlock(&dp->capture_mutex);
+}
+
+static void
+dpif_netdev_capture_start(struct unixctl_conn *conn, int argc,
+                          const char *argv[], void *aux OVS_UNUSED)
+{
+    unsigned int port, rate = 100;
+
+    /* argv: [dp] port file [rate] -- resolve positionally, treating
+     * argv[1] as a datapath name only if it names one. */
+    int i = 1;
+    struct ds reply = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp;
+    if (argc >= 4 && shash_find_data(&dp_netdevs, argv[1])) {
+        dp = shash_find_data(&dp_netdevs, argv[1]);
+        i = 2;
+    } else {
+        dp = shash_count(&dp_netdevs) == 1
+             ? shash_first(&dp_netdevs)->data : NULL;
+    }
+    if (!dp || argc < i + 2 || !str_to_uint(argv[i], 10, &port)
+        || (argc > i + 2 && !str_to_uint(argv[i + 2], 10, &rate)) || !rate) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        unixctl_command_reply_error(conn, "usage: [dp] port file [rate]");
+        ds_destroy(&reply);
+        return;
+    }
+
+    FILE *file = ovs_pcap_open(argv[i + 1], "wb");
+    if (!file) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        unixctl_command_reply_error(conn, "cannot open capture file");
+        ds_destroy(&reply);
+        return;
+    }
+
+    ovs_mutex_lock(&dp->capture_mutex);
+    if (dp->capture_file) {
+        fclose(dp->capture_file);
+    }
+    dp->capture_file = file;
+    dp->capture_port = u32_to_odp(port);
+    dp->capture_rate = rate;
+    dp->capture_count = 0;
+    dp->capture_taken = 0;
+    ovs_mutex_unlock(&dp->capture_mutex);
+    atomic_store_relaxed(&dp->capture_on, true);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    ds_put_format(&reply, "capturing 1/%u of port %u rx to %s",
+                  rate, port, argv[i + 1]);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_capture_stop(struct unixctl_conn *conn, int argc,
+                         const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds reply = DS_EMPTY_INITIALIZER;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        ds_destroy(&reply);
+        return;
+    }
+
+    atomic_store_relaxed(&dp->capture_on, false);
+    ovs_mutex_lock(&dp->capture_mutex);
+    if (dp->capture_file) {
+        fclose(dp->capture_file);
+        dp->capture_file = NULL;
+        ds_put_format(&reply, "captured %llu of %llu packets",
+                      dp->capture_taken, dp->capture_count);
+    } else {
+        ds_put_cstr(&reply, "no capture was active");
+    }
+    ovs_mutex_unlock(&dp->capture_mutex);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+/* Upper bound on the trace entries a pmd thread buffers before the ring
+ * must be drained with dpif-netdev/trace-show. */
+#define PMD_TRACE_MAX_ENTRIES 256
+
+struct dp_netdev_trace_entry {
+    struct ovs_list node;       /* In dp_netdev_pmd_thread's 'trace_entries'. */
+    char *text;
+};
+
+/* Records a trace of 'packet', which was classified in tier 'tier' and
+ * matched 'flow'.  Called from the packet processing path, but only while
+ * tracing is on and only for 1 of every 'trace_rate' packets. */
+static void
+dp_netdev_trace_packet(struct dp_netdev_pmd_thread *pmd, const char *tier,
+                       const struct dp_packet *packet,
+                       const struct dp_netdev_flow *flow)
+{
+    unsigned int rate;
+
+    atomic_read_relaxed(&pmd->dp->trace_rate, &rate);
+    ovs_mutex_lock(&pmd->trace_mutex);
+    if (pmd->trace_seen++ % rate == 0
+        && pmd->trace_n_entries < PMD_TRACE_MAX_ENTRIES) {
+        struct dp_netdev_trace_entry *e = xmalloc(sizeof *e);
+        struct ds s = DS_EMPTY_INITIALIZER;
+
+        const struct dp_netdev_actions *actions
+            = dp_netdev_flow_get_actions(flow);
+
+        ds_put_format(&s, "port %"PRIu32" %s ",
+                      odp_to_u32(packet->md.in_port.odp_port), tier);
+        odp_format_ufid(&flow->ufid, &s);
+        ds_put_cstr(&s, " actions:");
+        format_odp_actions(&s, actions->actions, actions->size, NULL);
+        e->text = ds_steal_cstr(&s);
+        ovs_list_push_back(&pmd->trace_entries, &e->node);
+        pmd->trace_n_entries++;
+    }
+    ovs_mutex_unlock(&pmd->trace_mutex);
+}
+
+static void
+dp_netdev_pmd_trace_clear(struct dp_netdev_pmd_thread *pmd)
+{
+    struct dp_netdev_trace_entry *e, *next;
+
+    ovs_mutex_lock(&pmd->trace_mutex);
+    LIST_FOR_EACH_SAFE (e, next, node, &pmd->trace_entries) {
+        ovs_list_remove(&e->node);
+        free(e->text);
+        free(e);
+    }
+    pmd->trace_n_entries = 0;
+    pmd->trace_seen = 0;
+    ovs_mutex_unlock(&pmd->trace_mutex);
+}
+
+static void
+dpif_netdev_trace_start(struct unixctl_conn *conn, int argc,
+                        const char *argv[], void *aux OVS_UNUSED)
+{
+    struct dp_netdev_pmd_thread *pmd;
+    unsigned int rate = 100;
+    int i = 1;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp;
+    if (argc > 1 && shash_find_data(&dp_netdevs, argv[1])) {
+        dp = shash_find_data(&dp_netdevs, argv[1]);
+        i = 2;
+    } else {
+        dp = shash_count(&dp_netdevs) == 1
+             ? shash_first(&dp_netdevs)->data : NULL;
+    }
+    if (!dp || argc > i + 1
+        || (argc > i && (!str_to_uint(argv[i], 10, &rate) || !rate))) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        unixctl_command_reply_error(conn, "usage: [dp] [rate]");
+        return;
+    }
+
+    CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+        dp_netdev_pmd_trace_clear(pmd);
+    }
+    atomic_store_relaxed(&dp->trace_rate, rate);
+    atomic_store_relaxed(&dp->trace_on, true);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    ds_put_format(&reply, "tracing 1/%u packets", rate);
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
+}
+
+static void
+dpif_netdev_trace_stop(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *aux OVS_UNUSED)
+{
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        return;
+    }
+    atomic_store_relaxed(&dp->trace_on, false);
+    ovs_mutex_unlock(&dp_netdev_mutex);
+    unixctl_command_reply(conn, "tracing stopped");
+}
+
+/* Drains the per-pmd trace rings, printing each distinct trace once with
+ * the number of times it was recorded. */
+static void
+dpif_netdev_trace_show(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *aux OVS_UNUSED)
+{
+    struct dp_netdev_trace_entry *e, *next;
+    struct dp_netdev_pmd_thread *pmd;
+    struct ds reply = DS_EMPTY_INITIALIZER;
+    struct simap agg = SIMAP_INITIALIZER(&agg);
+    unsigned long long seen = 0;
+
+    ovs_mutex_lock(&dp_netdev_mutex);
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
+    if (!dp) {
+        ovs_mutex_unlock(&dp_netdev_mutex);
+        return;
+    }
 
-    a = *(struct dp_netdev_pmd_thread **)a_;
-    b = *(struct dp_netdev_pmd_thread **)b_;
+    CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+        struct ovs_list entries;
+
+        ovs_mutex_lock(&pmd->trace_mutex);
+        ovs_list_move(&entries, &pmd->trace_entries);
+        ovs_list_init(&pmd->trace_entries);
+        pmd->trace_n_entries = 0;
+        seen += pmd->trace_seen;
+        pmd->trace_seen = 0;
+        ovs_mutex_unlock(&pmd->trace_mutex);
+
+        LIST_FOR_EACH_SAFE (e, next, node, &entries) {
+            ovs_list_remove(&e->node);
+            simap_increase(&agg, e->text, 1);
+            free(e->text);
+            free(e);
+        }
+    }
+    ovs_mutex_unlock(&dp_netdev_mutex);
 
-    if (a->core_id < b->core_id) {
-        return -1;
+    const struct simap_node **nodes = simap_sort(&agg);
+    for (size_t j = 0; j < simap_count(&agg); j++) {
+        ds_put_format(&reply, "%u x %s\n", nodes[j]->data, nodes[j]->name);
     }
-    if (a->core_id > b->core_id) {
-        return 1;
+    if (simap_is_empty(&agg)) {
+        ds_put_cstr(&reply, "no traces recorded\n");
     }
-    return 0;
+    ds_put_format(&reply, "%llu packets seen\n", seen);
+    free(nodes);
+    simap_destroy(&agg);
+
+    unixctl_command_reply(conn, ds_cstr(&reply));
+    ds_destroy(&reply);
 }
 
-/* Create a sorted list of pmd's from the dp->poll_threads cmap. We can use
- * this list, as long as we do not go to quiescent state. */
-static void
-sorted_poll_thread_list(struct dp_netdev *dp,
-                        struct dp_netdev_pmd_thread ***list,
-                        size_t *n)
+static const char *dp_drop_reason_names[DP_N_DROP_REASONS] = {
+    [DP_DROP_RX_RUNT]         = "rx-runt",
+    [DP_DROP_METER]           = "meter",
+    [DP_DROP_UPCALL_ERROR]    = "upcall-error",
+    [DP_DROP_UPCALL_DISABLED] = "upcall-disabled",
+    [DP_DROP_TUNNEL_PUSH]     = "tunnel-push-error",
+    [DP_DROP_TUNNEL_POP]      = "tunnel-pop-no-port",
+    [DP_DROP_INVALID_PORT]    = "output-no-port",
+    [DP_DROP_RECIRC_DEPTH]    = "recirc-depth",
+    [DP_DROP_HANDOFF_CLOSED]  = "handoff-closed",
+};
+
+struct dp_netdev_port_drops {
+    struct cmap_node node;      /* In dp_netdev's 'drop_stats'. */
+    odp_port_t port_no;
+    atomic_ullong n[DP_N_DROP_REASONS];
+};
+
+static struct dp_netdev_port_drops *
+dp_netdev_port_drops_find(struct dp_netdev *dp, odp_port_t port_no)
 {
-    struct dp_netdev_pmd_thread *pmd;
-    struct dp_netdev_pmd_thread **pmd_list;
-    size_t k = 0, n_pmds;
+    struct dp_netdev_port_drops *pd;
+    uint32_t hash = hash_int(odp_to_u32(port_no), 0);
 
-    n_pmds = cmap_count(&dp->poll_threads);
-    pmd_list = xcalloc(n_pmds, sizeof *pmd_list);
+    CMAP_FOR_EACH_WITH_HASH (pd, node, hash, &dp->drop_stats) {
+        if (pd->port_no == port_no) {
+            return pd;
+        }
+    }
+    return NULL;
+}
 
-    CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
-        if (k >= n_pmds) {
-            break;
+/* Charges 'n' drops of 'reason' on 'port_no'.  Cheap on the datapath
+ * side: drops are rare, so the on-demand entry creation and its mutex
+ * are off the common path. */
+static void
+dp_netdev_count_drop(struct dp_netdev *dp, odp_port_t port_no,
+                     enum dp_drop_reason reason, uint64_t n)
+{
+    struct dp_netdev_port_drops *pd = dp_netdev_port_drops_find(dp, port_no);
+
+    if (OVS_UNLIKELY(!pd)) {
+        ovs_mutex_lock(&dp->drop_stats_mutex);
+        pd = dp_netdev_port_drops_find(dp, port_no);
+        if (!pd) {
+            pd = xzalloc(sizeof *pd);
+            pd->port_no = port_no;
+            for (int i = 0; i < DP_N_DROP_REASONS; i++) {
+                atomic_init(&pd->n[i], 0);
+            }
+            cmap_insert(&dp->drop_stats, &pd->node,
+                        hash_int(odp_to_u32(port_no), 0));
         }
-        pmd_list[k++] = pmd;
+        ovs_mutex_unlock(&dp->drop_stats_mutex);
     }
 
-    qsort(pmd_list, k, sizeof *pmd_list, compare_poll_thread_list);
+    unsigned long long orig;
+    atomic_add_relaxed(&pd->n[reason], n, &orig);
+}
 
-    *list = pmd_list;
-    *n = k;
+/* Charges one drop of 'reason' per packet in 'batch', attributed to each
+ * packet's input port. */
+static void
+dp_netdev_count_batch_drop(struct dp_netdev *dp,
+                           const struct dp_packet_batch *batch,
+                           enum dp_drop_reason reason)
+{
+    struct dp_packet *packet;
+
+    DP_PACKET_BATCH_FOR_EACH (packet, batch) {
+        dp_netdev_count_drop(dp, packet->md.in_port.odp_port, reason, 1);
+    }
 }
 
 static void
-dpif_netdev_pmd_rebalance(struct unixctl_conn *conn, int argc,
-                          const char *argv[], void *aux OVS_UNUSED)
+dpif_netdev_drop_stats(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *aux OVS_UNUSED)
 {
+    struct dp_netdev_port_drops *pd;
     struct ds reply = DS_EMPTY_INITIALIZER;
-    struct dp_netdev *dp = NULL;
+    bool any = false;
 
     ovs_mutex_lock(&dp_netdev_mutex);
-
-    if (argc == 2) {
-        dp = shash_find_data(&dp_netdevs, argv[1]);
-    } else if (shash_count(&dp_netdevs) == 1) {
-        /* There's only one datapath */
-        dp = shash_first(&dp_netdevs)->data;
-    }
-
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
     if (!dp) {
         ovs_mutex_unlock(&dp_netdev_mutex);
-        unixctl_command_reply_error(conn,
-                                    "please specify an existing datapath");
         return;
     }
 
-    dp_netdev_request_reconfigure(dp);
+    CMAP_FOR_EACH (pd, node, &dp->drop_stats) {
+        bool port_named = false;
+
+        for (int i = 0; i < DP_N_DROP_REASONS; i++) {
+            unsigned long long n;
+
+            atomic_read_relaxed(&pd->n[i], &n);
+            if (n) {
+                if (!port_named) {
+                    ds_put_format(&reply, "port %"PRIu32":\n",
+                                  odp_to_u32(pd->port_no));
+                    port_named = true;
+                    any = true;
+                }
+                ds_put_format(&reply, "  %s: %llu\n",
+                              dp_drop_reason_names[i], n);
+            }
+        }
+    }
     ovs_mutex_unlock(&dp_netdev_mutex);
-    ds_put_cstr(&reply, "pmd rxq rebalance requested.\n");
+
+    if (!any) {
+        ds_put_cstr(&reply, "no drops recorded\n");
+    }
     unixctl_command_reply(conn, ds_cstr(&reply));
     ds_destroy(&reply);
 }
 
 static void
-dpif_netdev_pmd_info(struct unixctl_conn *conn, int argc, const char *argv[],
-                     void *aux)
+dpif_netdev_drop_stats_clear(struct unixctl_conn *conn, int argc,
+                             const char *argv[], void *aux OVS_UNUSED)
 {
-    struct ds reply = DS_EMPTY_INITIALIZER;
-    struct dp_netdev_pmd_thread **pmd_list;
-    struct dp_netdev *dp = NULL;
-    size_t n;
-    enum pmd_info_type type = *(enum pmd_info_type *) aux;
+    struct dp_netdev_port_drops *pd;
 
     ovs_mutex_lock(&dp_netdev_mutex);
-
-    if (argc == 2) {
-        dp = shash_find_data(&dp_netdevs, argv[1]);
-    } else if (shash_count(&dp_netdevs) == 1) {
-        /* There's only one datapath */
-        dp = shash_first(&dp_netdevs)->data;
-    }
-
+    struct dp_netdev *dp = dpif_netdev_find_dp(conn, argc, argv);
     if (!dp) {
         ovs_mutex_unlock(&dp_netdev_mutex);
-        unixctl_command_reply_error(conn,
-                                    "please specify an existing datapath");
         return;
     }
 
-    sorted_poll_thread_list(dp, &pmd_list, &n);
-    for (size_t i = 0; i < n; i++) {
-        struct dp_netdev_pmd_thread *pmd = pmd_list[i];
-        if (!pmd) {
-            break;
-        }
-
-        if (type == PMD_INFO_SHOW_RXQ) {
-            pmd_info_show_rxq(&reply, pmd);
-        } else {
-            unsigned long long stats[DP_N_STATS];
-            uint64_t cycles[PMD_N_CYCLES];
-
-            /* Read current stats and cycle counters */
-            for (size_t j = 0; j < ARRAY_SIZE(stats); j++) {
-                atomic_read_relaxed(&pmd->stats.n[j], &stats[j]);
-            }
-            for (size_t j = 0; j < ARRAY_SIZE(cycles); j++) {
-                atomic_read_relaxed(&pmd->cycles.n[j], &cycles[j]);
-            }
-
-            if (type == PMD_INFO_CLEAR_STATS) {
-                pmd_info_clear_stats(&reply, pmd, stats, cycles);
-            } else if (type == PMD_INFO_SHOW_STATS) {
-                pmd_info_show_stats(&reply, pmd, stats, cycles);
-            }
+    CMAP_FOR_EACH (pd, node, &dp->drop_stats) {
+        for (int i = 0; i < DP_N_DROP_REASONS; i++) {
+            atomic_store_relaxed(&pd->n[i], 0);
         }
     }
-    free(pmd_list);
-
     ovs_mutex_unlock(&dp_netdev_mutex);
-
-    unixctl_command_reply(conn, ds_cstr(&reply));
-    ds_destroy(&reply);
+    unixctl_command_reply(conn, NULL);
 }
-
+
 static int
 dpif_netdev_init(void)
 {
     static enum pmd_info_type show_aux = PMD_INFO_SHOW_STATS,
                               clear_aux = PMD_INFO_CLEAR_STATS,
-                              poll_aux = PMD_INFO_SHOW_RXQ;
+                              poll_aux = PMD_INFO_SHOW_RXQ,
+                              perf_aux = PMD_INFO_PERF_SHOW;
 
     unixctl_command_register("dpif-netdev/pmd-stats-show", "[dp]",
                              0, 1, dpif_netdev_pmd_info,
@@ -1126,6 +2244,62 @@ dpif_netdev_init(void)
     unixctl_command_register("dpif-netdev/pmd-rxq-show", "[dp]",
                              0, 1, dpif_netdev_pmd_info,
                              (void *)&poll_aux);
+    unixctl_command_register("dpif-netdev/pmd-perf-show", "[dp]",
+                             0, 1, dpif_netdev_pmd_info,
+                             (void *)&perf_aux);
+    unixctl_command_register("dpif-netdev/subtable-lookup-prio-get", "",
+                             0, 0, dpif_netdev_subtable_lookup_get,
+                             NULL);
+    unixctl_command_register("dpif-netdev/subtable-lookup-prio-set",
+                             "name prio", 2, 2,
+                             dpif_netdev_subtable_lookup_set,
+                             NULL);
+    unixctl_command_register("dpif-netdev/miniflow-parser-get", "",
+                             0, 0, dpif_netdev_miniflow_parser_get,
+                             NULL);
+    unixctl_command_register("dpif-netdev/miniflow-parser-set", "name",
+                             1, 1, dpif_netdev_miniflow_parser_set,
+                             NULL);
+    unixctl_command_register("dpif-netdev/ipf-get-status", "[dp]",
+                             0, 1, dpif_netdev_ipf_status,
+                             NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-limit-set",
+                             "[dp] zone limit", 2, 3,
+                             dpif_netdev_ct_zone_limit_set, NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-limit-del", "[dp] zone",
+                             1, 2, dpif_netdev_ct_zone_limit_del, NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-limit-list", "[dp]",
+                             0, 1, dpif_netdev_ct_zone_limit_list, NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-timeout-policy-set",
+                             "[dp] zone name=secs...", 2, 3,
+                             dpif_netdev_ct_timeout_policy_set, NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-timeout-policy-del",
+                             "[dp] zone", 1, 2,
+                             dpif_netdev_ct_timeout_policy_del, NULL);
+    unixctl_command_register("dpif-netdev/ct-zone-timeout-policy-list",
+                             "[dp]", 0, 1,
+                             dpif_netdev_ct_timeout_policy_list, NULL);
+    unixctl_command_register("dpif-netdev/ct-event-log-set", "[dp] on|off",
+                             1, 2, dpif_netdev_ct_event_log_set, NULL);
+    unixctl_command_register("dpif-netdev/ct-events", "[dp]", 0, 1,
+                             dpif_netdev_ct_events, NULL);
+    unixctl_command_register("dpif-netdev/numa-report", "[dp]", 0, 1,
+                             dpif_netdev_numa_report, NULL);
+    unixctl_command_register("dpif-netdev/capture-start",
+                             "[dp] port file [rate]", 2, 4,
+                             dpif_netdev_capture_start, NULL);
+    unixctl_command_register("dpif-netdev/capture-stop", "[dp]", 0, 1,
+                             dpif_netdev_capture_stop, NULL);
+    unixctl_command_register("dpif-netdev/trace-start", "[dp] [rate]", 0, 2,
+                             dpif_netdev_trace_start, NULL);
+    unixctl_command_register("dpif-netdev/trace-stop", "[dp]", 0, 1,
+                             dpif_netdev_trace_stop, NULL);
+    unixctl_command_register("dpif-netdev/trace-show", "[dp]", 0, 1,
+                             dpif_netdev_trace_show, NULL);
+    unixctl_command_register("dpif-netdev/drop-stats", "[dp]", 0, 1,
+                             dpif_netdev_drop_stats, NULL);
+    unixctl_command_register("dpif-netdev/drop-stats-clear", "[dp]", 0, 1,
+                             dpif_netdev_drop_stats_clear, NULL);
     unixctl_command_register("dpif-netdev/pmd-rxq-rebalance", "[dp]",
                              0, 1, dpif_netdev_pmd_rebalance,
                              NULL);
@@ -1261,6 +2435,21 @@ create_dp_netdev(const char *name, const struct dpif_class *class,
     conntrack_init(&dp->conntrack);
 
     atomic_init(&dp->emc_insert_min, DEFAULT_EM_FLOW_INSERT_MIN);
+    atomic_init(&dp->smc_enable_db, false);
+    atomic_init(&dp->tx_flush_interval, DEFAULT_TX_FLUSH_INTERVAL);
+    dp->pmd_iso = true;
+    atomic_init(&dp->pmd_max_sleep, 0);
+    atomic_init(&dp->steer_threshold, NETDEV_MAX_BURST);
+    atomic_init(&dp->meter_generation, 0);
+    atomic_init(&dp->capture_on, false);
+    ovs_mutex_init(&dp->capture_mutex);
+    atomic_init(&dp->trace_on, false);
+    atomic_init(&dp->trace_rate, 100);
+    cmap_init(&dp->drop_stats);
+    ovs_mutex_init(&dp->drop_stats_mutex);
+
+    dp->pmd_alb.rebalance_intvl = ALB_PMD_REBALANCE_POLL_INTERVAL;
+    dp->pmd_alb.load_threshold = ALB_PMD_LOAD_THRESHOLD;
 
     cmap_init(&dp->poll_threads);
 
@@ -1344,7 +2533,10 @@ dp_delete_meter(struct dp_netdev *dp, uint32_t meter_id)
     OVS_REQUIRES(dp->meter_locks[meter_id % N_METER_LOCKS])
 {
     if (dp->meters[meter_id]) {
-        free(dp->meters[meter_id]);
+        /* The pmd threads read 'meters[meter_id]' without taking the lock
+         * on their prepaid fast path (see dp_netdev_run_meter()), so the
+         * memory must survive until they quiesce. */
+        ovsrcu_postpone(free, dp->meters[meter_id]);
         dp->meters[meter_id] = NULL;
     }
 }
@@ -1376,6 +2568,22 @@ dp_netdev_free(struct dp_netdev *dp)
 
     conntrack_destroy(&dp->conntrack);
 
+    ovs_mutex_lock(&dp->capture_mutex);
+    if (dp->capture_file) {
+        fclose(dp->capture_file);
+        dp->capture_file = NULL;
+    }
+    ovs_mutex_unlock(&dp->capture_mutex);
+    ovs_mutex_destroy(&dp->capture_mutex);
+
+    struct dp_netdev_port_drops *pd;
+    CMAP_FOR_EACH (pd, node, &dp->drop_stats) {
+        cmap_remove(&dp->drop_stats, &pd->node,
+                    hash_int(odp_to_u32(pd->port_no), 0));
+        ovsrcu_postpone(free, pd);
+    }
+    cmap_destroy(&dp->drop_stats);
+    ovs_mutex_destroy(&dp->drop_stats_mutex);
 
     seq_destroy(dp->reconfigure_seq);
 
@@ -1468,8 +2676,12 @@ dpif_netdev_get_stats(const struct dpif *dpif, struct dpif_dp_stats *stats)
 
         atomic_read_relaxed(&pmd->stats.n[DP_STAT_MASKED_HIT], &n);
         stats->n_hit += n;
+        atomic_read_relaxed(&pmd->stats.n[DP_STAT_MARK_HIT], &n);
+        stats->n_hit += n;
         atomic_read_relaxed(&pmd->stats.n[DP_STAT_EXACT_HIT], &n);
         stats->n_hit += n;
+        atomic_read_relaxed(&pmd->stats.n[DP_STAT_SMC_HIT], &n);
+        stats->n_hit += n;
         atomic_read_relaxed(&pmd->stats.n[DP_STAT_MISS], &n);
         stats->n_missed += n;
         atomic_read_relaxed(&pmd->stats.n[DP_STAT_LOST], &n);
@@ -1832,6 +3044,246 @@ dp_netdev_pmd_find_dpcls(struct dp_netdev_pmd_thread *pmd,
     return cls;
 }
 
+#define INVALID_FLOW_MARK (UINT32_MAX)
+
+/* Association of offloaded megaflows with flow marks.  Marks are delivered
+ * with the packets by NICs that match the offloaded rule in hardware, and
+ * looked up in 'mark_to_flow' on receive to skip the software
+ * classification entirely.  Shared by all pmd threads; writers hold
+ * 'flow_mark_mutex', the datapath reads the cmaps under RCU. */
+struct megaflow_to_mark_data {
+    const struct cmap_node node;
+    ovs_u128 mega_ufid;
+    uint32_t mark;
+};
+
+static struct ovs_mutex flow_mark_mutex = OVS_MUTEX_INITIALIZER;
+static struct {
+    struct cmap megaflow_to_mark;
+    struct cmap mark_to_flow;
+    struct id_pool *pool;
+} flow_mark = {
+    .megaflow_to_mark = CMAP_INITIALIZER,
+    .mark_to_flow = CMAP_INITIALIZER,
+};
+
+static uint32_t
+flow_mark_alloc(void) OVS_REQUIRES(flow_mark_mutex)
+{
+    uint32_t mark;
+
+    if (!flow_mark.pool) {
+        /* Haven't initiated yet, do it here.  Mark 0 is reserved to mean
+         * "no mark" in the offload_info. */
+        flow_mark.pool = id_pool_create(1, INVALID_FLOW_MARK - 1);
+    }
+
+    if (id_pool_alloc_id(flow_mark.pool, &mark)) {
+        return mark;
+    }
+
+    return INVALID_FLOW_MARK;
+}
+
+static void
+flow_mark_free(uint32_t mark) OVS_REQUIRES(flow_mark_mutex)
+{
+    id_pool_free_id(flow_mark.pool, mark);
+}
+
+/* Remembers the mark chosen for 'mega_ufid'. */
+static void
+megaflow_to_mark_associate(const ovs_u128 *mega_ufid, uint32_t mark)
+    OVS_REQUIRES(flow_mark_mutex)
+{
+    size_t hash = dp_netdev_flow_hash(mega_ufid);
+    struct megaflow_to_mark_data *data = xzalloc(sizeof(*data));
+
+    data->mega_ufid = *mega_ufid;
+    data->mark = mark;
+
+    cmap_insert(&flow_mark.megaflow_to_mark,
+                CONST_CAST(struct cmap_node *, &data->node), hash);
+}
+
+static void
+megaflow_to_mark_disassociate(const ovs_u128 *mega_ufid)
+    OVS_REQUIRES(flow_mark_mutex)
+{
+    size_t hash = dp_netdev_flow_hash(mega_ufid);
+    struct megaflow_to_mark_data *data;
+
+    CMAP_FOR_EACH_WITH_HASH (data, node, hash,
+                             &flow_mark.megaflow_to_mark) {
+        if (ovs_u128_equals(*mega_ufid, data->mega_ufid)) {
+            cmap_remove(&flow_mark.megaflow_to_mark,
+                        CONST_CAST(struct cmap_node *, &data->node), hash);
+            ovsrcu_postpone(free, data);
+            return;
+        }
+    }
+
+    VLOG_WARN("Masked ufid "UUID_FMT" is not associated with a mark?",
+              UUID_ARGS((struct uuid *)mega_ufid));
+}
+
+static uint32_t
+megaflow_to_mark_find(const ovs_u128 *mega_ufid)
+    OVS_REQUIRES(flow_mark_mutex)
+{
+    size_t hash = dp_netdev_flow_hash(mega_ufid);
+    struct megaflow_to_mark_data *data;
+
+    CMAP_FOR_EACH_WITH_HASH (data, node, hash,
+                             &flow_mark.megaflow_to_mark) {
+        if (ovs_u128_equals(*mega_ufid, data->mega_ufid)) {
+            return data->mark;
+        }
+    }
+
+    return INVALID_FLOW_MARK;
+}
+
+/* Associates 'mark' with 'flow'.  The same mark is shared by the flows
+ * created from one megaflow on different pmd threads. */
+static void
+mark_to_flow_associate(const uint32_t mark, struct dp_netdev_flow *flow)
+    OVS_REQUIRES(flow_mark_mutex)
+{
+    dp_netdev_flow_ref(flow);
+
+    cmap_insert(&flow_mark.mark_to_flow,
+                CONST_CAST(struct cmap_node *, &flow->mark_node),
+                hash_int(mark, 0));
+    flow->mark = mark;
+
+    VLOG_DBG("Associated dp_netdev flow %p with mark %u", flow, mark);
+}
+
+static bool
+flow_mark_has_no_ref(uint32_t mark) OVS_REQUIRES(flow_mark_mutex)
+{
+    struct dp_netdev_flow *flow;
+
+    CMAP_FOR_EACH_WITH_HASH (flow, mark_node, hash_int(mark, 0),
+                             &flow_mark.mark_to_flow) {
+        if (flow->mark == mark) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int
+mark_to_flow_disassociate(struct dp_netdev_pmd_thread *pmd,
+                          struct dp_netdev_flow *flow)
+    OVS_REQUIRES(flow_mark_mutex)
+{
+    int ret = 0;
+    uint32_t mark = flow->mark;
+    struct cmap_node *mark_node = CONST_CAST(struct cmap_node *,
+                                             &flow->mark_node);
+
+    cmap_remove(&flow_mark.mark_to_flow, mark_node, hash_int(mark, 0));
+    flow->mark = INVALID_FLOW_MARK;
+
+    /* If the last reference to the mark is gone, remove the hardware rule
+     * and free the mark. */
+    if (flow_mark_has_no_ref(mark)) {
+        struct netdev *port;
+        odp_port_t in_port = flow->flow.in_port.odp_port;
+
+        port = netdev_ports_get(in_port, pmd->dp->class);
+        if (port) {
+            ret = netdev_flow_del(port, &flow->mega_ufid, NULL);
+            netdev_close(port);
+        }
+
+        flow_mark_free(mark);
+        VLOG_DBG("Freed flow mark %u", mark);
+
+        megaflow_to_mark_disassociate(&flow->mega_ufid);
+    }
+    dp_netdev_flow_unref(flow);
+
+    return ret;
+}
+
+/* Looks up the flow associated with 'mark' on this pmd thread, or NULL. */
+static struct dp_netdev_flow *
+mark_to_flow_find(const struct dp_netdev_pmd_thread *pmd,
+                  const uint32_t mark)
+{
+    struct dp_netdev_flow *flow;
+
+    CMAP_FOR_EACH_WITH_HASH (flow, mark_node, hash_int(mark, 0),
+                             &flow_mark.mark_to_flow) {
+        if (flow->mark == mark && flow->pmd_id == pmd->core_id
+            && flow->dead == false) {
+            return flow;
+        }
+    }
+
+    return NULL;
+}
+
+/* Tries to offload 'flow' to the NIC of its input port as a MARK + RSS
+ * rule, associating a flow mark on success.  Best effort: any failure
+ * leaves the flow handled entirely in software. */
+static void
+dp_netdev_try_flow_offload(struct dp_netdev_pmd_thread *pmd,
+                           struct dp_netdev_flow *flow, struct match *match,
+                           const struct nlattr *actions, size_t actions_len)
+{
+    struct offload_info info;
+    struct netdev *port;
+    uint32_t mark;
+    bool modification = false;
+    int ret;
+
+    ovs_mutex_lock(&flow_mark_mutex);
+
+    mark = megaflow_to_mark_find(&flow->mega_ufid);
+    if (mark != INVALID_FLOW_MARK) {
+        modification = true;
+    } else {
+        mark = flow_mark_alloc();
+        if (mark == INVALID_FLOW_MARK) {
+            VLOG_ERR("Failed to allocate flow mark!");
+            goto out;
+        }
+    }
+
+    port = netdev_ports_get(match->flow.in_port.odp_port, pmd->dp->class);
+    if (!port) {
+        if (!modification) {
+            flow_mark_free(mark);
+        }
+        goto out;
+    }
+
+    info.dpif_class = pmd->dp->class;
+    info.flow_mark = mark;
+    ret = netdev_flow_put(port, match, CONST_CAST(struct nlattr *, actions),
+                          actions_len, &flow->mega_ufid, &info, NULL);
+    netdev_close(port);
+
+    if (ret) {
+        if (!modification) {
+            flow_mark_free(mark);
+        }
+        goto out;
+    }
+
+    if (!modification) {
+        megaflow_to_mark_associate(&flow->mega_ufid, mark);
+    }
+    mark_to_flow_associate(mark, flow);
+out:
+    ovs_mutex_unlock(&flow_mark_mutex);
+}
+
 static void
 dp_netdev_pmd_remove_flow(struct dp_netdev_pmd_thread *pmd,
                           struct dp_netdev_flow *flow)
@@ -1845,6 +3297,11 @@ dp_netdev_pmd_remove_flow(struct dp_netdev_pmd_thread *pmd,
     ovs_assert(cls != NULL);
     dpcls_remove(cls, &flow->cr);
     cmap_remove(&pmd->flow_table, node, dp_netdev_flow_hash(&flow->ufid));
+    if (flow->mark != INVALID_FLOW_MARK) {
+        ovs_mutex_lock(&flow_mark_mutex);
+        mark_to_flow_disassociate(pmd, flow);
+        ovs_mutex_unlock(&flow_mark_mutex);
+    }
     flow->dead = true;
 
     dp_netdev_flow_unref(flow);
@@ -2165,7 +3622,8 @@ emc_probabilistic_insert(struct dp_netdev_pmd_thread *pmd,
     uint32_t min;
     atomic_read_relaxed(&pmd->dp->emc_insert_min, &min);
 
-    if (min && random_uint32() <= min) {
+    /* Avoid the PRNG call when every miss is inserted anyway. */
+    if (min == UINT32_MAX || (min && random_uint32() <= min)) {
         emc_insert(&pmd->flow_cache, key, flow);
     }
 }
@@ -2180,12 +3638,63 @@ emc_lookup(struct emc_cache *cache, const struct netdev_flow_key *key)
             && emc_entry_alive(current_entry)
             && netdev_flow_key_equal_mf(&current_entry->key, &key->mf)) {
 
-            /* We found the entry with the 'key->mf' miniflow */
-            return current_entry->flow;
-        }
+            /* We found the entry with the 'key->mf' miniflow */
+            return current_entry->flow;
+        }
+    }
+
+    return NULL;
+}
+
+/* Insert a mapping from 'key''s packet hash signature to the flow-table
+ * index of the flow whose 'flow_table' hash is 'hash'.  Does nothing if the
+ * SMC is disabled or if the flow's index does not fit in 16 bits. */
+static inline void
+smc_insert(struct dp_netdev_pmd_thread *pmd,
+           const struct netdev_flow_key *key,
+           uint32_t hash)
+{
+    struct smc_cache *smc_cache = &pmd->smc_cache;
+    struct smc_bucket *bucket = &smc_cache->buckets[key->hash & SMC_MASK];
+    uint16_t index;
+    uint32_t cmap_index;
+    bool smc_enable_db;
+    int i;
+
+    atomic_read_relaxed(&pmd->dp->smc_enable_db, &smc_enable_db);
+    if (!smc_enable_db) {
+        return;
+    }
+
+    cmap_index = cmap_find_index(&pmd->flow_table, hash);
+    index = (cmap_index >= UINT16_MAX) ? UINT16_MAX : (uint16_t) cmap_index;
+
+    /* If the index is larger than SMC can handle (uint16_t), the flow
+     * is not stored in the SMC. */
+    if (index == UINT16_MAX) {
+        return;
     }
 
-    return NULL;
+    /* If an entry with the same signature already exists, update its index. */
+    uint16_t sig = key->hash >> 16;
+    for (i = 0; i < SMC_ENTRY_PER_BUCKET; i++) {
+        if (bucket->sig[i] == sig) {
+            bucket->flow_idx[i] = index;
+            return;
+        }
+    }
+    /* If there is an empty entry, occupy it. */
+    for (i = 0; i < SMC_ENTRY_PER_BUCKET; i++) {
+        if (bucket->flow_idx[i] == UINT16_MAX) {
+            bucket->sig[i] = sig;
+            bucket->flow_idx[i] = index;
+            return;
+        }
+    }
+    /* Otherwise, pick a random entry. */
+    i = random_uint32() % SMC_ENTRY_PER_BUCKET;
+    bucket->sig[i] = sig;
+    bucket->flow_idx[i] = index;
 }
 
 static struct dp_netdev_flow *
@@ -2424,6 +3933,22 @@ out:
     return error;
 }
 
+/* Computes the unique identifier of the megaflow: the hash of the masked
+ * flow, shared by the flows installed from the same megaflow on different
+ * pmd threads. */
+static void
+dp_netdev_get_mega_ufid(const struct match *match, ovs_u128 *mega_ufid)
+{
+    struct flow masked_flow;
+    size_t i;
+
+    for (i = 0; i < sizeof(struct flow) / sizeof(uint64_t); i++) {
+        ((uint64_t *) &masked_flow)[i] = ((uint64_t *) &match->flow)[i] &
+                                         ((uint64_t *) &match->wc)[i];
+    }
+    dpif_flow_hash(NULL, &masked_flow, sizeof(struct flow), mega_ufid);
+}
+
 static struct dp_netdev_flow *
 dp_netdev_flow_add(struct dp_netdev_pmd_thread *pmd,
                    struct match *match, const ovs_u128 *ufid,
@@ -2459,12 +3984,14 @@ dp_netdev_flow_add(struct dp_netdev_pmd_thread *pmd,
     memset(&flow->stats, 0, sizeof flow->stats);
     flow->dead = false;
     flow->batch = NULL;
+    flow->mark = INVALID_FLOW_MARK;
     *CONST_CAST(unsigned *, &flow->pmd_id) = pmd->core_id;
     *CONST_CAST(struct flow *, &flow->flow) = match->flow;
     *CONST_CAST(ovs_u128 *, &flow->ufid) = *ufid;
     ovs_refcount_init(&flow->ref_cnt);
     ovsrcu_set(&flow->actions, dp_netdev_actions_create(actions, actions_len));
 
+    dp_netdev_get_mega_ufid(match, CONST_CAST(ovs_u128 *, &flow->mega_ufid));
     netdev_flow_key_init_masked(&flow->cr.flow, &match->flow, &mask);
 
     /* Select dpcls for in_port. Relies on in_port to be exact match. */
@@ -2474,6 +4001,10 @@ dp_netdev_flow_add(struct dp_netdev_pmd_thread *pmd,
     cmap_insert(&pmd->flow_table, CONST_CAST(struct cmap_node *, &flow->node),
                 dp_netdev_flow_hash(&flow->ufid));
 
+    if (netdev_is_flow_api_enabled()) {
+        dp_netdev_try_flow_offload(pmd, flow, match, actions, actions_len);
+    }
+
     if (OVS_UNLIKELY(!VLOG_DROP_DBG((&upcall_rl)))) {
         struct ds ds = DS_EMPTY_INITIALIZER;
         struct ofpbuf key_buf, mask_buf;
@@ -2726,10 +4257,12 @@ dpif_netdev_flow_del(struct dpif *dpif, const struct dpif_flow_del *del)
 
 struct dpif_netdev_flow_dump {
     struct dpif_flow_dump up;
-    struct cmap_position poll_thread_pos;
-    struct cmap_position flow_pos;
-    struct dp_netdev_pmd_thread *cur_pmd;
-    int status;
+    /* The shared state is only a dispenser of pmd threads: each dump
+     * thread claims whole pmds and walks their flow tables privately, so
+     * the threads dump different pmds in parallel and the mutex is taken
+     * once per pmd instead of once per batch. */
+    struct cmap_position poll_thread_pos OVS_GUARDED;
+    int status OVS_GUARDED;
     struct ovs_mutex mutex;
 };
 
@@ -2766,6 +4299,10 @@ dpif_netdev_flow_dump_destroy(struct dpif_flow_dump *dump_)
 struct dpif_netdev_flow_dump_thread {
     struct dpif_flow_dump_thread up;
     struct dpif_netdev_flow_dump *dump;
+    /* The pmd currently claimed by this thread (reference held) and the
+     * private iteration position within its flow table. */
+    struct dp_netdev_pmd_thread *cur_pmd;
+    struct cmap_position flow_pos;
     struct odputil_keybuf keybuf[FLOW_DUMP_MAX_BATCH];
     struct odputil_keybuf maskbuf[FLOW_DUMP_MAX_BATCH];
 };
@@ -2785,6 +4322,8 @@ dpif_netdev_flow_dump_thread_create(struct dpif_flow_dump *dump_)
     thread = xmalloc(sizeof *thread);
     dpif_flow_dump_thread_init(&thread->up, &dump->up);
     thread->dump = dump;
+    thread->cur_pmd = NULL;
+    memset(&thread->flow_pos, 0, sizeof thread->flow_pos);
     return &thread->up;
 }
 
@@ -2794,6 +4333,10 @@ dpif_netdev_flow_dump_thread_destroy(struct dpif_flow_dump_thread *thread_)
     struct dpif_netdev_flow_dump_thread *thread
         = dpif_netdev_flow_dump_thread_cast(thread_);
 
+    if (thread->cur_pmd) {
+        /* The dump ended before this thread exhausted its pmd. */
+        dp_netdev_pmd_unref(thread->cur_pmd);
+    }
     free(thread);
 }
 
@@ -2808,56 +4351,55 @@ dpif_netdev_flow_dump_next(struct dpif_flow_dump_thread *thread_,
     int n_flows = 0;
     int i;
 
-    ovs_mutex_lock(&dump->mutex);
-    if (!dump->status) {
-        struct dpif_netdev *dpif = dpif_netdev_cast(thread->up.dpif);
-        struct dp_netdev *dp = get_dp_netdev(&dpif->dpif);
-        struct dp_netdev_pmd_thread *pmd = dump->cur_pmd;
-        int flow_limit = MIN(max_flows, FLOW_DUMP_MAX_BATCH);
+    struct dpif_netdev *dpif = dpif_netdev_cast(thread->up.dpif);
+    struct dp_netdev *dp = get_dp_netdev(&dpif->dpif);
+    struct dp_netdev_pmd_thread *pmd = thread->cur_pmd;
+    int flow_limit = MIN(max_flows, FLOW_DUMP_MAX_BATCH);
 
-        /* First call to dump_next(), extracts the first pmd thread.
-         * If there is no pmd thread, returns immediately. */
+    for (;;) {
+        /* Claim a pmd thread if we do not hold one.  This is the only
+         * shared-state operation; the flow table walk below runs without
+         * any lock, under RCU, in parallel with the other dump threads. */
         if (!pmd) {
-            pmd = dp_netdev_pmd_get_next(dp, &dump->poll_thread_pos);
+            ovs_mutex_lock(&dump->mutex);
+            if (!dump->status) {
+                pmd = dp_netdev_pmd_get_next(dp, &dump->poll_thread_pos);
+                if (!pmd) {
+                    dump->status = EOF;
+                }
+            }
+            ovs_mutex_unlock(&dump->mutex);
             if (!pmd) {
-                ovs_mutex_unlock(&dump->mutex);
-                return n_flows;
-
+                thread->cur_pmd = NULL;
+                return 0;
             }
+            memset(&thread->flow_pos, 0, sizeof thread->flow_pos);
         }
 
-        do {
-            for (n_flows = 0; n_flows < flow_limit; n_flows++) {
-                struct cmap_node *node;
+        for (n_flows = 0; n_flows < flow_limit; n_flows++) {
+            struct cmap_node *node;
 
-                node = cmap_next_position(&pmd->flow_table, &dump->flow_pos);
-                if (!node) {
-                    break;
-                }
-                netdev_flows[n_flows] = CONTAINER_OF(node,
-                                                     struct dp_netdev_flow,
-                                                     node);
-            }
-            /* When finishing dumping the current pmd thread, moves to
-             * the next. */
-            if (n_flows < flow_limit) {
-                memset(&dump->flow_pos, 0, sizeof dump->flow_pos);
-                dp_netdev_pmd_unref(pmd);
-                pmd = dp_netdev_pmd_get_next(dp, &dump->poll_thread_pos);
-                if (!pmd) {
-                    dump->status = EOF;
-                    break;
-                }
+            node = cmap_next_position(&pmd->flow_table, &thread->flow_pos);
+            if (!node) {
+                break;
             }
-            /* Keeps the reference to next caller. */
-            dump->cur_pmd = pmd;
+            netdev_flows[n_flows] = CONTAINER_OF(node,
+                                                 struct dp_netdev_flow,
+                                                 node);
+        }
 
-            /* If the current dump is empty, do not exit the loop, since the
-             * remaining pmds could have flows to be dumped.  Just dumps again
-             * on the new 'pmd'. */
-        } while (!n_flows);
+        if (n_flows < flow_limit) {
+            /* This pmd is exhausted; release it.  If we got some flows,
+             * return them and claim the next pmd on the following call,
+             * otherwise claim it right away. */
+            dp_netdev_pmd_unref(pmd);
+            pmd = NULL;
+        }
+        if (n_flows) {
+            break;
+        }
     }
-    ovs_mutex_unlock(&dump->mutex);
+    thread->cur_pmd = pmd;
 
     for (i = 0; i < n_flows; i++) {
         struct odputil_keybuf *maskbuf = &thread->maskbuf[i];
@@ -2926,6 +4468,7 @@ dpif_netdev_execute(struct dpif *dpif, struct dpif_execute *execute)
     dp_netdev_execute_actions(pmd, &pp, false, execute->flow,
                               execute->actions, execute->actions_len,
                               time_msec());
+    dp_netdev_pmd_flush_output_packets(pmd, true);
 
     if (pmd->core_id == NON_PMD_CORE_ID) {
         ovs_mutex_unlock(&dp->non_pmd_mutex);
@@ -2963,6 +4506,105 @@ dpif_netdev_operate(struct dpif *dpif, struct dpif_op **ops, size_t n_ops)
     }
 }
 
+/* Enables or disables PMD auto load balancing, depending on the user
+ * configuration and on whether the datapath has at least two non-isolated
+ * pmd threads whose queues could be rebalanced. */
+static void
+set_pmd_auto_lb(struct dp_netdev *dp)
+{
+    struct pmd_auto_lb *pmd_alb = &dp->pmd_alb;
+    struct dp_netdev_pmd_thread *pmd;
+    bool enable = false;
+
+    if (pmd_alb->auto_lb_requested) {
+        int n_pmds = 0;
+
+        CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+            if (pmd->core_id != NON_PMD_CORE_ID && !pmd->isolated) {
+                n_pmds++;
+            }
+        }
+        enable = n_pmds > 1;
+    }
+
+    if (enable != pmd_alb->is_enabled) {
+        pmd_alb->is_enabled = enable;
+        if (enable) {
+            pmd_alb->rebalance_poll_timer = time_msec();
+            VLOG_INFO("PMD auto load balance is enabled");
+        } else {
+            VLOG_INFO("PMD auto load balance is disabled");
+        }
+    }
+}
+
+/* Compares the load of the non-isolated pmd threads measured since the
+ * previous check and requests a datapath reconfiguration if the spread
+ * between the most and the least loaded thread exceeds the configured
+ * threshold.  The reconfiguration reassigns the non-pinned rx queues to the
+ * pmd threads based on their measured processing cycles, so repeating it
+ * while traffic is skewed migrates queues away from the overloaded pmds. */
+static void
+pmd_auto_lb_check(struct dp_netdev *dp)
+{
+    struct pmd_auto_lb *pmd_alb = &dp->pmd_alb;
+    uint64_t max_load = 0, min_load = UINT64_MAX;
+    struct dp_netdev_pmd_thread *pmd;
+    long long int now = time_msec();
+
+    if (!pmd_alb->is_enabled) {
+        return;
+    }
+
+    if (now < pmd_alb->rebalance_poll_timer
+              + (long long int) pmd_alb->rebalance_intvl) {
+        return;
+    }
+    pmd_alb->rebalance_poll_timer = now;
+
+    CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+        uint64_t cycles[PMD_N_CYCLES];
+        uint64_t total = 0;
+        int i;
+
+        if (pmd->core_id == NON_PMD_CORE_ID) {
+            continue;
+        }
+
+        /* Measure the cycles spent since the previous check and snapshot
+         * the counters for the next one. */
+        for (i = 0; i < PMD_N_CYCLES; i++) {
+            atomic_read_relaxed(&pmd->cycles.n[i], &cycles[i]);
+            uint64_t prev = pmd->alb_prev_cycles[i];
+            pmd->alb_prev_cycles[i] = cycles[i];
+            cycles[i] -= prev;
+            total += cycles[i];
+        }
+
+        /* Isolated pmd threads keep their pinned queues whatever their
+         * load, so they cannot be rebalanced. */
+        if (pmd->isolated || !total) {
+            continue;
+        }
+
+        uint64_t busy = cycles[PMD_CYCLES_PROCESSING] * 100 / total;
+        max_load = MAX(max_load, busy);
+        min_load = MIN(min_load, busy);
+    }
+
+    if (min_load == UINT64_MAX
+        || max_load - min_load <= pmd_alb->load_threshold) {
+        return;
+    }
+
+    VLOG_INFO("PMD auto load balance: pmd thread load spread is %"PRIu64"%% "
+              "(max %"PRIu64"%%, min %"PRIu64"%%), above the %"PRIu32"%% "
+              "threshold.  Requesting rxq rebalance.",
+              max_load - min_load, max_load, min_load,
+              pmd_alb->load_threshold);
+    dp_netdev_request_reconfigure(dp);
+}
+
 /* Applies datapath configuration from the database. Some of the changes are
  * actually applied in dpif_netdev_run(). */
 static int
@@ -2999,6 +4641,86 @@ dpif_netdev_set_config(struct dpif *dpif, const struct smap *other_config)
         }
     }
 
+    bool smc_enable = smap_get_bool(other_config, "smc-enable", false);
+    bool cur_smc;
+    atomic_read_relaxed(&dp->smc_enable_db, &cur_smc);
+    if (smc_enable != cur_smc) {
+        atomic_store_relaxed(&dp->smc_enable_db, smc_enable);
+        if (smc_enable) {
+            VLOG_INFO("SMC cache is enabled");
+        } else {
+            VLOG_INFO("SMC cache is disabled");
+        }
+    }
+
+    uint32_t tx_flush_interval, cur_tx_flush_interval;
+
+    tx_flush_interval = smap_get_int(other_config, "tx-flush-interval",
+                                     DEFAULT_TX_FLUSH_INTERVAL);
+    atomic_read_relaxed(&dp->tx_flush_interval, &cur_tx_flush_interval);
+    if (tx_flush_interval != cur_tx_flush_interval) {
+        atomic_store_relaxed(&dp->tx_flush_interval, tx_flush_interval);
+        VLOG_INFO("Flushing interval for tx queues set to %"PRIu32" us",
+                  tx_flush_interval);
+    }
+
+    unsigned long long pmd_max_sleep, cur_pmd_max_sleep;
+
+    pmd_max_sleep = smap_get_ullong(other_config, "pmd-maxsleep", 0);
+    pmd_max_sleep = MIN(pmd_max_sleep, PMD_SLEEP_MAX_US);
+    atomic_read_relaxed(&dp->pmd_max_sleep, &cur_pmd_max_sleep);
+    if (pmd_max_sleep != cur_pmd_max_sleep) {
+        atomic_store_relaxed(&dp->pmd_max_sleep, pmd_max_sleep);
+        VLOG_INFO("PMD max sleep request is %llu usecs.", pmd_max_sleep);
+        VLOG_INFO("PMD load based sleeps are %s.",
+                  pmd_max_sleep ? "enabled" : "disabled");
+    }
+
+    uint32_t steer_threshold, cur_steer_threshold;
+
+    steer_threshold = smap_get_ullong(other_config,
+                                      "cross-pmd-steering-threshold",
+                                      NETDEV_MAX_BURST);
+    steer_threshold = MAX(1, MIN(steer_threshold, NETDEV_MAX_BURST));
+    atomic_read_relaxed(&dp->steer_threshold, &cur_steer_threshold);
+    if (steer_threshold != cur_steer_threshold) {
+        atomic_store_relaxed(&dp->steer_threshold, steer_threshold);
+        VLOG_INFO("Cross-pmd steering threshold set to %"PRIu32" packets.",
+                  steer_threshold);
+    }
+
+    bool pmd_iso = smap_get_bool(other_config, "pmd-rxq-isolate", true);
+    if (dp->pmd_iso != pmd_iso) {
+        dp->pmd_iso = pmd_iso;
+        VLOG_INFO("pmd-rxq-isolate %s: cores with pinned rx queues will%s be "
+                  "excluded from the scheduling of non-pinned queues",
+                  pmd_iso ? "enabled" : "disabled", pmd_iso ? "" : " not");
+        dp_netdev_request_reconfigure(dp);
+    }
+
+    struct pmd_auto_lb *pmd_alb = &dp->pmd_alb;
+    pmd_alb->auto_lb_requested = smap_get_bool(other_config, "pmd-auto-lb",
+                                               false);
+
+    /* Input is in minutes; 0 or an overflowing value selects the default. */
+    uint64_t rebalance_intvl =
+        smap_get_ullong(other_config, "pmd-auto-lb-rebal-interval", 0);
+    if (!rebalance_intvl || rebalance_intvl > UINT64_MAX / (60 * 1000)) {
+        rebalance_intvl = ALB_PMD_REBALANCE_POLL_INTERVAL;
+    } else {
+        rebalance_intvl *= 60 * 1000;
+    }
+    pmd_alb->rebalance_intvl = rebalance_intvl;
+
+    uint64_t load_threshold =
+        smap_get_ullong(other_config, "pmd-auto-lb-load-threshold",
+                        ALB_PMD_LOAD_THRESHOLD);
+    if (load_threshold > 100) {
+        load_threshold = ALB_PMD_LOAD_THRESHOLD;
+    }
+    pmd_alb->load_threshold = load_threshold;
+
+    set_pmd_auto_lb(dp);
     return 0;
 }
 
@@ -3071,11 +4793,45 @@ dpif_netdev_port_set_config(struct dpif *dpif, odp_port_t port_no,
     struct dp_netdev_port *port;
     int error = 0;
     const char *affinity_list = smap_get(cfg, "pmd-rxq-affinity");
+    bool steering = smap_get_bool(cfg, "cross-pmd-steering", false);
 
     ovs_mutex_lock(&dp->port_mutex);
     error = get_port_by_number(dp, port_no, &port);
-    if (error || !netdev_is_pmd(port->netdev)
-        || nullable_string_is_equal(affinity_list, port->rxq_affinity_list)) {
+    if (error || !netdev_is_pmd(port->netdev)) {
+        goto unlock;
+    }
+
+    if (steering != port->cross_pmd_steering) {
+        struct dp_netdev_pmd_thread *pmd;
+
+        port->cross_pmd_steering = steering;
+        VLOG_INFO("%s: cross-pmd steering %s",
+                  netdev_get_name(port->netdev),
+                  steering ? "enabled" : "disabled");
+
+        /* The pmds cache the flag in their poll lists, and a flag-only
+         * change does not alter the rxq scheduling, so a datapath
+         * reconfiguration would not reload them.  Reload the pmds that
+         * poll this port directly. */
+        CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+            struct rxq_poll *poll;
+            bool found = false;
+
+            ovs_mutex_lock(&pmd->port_mutex);
+            HMAP_FOR_EACH (poll, node, &pmd->poll_list) {
+                if (poll->rxq->port == port) {
+                    found = true;
+                    break;
+                }
+            }
+            ovs_mutex_unlock(&pmd->port_mutex);
+            if (found) {
+                dp_netdev_reload_pmd__(pmd);
+            }
+        }
+    }
+
+    if (nullable_string_is_equal(affinity_list, port->rxq_affinity_list)) {
         goto unlock;
     }
 
@@ -3112,6 +4868,15 @@ dp_netdev_actions_create(const struct nlattr *actions, size_t size)
     memcpy(netdev_actions->actions, actions, size);
     netdev_actions->size = size;
 
+    /* Most flows just forward to another port: recognize an action list
+     * that consists of a single OUTPUT so that execution can bypass the
+     * generic action machinery (see packet_batch_per_flow_execute()). */
+    netdev_actions->simple_output =
+        size && nl_attr_type(actions) == OVS_ACTION_ATTR_OUTPUT
+        && NLA_ALIGN(actions->nla_len) == size;
+    netdev_actions->output_port =
+        netdev_actions->simple_output ? nl_attr_get_odp_port(actions) : 0;
+
     return netdev_actions;
 }
 
@@ -3212,22 +4977,278 @@ dp_netdev_rxq_get_intrvl_cycles(struct dp_netdev_rxq *rx, unsigned idx)
     return processing_cycles;
 }
 
+/* The tx queue id is a property of the sending thread, not of the
+ * packets: a static per-pmd qid (or an XPS-assigned one) is what makes
+ * netdev_send() safe without a lock.  Selecting the queue from packet
+ * DSCP or skb_priority instead - to map traffic classes onto NIC
+ * PFC/ETS queues - would make every queue potentially shared between
+ * pmds, so each send would need 'concurrent_txq' locking, and the port
+ * would have to provision n_pmds * n_classes queues to get that
+ * lock-freedom back.  On top of that the lossless-class guarantees
+ * come from NIC DCB configuration that the netdev layer here has no
+ * interface for.  If traffic-class queueing is ever added, it belongs
+ * in the netdev provider (mapping a class hint to a ring at send
+ * time), not in this per-thread qid. */
+static int
+dp_netdev_pmd_flush_output_on_port(struct dp_netdev_pmd_thread *pmd,
+                                   struct tx_port *p)
+{
+    int tx_qid;
+    int output_cnt;
+    bool dynamic_txqs;
+
+    if (dp_packet_batch_is_empty(&p->output_pkts)) {
+        return 0;
+    }
+
+    dynamic_txqs = p->port->dynamic_txqs;
+    if (dynamic_txqs) {
+        tx_qid = dpif_netdev_xps_get_tx_qid(pmd, p, time_msec());
+    } else {
+        tx_qid = pmd->static_tx_qid;
+    }
+
+    output_cnt = dp_packet_batch_size(&p->output_pkts);
+    netdev_send(p->port->netdev, tx_qid, &p->output_pkts, true, dynamic_txqs);
+    dp_packet_batch_init(&p->output_pkts);
+    pmd->n_output_batches--;
+
+    return output_cnt;
+}
+
+/* Sends the packets queued on the tx ports of 'pmd'.  If 'force' is false,
+ * only the batches whose flush time has been reached are sent.  Returns the
+ * number of packets sent. */
+static int
+dp_netdev_pmd_flush_output_packets(struct dp_netdev_pmd_thread *pmd,
+                                   bool force)
+{
+    struct tx_port *p;
+    int output_cnt = 0;
+
+    if (!pmd->n_output_batches) {
+        return 0;
+    }
+
+    long long now = force ? 0 : time_usec();
+    HMAP_FOR_EACH (p, node, &pmd->send_port_cache) {
+        if (!dp_packet_batch_is_empty(&p->output_pkts)
+            && (force || now >= p->flush_time)) {
+            output_cnt += dp_netdev_pmd_flush_output_on_port(pmd, p);
+        }
+    }
+    return output_cnt;
+}
+
+/* Looks up (and caches) a peer pmd thread on the same NUMA node to steer
+ * packets to.  Returns NULL if there is none. */
+static struct dp_netdev_pmd_thread *
+pmd_steering_peer(struct dp_netdev_pmd_thread *pmd)
+{
+    struct dp_netdev_pmd_thread *peer;
+
+    if (pmd->steer_dst) {
+        return pmd->steer_dst;
+    }
+
+    CMAP_FOR_EACH (peer, node, &pmd->dp->poll_threads) {
+        if (peer != pmd && peer->core_id != NON_PMD_CORE_ID
+            && peer->numa_id == pmd->numa_id && !peer->isolated
+            && dp_netdev_pmd_try_ref(peer)) {
+            pmd->steer_dst = peer;
+            return peer;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+pmd_steering_peer_reset(struct dp_netdev_pmd_thread *pmd)
+{
+    if (pmd->steer_dst) {
+        dp_netdev_pmd_unref(pmd->steer_dst);
+        pmd->steer_dst = NULL;
+    }
+}
+
+/* Hands roughly half of 'batch' (chosen by packet hash, so that flows are
+ * not reordered) off to a peer pmd thread.  Packets that cannot be handed
+ * off, including the case of no peer or a full peer queue, are kept in
+ * 'batch' for local processing.  Metadata is initialized here since the
+ * peer does not know the input port. */
+static void
+dp_netdev_steer_packets(struct dp_netdev_pmd_thread *pmd,
+                        odp_port_t port_no, struct dp_packet_batch *batch)
+{
+    struct dp_netdev_pmd_thread *peer = pmd_steering_peer(pmd);
+    struct dp_packet_batch keep, give;
+    struct dp_packet *packet;
+
+    if (!peer) {
+        /* No peer also means no queue that could still hold our
+         * packets. */
+        pmd->steering_sticky = false;
+        return;
+    }
+
+    dp_packet_batch_init(&keep);
+    dp_packet_batch_init(&give);
+
+    DP_PACKET_BATCH_FOR_EACH (packet, batch) {
+        uint32_t hash;
+
+        pkt_metadata_init(&packet->md, port_no);
+        if (dp_packet_rss_valid(packet)) {
+            hash = dp_packet_get_rss_hash(packet);
+        } else if (dp_packet_size(packet) >= ETH_HEADER_LEN) {
+            /* No NIC hash: split on the Ethernet addresses, which is
+             * coarse but keeps every flow in order. */
+            hash = hash_bytes(dp_packet_data(packet), 2 * ETH_ADDR_LEN, 0);
+        } else {
+            dp_packet_batch_add(&keep, packet);
+            continue;
+        }
+
+        if (hash & 1) {
+            dp_packet_batch_add(&give, packet);
+        } else {
+            dp_packet_batch_add(&keep, packet);
+        }
+    }
+
+    if (!dp_packet_batch_is_empty(&give)) {
+        struct dp_packet_batch *givep = &give;
+        bool accepted = false;
+
+        ovs_mutex_lock(&peer->handoff_mutex);
+        if (!peer->handoff_closed
+            && dp_packet_batch_size(&peer->handoff_batch)
+               + dp_packet_batch_size(&give) <= NETDEV_MAX_BURST) {
+            DP_PACKET_BATCH_FOR_EACH (packet, givep) {
+                dp_packet_batch_add(&peer->handoff_batch, packet);
+            }
+            accepted = true;
+        }
+        pmd->steering_sticky = !peer->handoff_closed
+            && (!dp_packet_batch_is_empty(&peer->handoff_batch)
+                || peer->handoff_draining);
+        ovs_mutex_unlock(&peer->handoff_mutex);
+
+        if (!accepted) {
+            /* Peer saturated or gone: process locally. */
+            DP_PACKET_BATCH_FOR_EACH (packet, givep) {
+                dp_packet_batch_add(&keep, packet);
+            }
+        }
+    } else if (pmd->steering_sticky) {
+        /* Nothing to hand off this time: revert to local-only processing
+         * only once the peer has fully drained, so a flow's newer packets
+         * cannot overtake its older ones. */
+        ovs_mutex_lock(&peer->handoff_mutex);
+        pmd->steering_sticky = !peer->handoff_closed
+            && (!dp_packet_batch_is_empty(&peer->handoff_batch)
+                || peer->handoff_draining);
+        ovs_mutex_unlock(&peer->handoff_mutex);
+    }
+
+    *batch = keep;
+}
+
+/* Processes the packets queued by peers, if any.  Returns the number of
+ * packets processed. */
+static int
+dp_netdev_pmd_drain_handoff(struct dp_netdev_pmd_thread *pmd)
+{
+    struct dp_packet_batch batch;
+
+    /* Cheap racy emptiness check: a missed batch is picked up on the next
+     * iteration. */
+    if (OVS_LIKELY(dp_packet_batch_is_empty(&pmd->handoff_batch))) {
+        return 0;
+    }
+
+    ovs_mutex_lock(&pmd->handoff_mutex);
+    batch = pmd->handoff_batch;
+    dp_packet_batch_init(&pmd->handoff_batch);
+    /* Keep producers steering until these packets are transmitted, not
+     * just dequeued (see 'steering_sticky'). */
+    pmd->handoff_draining = !dp_packet_batch_is_empty(&batch);
+    ovs_mutex_unlock(&pmd->handoff_mutex);
+
+    if (dp_packet_batch_is_empty(&batch)) {
+        return 0;
+    }
+
+    *recirc_depth_get() = 0;
+    int cnt = dp_packet_batch_size(&batch);
+    dp_netdev_recirculate(pmd, &batch);
+    /* Force the flush: with a tx-flush-interval the packets could
+     * otherwise stay queued in 'output_pkts' past the point where
+     * producers observe "drained" and revert to local processing, which
+     * would reorder the flows this flag exists to protect. */
+    dp_netdev_pmd_flush_output_packets(pmd, true);
+
+    ovs_mutex_lock(&pmd->handoff_mutex);
+    pmd->handoff_draining = false;
+    ovs_mutex_unlock(&pmd->handoff_mutex);
+
+    return cnt;
+}
+
 static int
 dp_netdev_process_rxq_port(struct dp_netdev_pmd_thread *pmd,
                            struct netdev_rxq *rx,
-                           odp_port_t port_no)
+                           odp_port_t port_no, bool steer)
 {
     struct dp_packet_batch batch;
     int error;
     int batch_cnt = 0;
 
+    uint64_t t_poll = cycles_counter();
+
     dp_packet_batch_init(&batch);
     error = netdev_rxq_recv(rx, &batch);
     if (!error) {
         *recirc_depth_get() = 0;
 
+        uint64_t t_input = cycles_counter();
+
         batch_cnt = batch.count;
-        dp_netdev_input(pmd, &batch, port_no);
+        histogram_add_sample(&pmd->perf_stats.pkts_per_batch, batch_cnt);
+
+        bool capture_on;
+        atomic_read_relaxed(&pmd->dp->capture_on, &capture_on);
+        if (OVS_UNLIKELY(capture_on)) {
+            dp_netdev_capture_batch(pmd->dp, port_no, &batch);
+        }
+
+        uint32_t steer_threshold;
+
+        atomic_read_relaxed(&pmd->dp->steer_threshold, &steer_threshold);
+        if (OVS_UNLIKELY(steer)
+            && (batch_cnt >= steer_threshold || pmd->steering_sticky)
+            && pmd->core_id != NON_PMD_CORE_ID) {
+            /* The full burst suggests the thread cannot keep up: offer a
+             * share to a peer.  The split also stays in force while the
+             * peer still holds earlier handed-off packets, so flows are
+             * not reordered when the load drops below the threshold. */
+            dp_netdev_steer_packets(pmd, port_no, &batch);
+        }
+        if (!dp_packet_batch_is_empty(&batch)) {
+            dp_netdev_input(pmd, &batch, port_no);
+        }
+
+        uint64_t t_flush = cycles_counter();
+
+        dp_netdev_pmd_flush_output_packets(pmd, false);
+
+        pmd_perf_add_stage_cycles(&pmd->perf_stats, PMD_STAGE_RX,
+                                  t_input - t_poll);
+        pmd_perf_add_stage_cycles(&pmd->perf_stats, PMD_STAGE_DATAPATH,
+                                  t_flush - t_input);
+        pmd_perf_add_stage_cycles(&pmd->perf_stats, PMD_STAGE_TX,
+                                  cycles_counter() - t_flush);
     } else if (error != EAGAIN && error != EOPNOTSUPP) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
 
@@ -3487,7 +5508,10 @@ rxq_scheduling(struct dp_netdev *dp, bool pinned) OVS_REQUIRES(dp->port_mutex)
                               q->core_id, qid, netdev_get_name(port->netdev));
                 } else {
                     q->pmd = pmd;
-                    pmd->isolated = true;
+                    /* With pmd-rxq-isolate disabled, pinned cores stay
+                     * available to the round-robin scheduling of the
+                     * non-pinned queues. */
+                    pmd->isolated = dp->pmd_iso;
                     dp_netdev_pmd_unref(pmd);
                 }
             } else if (!pinned && q->core_id == OVS_CORE_UNSPEC) {
@@ -3562,6 +5586,20 @@ reload_affected_pmds(struct dp_netdev *dp)
     }
 }
 
+/* Reconfiguration is already incremental: only pmd threads whose core
+ * went away are destroyed and only missing ones are created, so changing
+ * pmd-cpu-mask does not restart the surviving threads.  What is still
+ * lost is the state of destroyed threads and of rx queues that move to a
+ * different thread: flows, the EMC and the classifier are per-pmd, so
+ * the traffic that moves re-populates them through upcalls.  Migrating
+ * dp_netdev_flow tables between threads instead has been considered, but
+ * every flow is tied to its owner's dpcls instance, flow_mutex, stats
+ * and tx qid, and the single-owner assumption is what keeps the fast
+ * path lock-free, so a handover would need a cross-thread quiesce of
+ * exactly the kind this path avoids.  The practical mitigation is that
+ * moved traffic still hits the flows installed by revalidators after a
+ * one-time upcall per megaflow, and rebalancing can be done a queue at a
+ * time via pmd-rxq-affinity to bound the transient. */
 static void
 reconfigure_pmd_threads(struct dp_netdev *dp)
     OVS_REQUIRES(dp->port_mutex)
@@ -3821,6 +5859,9 @@ reconfigure_datapath(struct dp_netdev *dp)
 
     /* Reload affected pmd threads. */
     reload_affected_pmds(dp);
+
+    /* The isolation state of the pmd threads may have changed. */
+    set_pmd_auto_lb(dp);
 }
 
 /* Returns true if one of the netdevs in 'dp' requires a reconfiguration */
@@ -3862,7 +5903,7 @@ dpif_netdev_run(struct dpif *dpif)
                     process_packets =
                         dp_netdev_process_rxq_port(non_pmd,
                                                    port->rxqs[i].rx,
-                                                   port->port_no);
+                                                   port->port_no, false);
                     cycles_count_intermediate(non_pmd, NULL,
                                               process_packets
                                               ? PMD_CYCLES_PROCESSING
@@ -3870,6 +5911,7 @@ dpif_netdev_run(struct dpif *dpif)
                 }
             }
         }
+        dp_netdev_pmd_flush_output_packets(non_pmd, false);
         cycles_count_end(non_pmd, PMD_CYCLES_IDLE);
         dpif_netdev_xps_revalidate_pmd(non_pmd, time_msec(), false);
         ovs_mutex_unlock(&dp->non_pmd_mutex);
@@ -3877,6 +5919,8 @@ dpif_netdev_run(struct dpif *dpif)
         dp_netdev_pmd_unref(non_pmd);
     }
 
+    pmd_auto_lb_check(dp);
+
     if (dp_netdev_is_reconf_required(dp) || ports_require_restart(dp)) {
         reconfigure_datapath(dp);
     }
@@ -3921,6 +5965,9 @@ pmd_free_cached_ports(struct dp_netdev_pmd_thread *pmd)
 {
     struct tx_port *tx_port_cached;
 
+    /* Flush all the queued packets. */
+    dp_netdev_pmd_flush_output_packets(pmd, true);
+
     /* Free all used tx queue ids. */
     dpif_netdev_xps_revalidate_pmd(pmd, 0, true);
 
@@ -3955,6 +6002,7 @@ pmd_load_cached_ports(struct dp_netdev_pmd_thread *pmd)
 
         if (netdev_n_txq(tx_port->port->netdev)) {
             tx_port_cached = xmemdup(tx_port, sizeof *tx_port_cached);
+            dp_packet_batch_init(&tx_port_cached->output_pkts);
             hmap_insert(&pmd->send_port_cache, &tx_port_cached->node,
                         hash_port_no(tx_port_cached->port->port_no));
         }
@@ -3999,6 +6047,7 @@ pmd_load_queues_and_ports(struct dp_netdev_pmd_thread *pmd,
     HMAP_FOR_EACH (poll, node, &pmd->poll_list) {
         poll_list[i].rxq = poll->rxq;
         poll_list[i].port_no = poll->rxq->port->port_no;
+        poll_list[i].steer = poll->rxq->port->cross_pmd_steering;
         i++;
     }
 
@@ -4029,6 +6078,7 @@ pmd_thread_main(void *f_)
     dpdk_set_lcore_id(pmd->core_id);
     poll_cnt = pmd_load_queues_and_ports(pmd, &poll_list);
     emc_cache_init(&pmd->flow_cache);
+    smc_cache_init(&pmd->smc_cache);
 reload:
     pmd_alloc_static_tx_qid(pmd);
 
@@ -4047,15 +6097,64 @@ reload:
         lc = UINT_MAX;
     }
 
+    uint64_t sleep_time = 0;
+
     cycles_count_start(pmd);
     for (;;) {
+        int iter_packets = 0;
+        unsigned long long max_sleep;
+
+        atomic_read_relaxed(&pmd->dp->pmd_max_sleep, &max_sleep);
+        pmd_perf_start_iteration(&pmd->perf_stats, pmd->last_cycles);
         for (i = 0; i < poll_cnt; i++) {
             process_packets =
                 dp_netdev_process_rxq_port(pmd, poll_list[i].rxq->rx,
-                                           poll_list[i].port_no);
+                                           poll_list[i].port_no,
+                                           poll_list[i].steer);
             cycles_count_intermediate(pmd, poll_list[i].rxq,
                                       process_packets ? PMD_CYCLES_PROCESSING
                                                       : PMD_CYCLES_IDLE);
+            iter_packets += process_packets;
+        }
+
+        process_packets = dp_netdev_pmd_drain_handoff(pmd);
+        if (process_packets) {
+            cycles_count_intermediate(pmd, NULL, PMD_CYCLES_PROCESSING);
+            iter_packets += process_packets;
+        }
+        dp_netdev_pmd_flush_output_packets(pmd, false);
+        pmd_perf_end_iteration(&pmd->perf_stats, pmd->last_cycles,
+                               iter_packets);
+
+        if (max_sleep) {
+            /* Back off progressively while the queues stay empty, waking
+             * instantly (resetting the request) as soon as traffic
+             * returns.  The nap itself is accounted as idle cycles.
+             *
+             * This is also the mechanism that keeps hosts with hundreds of
+             * mostly-idle vhost queues from burning full cores: a
+             * per-vring interrupt-mode fallback (arming the kickfd and
+             * dropping the queue from the poll list) would need eventfd
+             * plumbing from the vhost library through netdev and a reload
+             * round trip per wakeup; the load-based sleep achieves the
+             * cycle reduction with none of that machinery, at the cost of
+             * up to 'pmd-maxsleep' of added latency on the first packet
+             * after an idle spell. */
+            if (iter_packets) {
+                sleep_time = 0;
+            } else {
+                if (sleep_time < max_sleep) {
+                    sleep_time += PMD_SLEEP_INC_US;
+                }
+                xnanosleep(sleep_time * 1000);
+                cycles_count_intermediate(pmd, NULL, PMD_CYCLES_IDLE);
+                /* At sleeping pace, run the maintenance block (reload
+                 * check, RCU quiescing) on every iteration so that
+                 * reconfiguration latency stays bounded by one nap. */
+                lc = 1025;
+            }
+        } else {
+            sleep_time = 0;
         }
 
         if (lc++ > 1024) {
@@ -4078,6 +6177,7 @@ reload:
 
     cycles_count_end(pmd, PMD_CYCLES_IDLE);
 
+    pmd_steering_peer_reset(pmd);
     poll_cnt = pmd_load_queues_and_ports(pmd, &poll_list);
     exiting = latch_is_set(&pmd->exit_latch);
     /* Signal here to make sure the pmd finishes
@@ -4103,29 +6203,76 @@ dp_netdev_disable_upcall(struct dp_netdev *dp)
     fat_rwlock_wrlock(&dp->upcall_rwlock);
 }
 
-
-/* Meters */
-static void
-dpif_netdev_meter_get_features(const struct dpif * dpif OVS_UNUSED,
-                               struct ofputil_meter_features *features)
-{
-    features->max_meters = MAX_METERS;
-    features->band_types = DP_SUPPORTED_METER_BAND_TYPES;
-    features->capabilities = DP_SUPPORTED_METER_FLAGS_MASK;
-    features->max_bands = MAX_BANDS;
-    features->max_color = 0;
+
+/* Meters */
+static void
+dpif_netdev_meter_get_features(const struct dpif * dpif OVS_UNUSED,
+                               struct ofputil_meter_features *features)
+{
+    features->max_meters = MAX_METERS;
+    features->band_types = DP_SUPPORTED_METER_BAND_TYPES;
+    features->capabilities = DP_SUPPORTED_METER_FLAGS_MASK;
+    features->max_bands = MAX_BANDS;
+    features->max_color = 0;
+}
+
+/* Folds the locally admitted traffic of cache entry 'e' into its meter's
+ * shared statistics and returns its unused prepaid volume to the bands.
+ * No-op for empty entries; entries of a stale generation are simply
+ * discarded, since their meter instance is gone. */
+static void
+dp_meter_cache_evict(struct dp_netdev *dp, struct dp_meter_cache_entry *e)
+{
+    unsigned long long packets, bytes;
+    uint32_t generation;
+
+    if (e->meter_id == UINT32_MAX) {
+        return;
+    }
+
+    atomic_read_relaxed(&dp->meter_generation, &generation);
+    if (e->generation == generation) {
+        meter_lock(dp, e->meter_id);
+        struct dp_meter *meter = dp->meters[e->meter_id];
+
+        if (meter) {
+            atomic_read_relaxed(&e->packet_count, &packets);
+            atomic_read_relaxed(&e->byte_count, &bytes);
+            meter->packet_count += packets;
+            meter->byte_count += bytes;
+
+            for (int m = 0; m < meter->n_bands; m++) {
+                struct dp_meter_band *band = &meter->bands[m];
+
+                band->bucket += e->prepaid;
+                if (band->bucket > band->up.burst_size) {
+                    band->bucket = band->up.burst_size;
+                }
+            }
+        }
+        meter_unlock(dp, e->meter_id);
+    }
+
+    e->meter_id = UINT32_MAX;
+    e->prepaid = 0;
+    atomic_store_relaxed(&e->packet_count, 0);
+    atomic_store_relaxed(&e->byte_count, 0);
 }
 
 /* Returns false when packet needs to be dropped. */
 static void
-dp_netdev_run_meter(struct dp_netdev *dp, struct dp_packet_batch *packets_,
+dp_netdev_run_meter(struct dp_netdev_pmd_thread *pmd,
+                    struct dp_packet_batch *packets_,
                     uint32_t meter_id, long long int now)
 {
+    struct dp_netdev *dp = pmd->dp;
+    struct dp_meter_cache_entry *e;
     struct dp_meter *meter;
     struct dp_meter_band *band;
     struct dp_packet *packet;
     long long int long_delta_t; /* msec */
     uint32_t delta_t; /* msec */
+    uint32_t generation;
     int i;
     const size_t cnt = dp_packet_batch_size(packets_);
     uint32_t bytes, volume;
@@ -4137,6 +6284,41 @@ dp_netdev_run_meter(struct dp_netdev *dp, struct dp_packet_batch *packets_,
         return;
     }
 
+    bytes = 0;
+    DP_PACKET_BATCH_FOR_EACH (packet, packets_) {
+        bytes += dp_packet_size(packet);
+    }
+
+    /* Fast path: admit the whole batch against the thread's prepaid
+     * allotment, without touching the shared meter. */
+    e = &pmd->meter_cache[meter_id % DP_METER_CACHE_SIZE];
+    atomic_read_relaxed(&dp->meter_generation, &generation);
+    if (e->meter_id == meter_id && e->generation == generation
+        && now < e->refill_time) {
+        struct dp_meter *m = dp->meters[meter_id];
+
+        /* A matching generation makes a stale 'm' unlikely, but does not
+         * rule it out: deletion clears the slot with only relaxed
+         * ordering against the generation bump, so 'm' may be NULL here.
+         * RCU keeps a non-NULL 'm' alive until we quiesce. */
+        if (OVS_LIKELY(m)) {
+            volume = (m->flags & OFPMF13_PKTPS) ? cnt * 1000 : bytes * 8;
+            if (e->prepaid >= volume) {
+                unsigned long long orig;
+
+                e->prepaid -= volume;
+                atomic_add_relaxed(&e->packet_count, cnt, &orig);
+                atomic_add_relaxed(&e->byte_count, bytes, &orig);
+                return;
+            }
+        }
+    }
+
+    /* Slow path: return whatever this thread had prepaid (possibly for a
+     * colliding meter), run the batch against the shared bands, and claim
+     * a fresh allotment. */
+    dp_meter_cache_evict(dp, e);
+
     meter_lock(dp, meter_id);
     meter = dp->meters[meter_id];
     if (!meter) {
@@ -4159,10 +6341,6 @@ dp_netdev_run_meter(struct dp_netdev *dp, struct dp_packet_batch *packets_,
     /* Update meter stats. */
     meter->used = now;
     meter->packet_count += cnt;
-    bytes = 0;
-    DP_PACKET_BATCH_FOR_EACH (packet, packets_) {
-        bytes += dp_packet_size(packet);
-    }
     meter->byte_count += bytes;
 
     /* Meters can operate in terms of packets per second or kilobits per
@@ -4248,16 +6426,53 @@ dp_netdev_run_meter(struct dp_netdev *dp, struct dp_packet_batch *packets_,
             band->packet_count += 1;
             band->byte_count += dp_packet_size(packet);
 
+            dp_netdev_count_drop(pmd->dp, packet->md.in_port.odp_port,
+                                 DP_DROP_METER, 1);
             dp_packet_delete(packet);
         } else {
             /* Meter accepts packet. */
             dp_packet_batch_refill(packets_, packet, j);
         }
     }
+
+    /* Claim a fresh prepaid allotment: a few milliseconds worth of the
+     * slowest band, bounded to half of the scarcest bucket so that the
+     * other threads are not starved.  A claim of zero just sends every
+     * batch through this slow path, which is the old behavior. */
+    {
+        uint64_t claim = UINT64_MAX;
+
+        for (int m = 0; m < meter->n_bands; m++) {
+            band = &meter->bands[m];
+            claim = MIN(claim, (uint64_t) band->up.rate
+                               * DP_METER_CACHE_REFILL_MS);
+            claim = MIN(claim, band->bucket / 2);
+        }
+        if (claim) {
+            for (int m = 0; m < meter->n_bands; m++) {
+                meter->bands[m].bucket -= claim;
+            }
+        }
+        e->meter_id = meter_id;
+        e->generation = generation;
+        e->refill_time = now + DP_METER_CACHE_REFILL_MS;
+        e->prepaid = claim;
+    }
  out:
     meter_unlock(dp, meter_id);
 }
 
+/* Bumps the meter generation, invalidating every per-pmd meter cache
+ * entry. */
+static void
+dp_meter_generation_bump(struct dp_netdev *dp)
+{
+    uint32_t generation;
+
+    atomic_read_relaxed(&dp->meter_generation, &generation);
+    atomic_store_relaxed(&dp->meter_generation, generation + 1);
+}
+
 /* Meter set/get/del processing is still single-threaded. */
 static int
 dpif_netdev_meter_set(struct dpif *dpif, ofproto_meter_id *meter_id,
@@ -4331,6 +6546,12 @@ dpif_netdev_meter_set(struct dpif *dpif, ofproto_meter_id *meter_id,
             }
         }
 
+        /* Invalidate the per-pmd caches before touching the slot.  With
+         * relaxed atomics this only shrinks the stale window; a pmd that
+         * still acts on the old state sees either the RCU-protected old
+         * meter or a NULL slot, both of which dp_netdev_run_meter()
+         * handles. */
+        dp_meter_generation_bump(dp);
         meter_lock(dp, mid);
         dp_delete_meter(dp, mid); /* Free existing meter, if any */
         dp->meters[mid] = meter;
@@ -4358,6 +6579,8 @@ dpif_netdev_meter_get(const struct dpif *dpif,
         return ENOENT;
     }
     if (stats) {
+        struct dp_netdev_pmd_thread *pmd;
+        uint32_t generation;
         int i = 0;
 
         meter_lock(dp, meter_id);
@@ -4370,6 +6593,23 @@ dpif_netdev_meter_get(const struct dpif *dpif,
         }
         meter_unlock(dp, meter_id);
 
+        /* Traffic admitted from the per-pmd prepaid allotments has not
+         * been folded into the shared counters yet. */
+        atomic_read_relaxed(&dp->meter_generation, &generation);
+        CMAP_FOR_EACH (pmd, node, &dp->poll_threads) {
+            const struct dp_meter_cache_entry *e
+                = &pmd->meter_cache[meter_id % DP_METER_CACHE_SIZE];
+
+            if (e->meter_id == meter_id && e->generation == generation) {
+                unsigned long long n;
+
+                atomic_read_relaxed(&e->packet_count, &n);
+                stats->packet_in_count += n;
+                atomic_read_relaxed(&e->byte_count, &n);
+                stats->byte_in_count += n;
+            }
+        }
+
         stats->n_bands = i;
     }
     return 0;
@@ -4387,6 +6627,9 @@ dpif_netdev_meter_del(struct dpif *dpif,
     if (!error) {
         uint32_t meter_id = meter_id_.uint32;
 
+        /* Bump first: a pmd that still sees the old generation must not
+         * find the slot already cleared (see dp_netdev_run_meter()). */
+        dp_meter_generation_bump(dp);
         meter_lock(dp, meter_id);
         dp_delete_meter(dp, meter_id);
         meter_unlock(dp, meter_id);
@@ -4515,6 +6758,23 @@ dp_netdev_configure_pmd(struct dp_netdev_pmd_thread *pmd, struct dp_netdev *dp,
     ovs_mutex_init(&pmd->port_mutex);
     cmap_init(&pmd->flow_table);
     cmap_init(&pmd->classifiers);
+    pmd_perf_stats_init(&pmd->perf_stats);
+    for (int ci = 0; ci < DP_METER_CACHE_SIZE; ci++) {
+        pmd->meter_cache[ci].meter_id = UINT32_MAX;
+        pmd->meter_cache[ci].prepaid = 0;
+        atomic_init(&pmd->meter_cache[ci].packet_count, 0);
+        atomic_init(&pmd->meter_cache[ci].byte_count, 0);
+    }
+    ovs_mutex_init(&pmd->handoff_mutex);
+    dp_packet_batch_init(&pmd->handoff_batch);
+    pmd->handoff_closed = false;
+    pmd->handoff_draining = false;
+    pmd->steer_dst = NULL;
+    pmd->steering_sticky = false;
+    ovs_mutex_init(&pmd->trace_mutex);
+    ovs_list_init(&pmd->trace_entries);
+    pmd->trace_n_entries = 0;
+    pmd->trace_seen = 0;
     pmd->next_optimization = time_msec() + DPCLS_OPTIMIZATION_INTERVAL;
     pmd->rxq_interval = time_msec() + PMD_RXQ_INTERVAL_LEN;
     hmap_init(&pmd->poll_list);
@@ -4525,6 +6785,7 @@ dp_netdev_configure_pmd(struct dp_netdev_pmd_thread *pmd, struct dp_netdev *dp,
      * actual thread created for NON_PMD_CORE_ID. */
     if (core_id == NON_PMD_CORE_ID) {
         emc_cache_init(&pmd->flow_cache);
+        smc_cache_init(&pmd->smc_cache);
         pmd_alloc_static_tx_qid(pmd);
     }
     cmap_insert(&dp->poll_threads, CONST_CAST(struct cmap_node *, &pmd->node),
@@ -4548,6 +6809,9 @@ dp_netdev_destroy_pmd(struct dp_netdev_pmd_thread *pmd)
     }
     cmap_destroy(&pmd->classifiers);
     cmap_destroy(&pmd->flow_table);
+    dp_netdev_pmd_trace_clear(pmd);
+    ovs_mutex_destroy(&pmd->trace_mutex);
+    ovs_mutex_destroy(&pmd->handoff_mutex);
     ovs_mutex_destroy(&pmd->flow_mutex);
     latch_destroy(&pmd->exit_latch);
     seq_destroy(pmd->reload_seq);
@@ -4576,6 +6840,15 @@ dp_netdev_del_pmd(struct dp_netdev *dp, struct dp_netdev_pmd_thread *pmd)
         xpthread_join(pmd->thread, NULL);
     }
 
+    /* No more handoffs: release anything a peer managed to queue. */
+    ovs_mutex_lock(&pmd->handoff_mutex);
+    pmd->handoff_closed = true;
+    dp_netdev_count_batch_drop(dp, &pmd->handoff_batch,
+                               DP_DROP_HANDOFF_CLOSED);
+    dp_packet_delete_batch(&pmd->handoff_batch, true);
+    dp_packet_batch_init(&pmd->handoff_batch);
+    ovs_mutex_unlock(&pmd->handoff_mutex);
+
     dp_netdev_pmd_clear_ports(pmd);
 
     /* Purges the 'pmd''s flows after stopping the thread, but before
@@ -4689,6 +6962,8 @@ dp_netdev_add_port_tx_to_pmd(struct dp_netdev_pmd_thread *pmd,
 
     tx->port = port;
     tx->qid = -1;
+    tx->flush_time = 0LL;
+    dp_packet_batch_init(&tx->output_pkts);
 
     hmap_insert(&pmd->tx_ports, &tx->node, hash_port_no(tx->port->port_no));
     pmd->need_reload = true;
@@ -4722,8 +6997,12 @@ dp_netdev_flow_used(struct dp_netdev_flow *netdev_flow, int cnt, int size,
     non_atomic_ullong_add(&netdev_flow->stats.packet_count, cnt);
     non_atomic_ullong_add(&netdev_flow->stats.byte_count, size);
     atomic_read_relaxed(&netdev_flow->stats.tcp_flags, &flags);
-    flags |= tcp_flags;
-    atomic_store_relaxed(&netdev_flow->stats.tcp_flags, flags);
+    if ((flags | tcp_flags) != flags) {
+        /* Almost every batch of an established flow carries flags already
+         * recorded: skip the store in that case. */
+        atomic_store_relaxed(&netdev_flow->stats.tcp_flags,
+                             flags | tcp_flags);
+    }
 }
 
 static void
@@ -4824,10 +7103,10 @@ struct packet_batch_per_flow {
 static inline void
 packet_batch_per_flow_update(struct packet_batch_per_flow *batch,
                              struct dp_packet *packet,
-                             const struct miniflow *mf)
+                             uint16_t tcp_flags)
 {
     batch->byte_count += dp_packet_size(packet);
-    batch->tcp_flags |= miniflow_get_tcp_flags(mf);
+    batch->tcp_flags |= tcp_flags;
     batch->array.packets[batch->array.count++] = packet;
 }
 
@@ -4856,13 +7135,23 @@ packet_batch_per_flow_execute(struct packet_batch_per_flow *batch,
 
     actions = dp_netdev_flow_get_actions(flow);
 
+    /* A flow that just forwards to a port does not need the generic action
+     * execution machinery: queue the packets for output directly.  Fall
+     * through to the full path if the port has disappeared, which takes
+     * care of dropping the packets. */
+    if (OVS_LIKELY(actions->simple_output)
+        && dp_netdev_pmd_output(pmd, actions->output_port, &batch->array,
+                                true)) {
+        return;
+    }
+
     dp_netdev_execute_actions(pmd, &batch->array, true, &flow->flow,
                               actions->actions, actions->size, now);
 }
 
 static inline void
 dp_netdev_queue_batches(struct dp_packet *pkt,
-                        struct dp_netdev_flow *flow, const struct miniflow *mf,
+                        struct dp_netdev_flow *flow, uint16_t tcp_flags,
                         struct packet_batch_per_flow *batches,
                         size_t *n_batches)
 {
@@ -4873,7 +7162,27 @@ dp_netdev_queue_batches(struct dp_packet *pkt,
         packet_batch_per_flow_init(batch, flow);
     }
 
-    packet_batch_per_flow_update(batch, pkt, mf);
+    packet_batch_per_flow_update(batch, pkt, tcp_flags);
+}
+
+/* Runs both miniflow extraction implementations on 'packet', raising a
+ * rate-limited warning when the specialized parser claims the packet but
+ * produces a different miniflow.  The result of the generic parser is
+ * stored in 'mf'. */
+static void
+mfex_autovalidate(struct dp_packet *packet, struct miniflow *mf)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    struct netdev_flow_key opt_key;
+    bool opt_hit;
+
+    opt_hit = miniflow_extract_ipv4_l4(packet, &opt_key.mf);
+    miniflow_extract(packet, mf);
+
+    if (opt_hit && OVS_UNLIKELY(!miniflow_equal(&opt_key.mf, mf))) {
+        VLOG_WARN_RL(&rl, "miniflow parser autovalidation failed: "
+                     "specialized parser disagrees with the generic one");
+    }
 }
 
 /* Try to process all ('cnt') the 'packets' using only the exact match cache
@@ -4898,20 +7207,49 @@ emc_processing(struct dp_netdev_pmd_thread *pmd,
                bool md_is_valid, odp_port_t port_no)
 {
     struct emc_cache *flow_cache = &pmd->flow_cache;
-    struct netdev_flow_key *key = &keys[0];
+    struct netdev_flow_key *key;
     size_t n_missed = 0, n_dropped = 0;
     struct dp_packet *packet;
     const size_t cnt = dp_packet_batch_size(packets_);
     uint32_t cur_min;
+    bool smc_enable_db;
     int i;
 
+    int mfex_impl;
+
+    bool trace_on;
+
+    atomic_read_relaxed(&pmd->dp->smc_enable_db, &smc_enable_db);
     atomic_read_relaxed(&pmd->dp->emc_insert_min, &cur_min);
+    atomic_read_relaxed(&dp_mfex_impl, &mfex_impl);
+    atomic_read_relaxed(&pmd->dp->trace_on, &trace_on);
+
+    /* The mark is only valid for the original reception: it is not
+     * cleared on recirculation, so honoring it again would re-match the
+     * original flow and re-execute its actions (with ct() or tunnel pop,
+     * the packet would recirculate into itself until the depth limit
+     * drops it). */
+    const bool mark_valid = *recirc_depth_get_unsafe() == 0;
+
+    /* Phase 1: initialize the metadata, extract the miniflow and compute
+     * the hash of every packet, issuing prefetches for the cache entries
+     * the hash may land in, so that the probes in the second phase find
+     * them already in L1.  'dropped_mask' remembers undersized packets
+     * deleted here, so that the second phase can skip their slots. */
+    BUILD_ASSERT(NETDEV_MAX_BURST <= 32);
+    uint32_t dropped_mask = 0;
+    size_t n_mark_hit = 0;
 
-    DP_PACKET_BATCH_REFILL_FOR_EACH (i, cnt, packet, packets_) {
-        struct dp_netdev_flow *flow;
+    for (i = 0; i < cnt; i++) {
+        packet = packets_->packets[i];
 
         if (OVS_UNLIKELY(dp_packet_size(packet) < ETH_HEADER_LEN)) {
+            dp_netdev_count_drop(pmd->dp,
+                                 md_is_valid ? packet->md.in_port.odp_port
+                                             : port_no,
+                                 DP_DROP_RX_RUNT, 1);
             dp_packet_delete(packet);
+            dropped_mask |= 1u << i;
             n_dropped++;
             continue;
         }
@@ -4926,41 +7264,188 @@ emc_processing(struct dp_netdev_pmd_thread *pmd,
         if (!md_is_valid) {
             pkt_metadata_init(&packet->md, port_no);
         }
-        miniflow_extract(packet, &key->mf);
+
+        uint32_t mark;
+        if (OVS_UNLIKELY(dp_packet_has_flow_mark(packet, &mark))
+            && mark_valid) {
+            struct dp_netdev_flow *mark_flow = mark_to_flow_find(pmd, mark);
+
+            if (mark_flow) {
+                /* The NIC already classified the packet: skip extraction
+                 * and all the software caches. */
+                if (OVS_UNLIKELY(trace_on)) {
+                    dp_netdev_trace_packet(pmd, "mark", packet, mark_flow);
+                }
+                dp_netdev_queue_batches(packet, mark_flow,
+                                        parse_tcp_flags(packet),
+                                        batches, n_batches);
+                dropped_mask |= 1u << i;
+                n_mark_hit++;
+                continue;
+            }
+        }
+
+        key = &keys[i];
+        if (OVS_LIKELY(mfex_impl == MFEX_IMPL_SCALAR)) {
+            miniflow_extract(packet, &key->mf);
+        } else if (mfex_impl == MFEX_IMPL_OPT) {
+            if (!miniflow_extract_ipv4_l4(packet, &key->mf)) {
+                miniflow_extract(packet, &key->mf);
+            }
+        } else {
+            mfex_autovalidate(packet, &key->mf);
+        }
         key->len = 0; /* Not computed yet. */
-        /* If EMC is disabled skip hash computation and emc_lookup */
-        if (cur_min) {
+        /* If both EMC and SMC are disabled skip hash computation too. */
+        if (cur_min || smc_enable_db) {
             if (!md_is_valid) {
                 key->hash = dpif_netdev_packet_get_rss_hash_orig_pkt(packet,
                         &key->mf);
             } else {
                 key->hash = dpif_netdev_packet_get_rss_hash(packet, &key->mf);
             }
-            flow = emc_lookup(flow_cache, key);
-        } else {
-            flow = NULL;
+            if (cur_min) {
+                struct emc_entry *current_entry;
+
+                EMC_FOR_EACH_POS_WITH_HASH (flow_cache, current_entry,
+                                            key->hash) {
+                    OVS_PREFETCH(current_entry);
+                }
+            }
+        }
+    }
+
+    /* Phase 2: probe the cache with the prefetched entries, batching the
+     * hits and compacting the missed packets and their keys to the front
+     * of 'packets_' and 'keys'. */
+    DP_PACKET_BATCH_REFILL_FOR_EACH (i, cnt, packet, packets_) {
+        struct dp_netdev_flow *flow;
+
+        if (OVS_UNLIKELY(dropped_mask & (1u << i))) {
+            continue;
         }
+
+        key = &keys[i];
+        flow = cur_min ? emc_lookup(flow_cache, key) : NULL;
         if (OVS_LIKELY(flow)) {
-            dp_netdev_queue_batches(packet, flow, &key->mf, batches,
-                                    n_batches);
+            if (OVS_UNLIKELY(trace_on)) {
+                dp_netdev_trace_packet(pmd, "emc", packet, flow);
+            }
+            dp_netdev_queue_batches(packet, flow,
+                                    miniflow_get_tcp_flags(&key->mf),
+                                    batches, n_batches);
         } else {
             /* Exact match cache missed. Group missed packets together at
-             * the beginning of the 'packets' array. */
+             * the beginning of the 'packets' array, and compact their keys
+             * to the front of 'keys' for the caller. */
             dp_packet_batch_refill(packets_, packet, i);
-            /* 'key[n_missed]' contains the key of the current packet and it
-             * must be returned to the caller. The next key should be extracted
-             * to 'keys[n_missed + 1]'. */
-            key = &keys[++n_missed];
+            if (i != n_missed) {
+                key->len =
+                    netdev_flow_key_size(miniflow_n_values(&key->mf));
+                netdev_flow_key_clone(&keys[n_missed], key);
+            }
+            n_missed++;
         }
     }
 
+    dp_netdev_count_packet(pmd, DP_STAT_MARK_HIT, n_mark_hit);
     dp_netdev_count_packet(pmd, DP_STAT_EXACT_HIT,
-                           cnt - n_dropped - n_missed);
+                           cnt - n_dropped - n_mark_hit - n_missed);
 
     return dp_packet_batch_size(packets_);
 }
 
+/* Try to process all ('cnt') the 'packets' using only the signature match
+ * cache 'pmd->smc_cache'.  Called after emc_processing(), so 'keys[i]'
+ * already holds the miniflow and packet hash for 'packets[i]'.  A hit is
+ * only used after validating the candidate flow against the megaflow's
+ * mask, since flows may share a hash signature.  Packets that miss are
+ * moved to the beginning of the 'packets' array and their keys compacted
+ * to the front of 'keys' for fast_path_processing(). */
 static inline void
+smc_processing(struct dp_netdev_pmd_thread *pmd,
+               struct dp_packet_batch *packets_,
+               struct netdev_flow_key *keys,
+               struct packet_batch_per_flow batches[], size_t *n_batches)
+{
+    struct smc_cache *smc_cache = &pmd->smc_cache;
+    const size_t cnt = dp_packet_batch_size(packets_);
+    size_t n_smc_hit = 0, n_missed = 0;
+    struct dp_packet *packet;
+    bool trace_on;
+    int i;
+
+    atomic_read_relaxed(&pmd->dp->trace_on, &trace_on);
+
+    DP_PACKET_BATCH_REFILL_FOR_EACH (i, cnt, packet, packets_) {
+        struct netdev_flow_key *key = &keys[i];
+        struct smc_bucket *bucket = &smc_cache->buckets[key->hash & SMC_MASK];
+        const uint16_t sig = key->hash >> 16;
+        struct dp_netdev_flow *flow = NULL;
+        int j;
+
+        /* Key length is needed to check the candidate against the megaflow
+         * mask and, on a miss, by fast_path_processing(). */
+        key->len = netdev_flow_key_size(miniflow_n_values(&key->mf));
+
+        for (j = 0; j < SMC_ENTRY_PER_BUCKET; j++) {
+            struct dp_netdev_flow *f;
+            uint16_t index;
+
+            if (bucket->sig[j] != sig) {
+                continue;
+            }
+            index = bucket->flow_idx[j];
+            if (index == UINT16_MAX) {
+                continue;
+            }
+            CMAP_NODE_FOR_EACH (f, node,
+                                cmap_find_by_index(&pmd->flow_table, index)) {
+                /* The cached index is only a hint: it may be stale or refer
+                 * to a different flow with the same signature, so check that
+                 * the flow actually matches the packet.  The input port
+                 * must be checked explicitly: it is wildcarded out of the
+                 * megaflow mask (input-port scoping normally comes from the
+                 * per-port classifier, which this cache bypasses). */
+                if (OVS_LIKELY(f->flow.in_port.odp_port
+                               == packet->md.in_port.odp_port
+                               && dpcls_rule_matches_key(&f->cr, key))) {
+                    flow = f;
+                    break;
+                }
+            }
+            if (flow) {
+                break;
+            }
+        }
+
+        if (OVS_LIKELY(flow)) {
+            if (OVS_UNLIKELY(trace_on)) {
+                dp_netdev_trace_packet(pmd, "smc", packet, flow);
+            }
+            emc_probabilistic_insert(pmd, key, flow);
+            dp_netdev_queue_batches(packet, flow,
+                                    miniflow_get_tcp_flags(&key->mf),
+                                    batches, n_batches);
+            n_smc_hit++;
+        } else {
+            /* Signature match cache missed.  Group missed packets together
+             * at the beginning of the 'packets' array, as emc_processing()
+             * does, and compact their keys along with them. */
+            dp_packet_batch_refill(packets_, packet, i);
+            if (i != n_missed) {
+                netdev_flow_key_clone(&keys[n_missed], key);
+            }
+            n_missed++;
+        }
+    }
+
+    dp_netdev_count_packet(pmd, DP_STAT_SMC_HIT, n_smc_hit);
+}
+
+/* Returns the installed flow when one was (or could be) added to the flow
+ * table, otherwise NULL. */
+static inline struct dp_netdev_flow *
 handle_packet_upcall(struct dp_netdev_pmd_thread *pmd,
                      struct dp_packet *packet,
                      const struct netdev_flow_key *key,
@@ -4979,14 +7464,20 @@ handle_packet_upcall(struct dp_netdev_pmd_thread *pmd,
     ofpbuf_clear(actions);
     ofpbuf_clear(put_actions);
 
+    uint64_t t_upcall = cycles_counter();
+
     dpif_flow_hash(pmd->dp->dpif, &match.flow, sizeof match.flow, &ufid);
     error = dp_netdev_upcall(pmd, packet, &match.flow, &match.wc,
                              &ufid, DPIF_UC_MISS, NULL, actions,
                              put_actions);
+    pmd_perf_add_stage_cycles(&pmd->perf_stats, PMD_STAGE_UPCALL,
+                              cycles_counter() - t_upcall);
     if (OVS_UNLIKELY(error && error != ENOSPC)) {
+        dp_netdev_count_drop(pmd->dp, packet->md.in_port.odp_port,
+                             DP_DROP_UPCALL_ERROR, 1);
         dp_packet_delete(packet);
         (*lost_cnt)++;
-        return;
+        return NULL;
     }
 
     /* The Netlink encoding of datapath flow keys cannot express
@@ -5025,7 +7516,11 @@ handle_packet_upcall(struct dp_netdev_pmd_thread *pmd,
         }
         ovs_mutex_unlock(&pmd->flow_mutex);
         emc_probabilistic_insert(pmd, key, netdev_flow);
+        smc_insert(pmd, key, dp_netdev_flow_hash(&netdev_flow->ufid));
+        return netdev_flow;
     }
+
+    return NULL;
 }
 
 static inline void
@@ -5050,8 +7545,11 @@ fast_path_processing(struct dp_netdev_pmd_thread *pmd,
     int miss_cnt = 0, lost_cnt = 0;
     int lookup_cnt = 0, add_lookup_cnt;
     bool any_miss;
+    bool trace_on;
     size_t i;
 
+    atomic_read_relaxed(&pmd->dp->trace_on, &trace_on);
+
     for (i = 0; i < cnt; i++) {
         /* Key length is needed in all the cases, hash computed on demand. */
         keys[i].len = netdev_flow_key_size(miniflow_n_values(&keys[i].mf));
@@ -5066,18 +7564,40 @@ fast_path_processing(struct dp_netdev_pmd_thread *pmd,
     }
     if (OVS_UNLIKELY(any_miss) && !fat_rwlock_tryrdlock(&dp->upcall_rwlock)) {
         uint64_t actions_stub[512 / 8], slow_stub[512 / 8];
+        const struct netdev_flow_key *ucall_keys[PKT_ARRAY_SIZE];
+        struct dp_netdev_flow *ucall_flows[PKT_ARRAY_SIZE];
         struct ofpbuf actions, put_actions;
+        size_t n_ucalls = 0;
 
         ofpbuf_use_stub(&actions, actions_stub, sizeof actions_stub);
         ofpbuf_use_stub(&put_actions, slow_stub, sizeof slow_stub);
 
         DP_PACKET_BATCH_FOR_EACH (packet, packets_) {
             struct dp_netdev_flow *netdev_flow;
+            size_t u;
 
             if (OVS_LIKELY(rules[i])) {
                 continue;
             }
 
+            /* A burst of a new flow typically misses with every packet of
+             * the batch carrying the same key.  If an earlier packet of
+             * this batch already made the upcall for this key, reuse the
+             * flow it installed instead of another upcall or classifier
+             * lookup. */
+            for (u = 0; u < n_ucalls; u++) {
+                if (ucall_flows[u]
+                    && ucall_keys[u]->len == keys[i].len
+                    && netdev_flow_key_equal_mf(ucall_keys[u],
+                                                &keys[i].mf)) {
+                    break;
+                }
+            }
+            if (u < n_ucalls) {
+                rules[i] = &ucall_flows[u]->cr;
+                continue;
+            }
+
             /* It's possible that an earlier slow path execution installed
              * a rule covering this flow.  In this case, it's a lot cheaper
              * to catch it here than execute a miss. */
@@ -5090,8 +7610,15 @@ fast_path_processing(struct dp_netdev_pmd_thread *pmd,
             }
 
             miss_cnt++;
-            handle_packet_upcall(pmd, packet, &keys[i], &actions,
-                                 &put_actions, &lost_cnt, now);
+            netdev_flow = handle_packet_upcall(pmd, packet, &keys[i],
+                                               &actions, &put_actions,
+                                               &lost_cnt, now);
+            if (OVS_UNLIKELY(trace_on) && netdev_flow) {
+                dp_netdev_trace_packet(pmd, "upcall", packet, netdev_flow);
+            }
+            ucall_keys[n_ucalls] = &keys[i];
+            ucall_flows[n_ucalls] = netdev_flow;
+            n_ucalls++;
         }
 
         ofpbuf_uninit(&actions);
@@ -5100,6 +7627,7 @@ fast_path_processing(struct dp_netdev_pmd_thread *pmd,
     } else if (OVS_UNLIKELY(any_miss)) {
         DP_PACKET_BATCH_FOR_EACH (packet, packets_) {
             if (OVS_UNLIKELY(!rules[i])) {
+                dp_netdev_count_drop(dp, in_port, DP_DROP_UPCALL_DISABLED, 1);
                 dp_packet_delete(packet);
                 lost_cnt++;
                 miss_cnt++;
@@ -5116,8 +7644,14 @@ fast_path_processing(struct dp_netdev_pmd_thread *pmd,
 
         flow = dp_netdev_flow_cast(rules[i]);
 
+        if (OVS_UNLIKELY(trace_on)) {
+            dp_netdev_trace_packet(pmd, "dpcls", packet, flow);
+        }
         emc_probabilistic_insert(pmd, &keys[i], flow);
-        dp_netdev_queue_batches(packet, flow, &keys[i].mf, batches, n_batches);
+        smc_insert(pmd, &keys[i], dp_netdev_flow_hash(&flow->ufid));
+        dp_netdev_queue_batches(packet, flow,
+                                miniflow_get_tcp_flags(&keys[i].mf),
+                                batches, n_batches);
     }
 
     dp_netdev_count_packet(pmd, DP_STAT_MASKED_HIT, cnt - miss_cnt);
@@ -5148,9 +7682,15 @@ dp_netdev_input__(struct dp_netdev_pmd_thread *pmd,
     size_t n_batches;
     odp_port_t in_port;
 
+    bool smc_enable_db;
+    atomic_read_relaxed(&pmd->dp->smc_enable_db, &smc_enable_db);
+
     n_batches = 0;
     emc_processing(pmd, packets, keys, batches, &n_batches,
                             md_is_valid, port_no);
+    if (smc_enable_db && !dp_packet_batch_is_empty(packets)) {
+        smc_processing(pmd, packets, keys, batches, &n_batches);
+    }
     if (!dp_packet_batch_is_empty(packets)) {
         /* Get ingress port from first packet's metadata. */
         in_port = packets->packets[0]->md.in_port.odp_port;
@@ -5185,6 +7725,14 @@ dp_netdev_input(struct dp_netdev_pmd_thread *pmd,
     dp_netdev_input__(pmd, packets, false, port_no);
 }
 
+/* Note on cut-through decap-then-forward: the recirculation after
+ * tnl_pop is what gives the inner packet its own megaflow - skipping
+ * the second lookup means the first flow must match on inner headers
+ * it has not parsed yet.  The cost is already amortized per megaflow
+ * pair rather than per packet, and the EMC/SMC serve the inner lookup
+ * from cache.  A fused decap+forward flow would need the upcall layer
+ * to emit combined matches spanning outer and inner headers, a
+ * translation-layer feature, not a datapath shortcut. */
 static void
 dp_netdev_recirculate(struct dp_netdev_pmd_thread *pmd,
                       struct dp_packet_batch *packets)
@@ -5322,6 +7870,7 @@ push_tnl_action(const struct dp_netdev_pmd_thread *pmd,
         return 0;
     }
 error:
+    dp_netdev_count_batch_drop(pmd->dp, batch, DP_DROP_TUNNEL_PUSH);
     dp_packet_delete_batch(batch, true);
     return err;
 }
@@ -5346,10 +7895,85 @@ dp_execute_userspace_action(struct dp_netdev_pmd_thread *pmd,
         dp_netdev_execute_actions(pmd, &b, may_steal, flow,
                                   actions->data, actions->size, now);
     } else if (may_steal) {
+        dp_netdev_count_drop(pmd->dp, packet->md.in_port.odp_port,
+                             DP_DROP_UPCALL_ERROR, 1);
         dp_packet_delete(packet);
     }
 }
 
+/* Queues 'packets_' on the intermediate output queue of 'port_no'.
+ * Returns false without touching the packets when the port is not in the
+ * pmd's send cache. */
+static inline bool
+dp_netdev_pmd_output(struct dp_netdev_pmd_thread *pmd, odp_port_t port_no,
+                     struct dp_packet_batch *packets_, bool may_steal)
+{
+    struct tx_port *p = pmd_send_port_cache_lookup(pmd, port_no);
+    struct dp_packet *packet;
+
+    if (OVS_UNLIKELY(!p)) {
+        return false;
+    }
+
+    if (!may_steal) {
+        /* Mirrored output: the caller keeps the packets for subsequent
+         * actions, so they cannot be queued, which hands ownership to the
+         * netdev.  Send them directly without stealing instead - that
+         * avoids copying the packet data, at the cost of not batching
+         * this leg.  Flush anything already queued first so the port
+         * stays FIFO. */
+        int tx_qid;
+        bool dynamic_txqs;
+
+        /* Truncation must apply to this leg only, not to the caller's
+         * packets, which continue through the remaining actions.  Fall
+         * back to an owning clone for that case: the clones carry the
+         * cutlen into the queued path, and the originals continue
+         * untruncated. */
+        if (OVS_UNLIKELY(packets_->trunc)) {
+            struct dp_packet_batch clones;
+
+            dp_packet_batch_clone(&clones, packets_);
+            dp_packet_batch_reset_cutlen(packets_);
+            return dp_netdev_pmd_output(pmd, port_no, &clones, true);
+        }
+
+        dp_netdev_pmd_flush_output_on_port(pmd, p);
+
+        dynamic_txqs = p->port->dynamic_txqs;
+        if (dynamic_txqs) {
+            tx_qid = dpif_netdev_xps_get_tx_qid(pmd, p, time_msec());
+        } else {
+            tx_qid = pmd->static_tx_qid;
+        }
+
+        netdev_send(p->port->netdev, tx_qid, packets_, false, dynamic_txqs);
+        return true;
+    }
+    dp_packet_batch_apply_cutlen(packets_);
+
+    if (dp_packet_batch_size(&p->output_pkts)
+        + dp_packet_batch_size(packets_) > NETDEV_MAX_BURST) {
+        /* Flush here to avoid an overflow of 'output_pkts'. */
+        dp_netdev_pmd_flush_output_on_port(pmd, p);
+    }
+
+    if (dp_packet_batch_is_empty(&p->output_pkts)) {
+        uint32_t tx_flush_interval;
+
+        /* Schedule the flush. */
+        atomic_read_relaxed(&pmd->dp->tx_flush_interval, &tx_flush_interval);
+        p->flush_time = time_usec() + tx_flush_interval;
+        pmd->n_output_batches++;
+    }
+
+    DP_PACKET_BATCH_FOR_EACH (packet, packets_) {
+        dp_packet_batch_add(&p->output_pkts, packet);
+    }
+
+    return true;
+}
+
 static void
 dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
               const struct nlattr *a, bool may_steal)
@@ -5365,22 +7989,11 @@ dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
 
     switch ((enum ovs_action_attr)type) {
     case OVS_ACTION_ATTR_OUTPUT:
-        p = pmd_send_port_cache_lookup(pmd, nl_attr_get_odp_port(a));
-        if (OVS_LIKELY(p)) {
-            int tx_qid;
-            bool dynamic_txqs;
-
-            dynamic_txqs = p->port->dynamic_txqs;
-            if (dynamic_txqs) {
-                tx_qid = dpif_netdev_xps_get_tx_qid(pmd, p, now);
-            } else {
-                tx_qid = pmd->static_tx_qid;
-            }
-
-            netdev_send(p->port->netdev, tx_qid, packets_, may_steal,
-                        dynamic_txqs);
+        if (dp_netdev_pmd_output(pmd, nl_attr_get_odp_port(a), packets_,
+                                 may_steal)) {
             return;
         }
+        dp_netdev_count_batch_drop(pmd->dp, packets_, DP_DROP_INVALID_PORT);
         break;
 
     case OVS_ACTION_ATTR_TUNNEL_PUSH:
@@ -5389,6 +8002,7 @@ dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
             push_tnl_action(pmd, a, packets_);
             return;
         }
+        dp_netdev_count_batch_drop(pmd->dp, packets_, DP_DROP_RECIRC_DEPTH);
         break;
 
     case OVS_ACTION_ATTR_TUNNEL_POP:
@@ -5423,6 +8037,11 @@ dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
                 (*depth)--;
                 return;
             }
+            dp_netdev_count_batch_drop(pmd->dp, packets_,
+                                       DP_DROP_TUNNEL_POP);
+        } else {
+            dp_netdev_count_batch_drop(pmd->dp, packets_,
+                                       DP_DROP_RECIRC_DEPTH);
         }
         break;
 
@@ -5490,6 +8109,7 @@ dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
             return;
         }
 
+        dp_netdev_count_batch_drop(pmd->dp, packets_, DP_DROP_RECIRC_DEPTH);
         VLOG_WARN("Packet dropped. Max recirculation depth exceeded.");
         break;
 
@@ -5621,7 +8241,7 @@ dp_execute_cb(void *aux_, struct dp_packet_batch *packets_,
     }
 
     case OVS_ACTION_ATTR_METER:
-        dp_netdev_run_meter(pmd->dp, packets_, nl_attr_get_u32(a),
+        dp_netdev_run_meter(pmd, packets_, nl_attr_get_u32(a),
                             time_msec());
         break;
 
@@ -5875,6 +8495,27 @@ dpif_dummy_register(enum dummy_level level)
 
 /* Datapath Classifier. */
 
+struct dpcls_subtable;
+
+/* Performs a batched lookup in one subtable: probes the search-keys whose
+ * bit is set in 'keys_map' against the subtable's rules, stores matching
+ * rules in 'rules' and returns the map of keys that matched.  Called only
+ * by the thread that owns the classifier, so an implementation can be
+ * exchanged at runtime without synchronization (see
+ * dpcls_subtable_get_best_lookup()). */
+typedef uint32_t (*dpcls_subtable_lookup_func)(struct dpcls_subtable *,
+                                               uint32_t keys_map,
+                                               const struct netdev_flow_key
+                                               keys[],
+                                               struct dpcls_rule **rules);
+
+/* Number of counting-bloom-filter cells per subtable.  Each cell is a
+ * saturating byte counter; a rule hash maps to two cells.  4k cells keep
+ * the false-positive rate low for the rule counts a subtable typically
+ * holds while the filter stays small enough to remain cache resident. */
+#define DPCLS_BLOOM_CELLS 4096
+BUILD_ASSERT_DECL(IS_POW2(DPCLS_BLOOM_CELLS));
+
 /* A set of rules that all have the same fields wildcarded. */
 struct dpcls_subtable {
     /* The fields are only used by writers. */
@@ -5884,10 +8525,69 @@ struct dpcls_subtable {
     struct cmap rules;           /* Contains "struct dpcls_rule"s. */
     uint32_t hit_cnt;            /* Number of match hits in subtable in current
                                     optimization interval. */
+    uint32_t avg_hit_cnt;        /* Moving average of 'hit_cnt' over the past
+                                    intervals, used as the sort priority. */
+    dpcls_subtable_lookup_func lookup_func; /* Used for lookups. */
+
+    /* Counting bloom filter over the rules' masked hashes, consulted
+     * before the hash table probes.  A zero cell proves that no rule with
+     * that hash exists; false positives only cost the probe that would
+     * have been made anyway.  Updated under the owner's flow_mutex;
+     * transiently stale single-byte reads by concurrent lookups are
+     * harmless (a spurious probe or, for a just-inserted rule, one
+     * spurious upcall that finds the flow already installed). */
+    uint8_t bloom[DPCLS_BLOOM_CELLS];
+
     struct netdev_flow_key mask; /* Wildcards for fields (const). */
     /* 'mask' must be the last field, additional space is allocated here. */
 };
 
+static inline void
+dpcls_bloom_cells(uint32_t hash, uint32_t *c1, uint32_t *c2)
+{
+    *c1 = hash & (DPCLS_BLOOM_CELLS - 1);
+    *c2 = (hash >> 16) & (DPCLS_BLOOM_CELLS - 1);
+}
+
+static inline bool
+dpcls_bloom_may_contain(const struct dpcls_subtable *subtable, uint32_t hash)
+{
+    uint32_t c1, c2;
+
+    dpcls_bloom_cells(hash, &c1, &c2);
+    return subtable->bloom[c1] && subtable->bloom[c2];
+}
+
+static void
+dpcls_bloom_add(struct dpcls_subtable *subtable, uint32_t hash)
+{
+    uint32_t c1, c2;
+
+    dpcls_bloom_cells(hash, &c1, &c2);
+    if (subtable->bloom[c1] < UINT8_MAX) {
+        subtable->bloom[c1]++;
+    }
+    if (subtable->bloom[c2] < UINT8_MAX) {
+        subtable->bloom[c2]++;
+    }
+}
+
+static void
+dpcls_bloom_del(struct dpcls_subtable *subtable, uint32_t hash)
+{
+    uint32_t c1, c2;
+
+    dpcls_bloom_cells(hash, &c1, &c2);
+    /* A cell that ever saturated sticks at the maximum: decrementing it
+     * could introduce false negatives. */
+    if (subtable->bloom[c1] < UINT8_MAX) {
+        subtable->bloom[c1]--;
+    }
+    if (subtable->bloom[c2] < UINT8_MAX) {
+        subtable->bloom[c2]--;
+    }
+}
+
 /* Initializes 'cls' as a classifier that initially contains no classification
  * rules. */
 static void
@@ -5926,6 +8626,152 @@ dpcls_destroy(struct dpcls *cls)
     }
 }
 
+/* The generic subtable lookup: works for any subtable mask. */
+static uint32_t
+dpcls_subtable_lookup_generic(struct dpcls_subtable *subtable,
+                              uint32_t keys_map,
+                              const struct netdev_flow_key keys[],
+                              struct dpcls_rule **rules)
+{
+    int i;
+    uint32_t found_map;
+    uint32_t hashes[NETDEV_MAX_BURST];
+    const struct cmap_node *nodes[NETDEV_MAX_BURST];
+
+    uint32_t probe_map = keys_map;
+
+    /* Compute hashes for the remaining keys.  Each search-key is masked
+     * with the subtable's mask to avoid hashing the wildcarded bits.  The
+     * bloom prefilter proves definitive misses without probing. */
+    ULLONG_FOR_EACH_1 (i, keys_map) {
+        hashes[i] = netdev_flow_key_hash_in_mask(&keys[i], &subtable->mask);
+        if (!dpcls_bloom_may_contain(subtable, hashes[i])) {
+            ULLONG_SET0(probe_map, i);
+        }
+    }
+
+    found_map = probe_map
+        ? cmap_find_batch(&subtable->rules, probe_map, hashes, nodes)
+        : 0;
+
+    /* Due to possible hash collisions we need to check which of the found
+     * rules, if any, really matches our masked search-key. */
+    ULLONG_FOR_EACH_1 (i, found_map) {
+        struct dpcls_rule *rule;
+
+        CMAP_NODE_FOR_EACH (rule, cmap_node, nodes[i]) {
+            if (OVS_LIKELY(dpcls_rule_matches_key(rule, &keys[i]))) {
+                rules[i] = rule;
+                goto next;
+            }
+        }
+        ULLONG_SET0(found_map, i);  /* Did not match. */
+    next:
+        ;                     /* Keep Sparse happy. */
+    }
+
+    return found_map;
+}
+
+/* Computes the hash of 'key' in 'mask', where the mask has no values in
+ * its second miniflow unit.  Avoids the generic two-unit flowmap
+ * traversal of netdev_flow_key_hash_in_mask(). */
+static inline uint32_t
+netdev_flow_key_hash_in_mask_unit0(const struct netdev_flow_key *key,
+                                   const struct netdev_flow_key *mask)
+{
+    const uint64_t *p = miniflow_get_values(&mask->mf);
+    const uint64_t *key_values = miniflow_get_values(&key->mf);
+    const uint64_t key_map = key->mf.map.bits[0];
+    uint64_t map = mask->mf.map.bits[0];
+    uint32_t hash = 0;
+
+    for (; map; map = zero_rightmost_1bit(map)) {
+        uint64_t bit = rightmost_1bit(map);
+        uint64_t value = 0;
+
+        if (key_map & bit) {
+            value = key_values[count_1bits(key_map & (bit - 1))];
+        }
+        hash = hash_add64(hash, value & *p++);
+    }
+
+    return hash_finish(hash, (p - miniflow_get_values(&mask->mf)) * 8);
+}
+
+/* Specialized lookup for subtables whose mask only has values in the first
+ * miniflow unit, which covers the typical set of megaflows for non-tunneled
+ * traffic. */
+static uint32_t
+dpcls_subtable_lookup_unit0(struct dpcls_subtable *subtable,
+                            uint32_t keys_map,
+                            const struct netdev_flow_key keys[],
+                            struct dpcls_rule **rules)
+{
+    int i;
+    uint32_t found_map;
+    uint32_t hashes[NETDEV_MAX_BURST];
+    const struct cmap_node *nodes[NETDEV_MAX_BURST];
+
+    uint32_t probe_map = keys_map;
+
+    ULLONG_FOR_EACH_1 (i, keys_map) {
+        hashes[i] = netdev_flow_key_hash_in_mask_unit0(&keys[i],
+                                                       &subtable->mask);
+        if (!dpcls_bloom_may_contain(subtable, hashes[i])) {
+            ULLONG_SET0(probe_map, i);
+        }
+    }
+
+    found_map = probe_map
+        ? cmap_find_batch(&subtable->rules, probe_map, hashes, nodes)
+        : 0;
+
+    ULLONG_FOR_EACH_1 (i, found_map) {
+        struct dpcls_rule *rule;
+
+        CMAP_NODE_FOR_EACH (rule, cmap_node, nodes[i]) {
+            if (OVS_LIKELY(dpcls_rule_matches_key(rule, &keys[i]))) {
+                rules[i] = rule;
+                goto next;
+            }
+        }
+        ULLONG_SET0(found_map, i);  /* Did not match. */
+    next:
+        ;                     /* Keep Sparse happy. */
+    }
+
+    return found_map;
+}
+
+/* Returns the best lookup implementation for a subtable with 'mask'. */
+static dpcls_subtable_lookup_func
+dpcls_subtable_get_best_lookup(const struct netdev_flow_key *mask)
+{
+    uint32_t prio_generic, prio_unit0;
+
+    atomic_read_relaxed(&dpcls_lookup_prio_generic, &prio_generic);
+    atomic_read_relaxed(&dpcls_lookup_prio_unit0, &prio_unit0);
+
+    if (!mask->mf.map.bits[1] && prio_unit0 > prio_generic) {
+        return dpcls_subtable_lookup_unit0;
+    }
+    return dpcls_subtable_lookup_generic;
+}
+
+/* Re-selects the lookup implementation of every subtable in 'cls'.  Must
+ * be called from the thread that owns the classifier. */
+static void
+dpcls_subtable_lookup_reprobe(struct dpcls *cls)
+{
+    struct dpcls_subtable *subtable;
+
+    CMAP_FOR_EACH (subtable, cmap_node, &cls->subtables_map) {
+        subtable->lookup_func =
+            dpcls_subtable_get_best_lookup(&subtable->mask);
+    }
+}
+
 static struct dpcls_subtable *
 dpcls_create_subtable(struct dpcls *cls, const struct netdev_flow_key *mask)
 {
@@ -5936,7 +8782,10 @@ dpcls_create_subtable(struct dpcls *cls, const struct netdev_flow_key *mask)
                        - sizeof subtable->mask.mf + mask->len);
     cmap_init(&subtable->rules);
     subtable->hit_cnt = 0;
+    subtable->avg_hit_cnt = 0;
+    memset(subtable->bloom, 0, sizeof subtable->bloom);
     netdev_flow_key_clone(&subtable->mask, mask);
+    subtable->lookup_func = dpcls_subtable_get_best_lookup(&subtable->mask);
     cmap_insert(&cls->subtables_map, &subtable->cmap_node, mask->hash);
     /* Add the new subtable at the end of the pvector (with no hits yet) */
     pvector_insert(&cls->subtables, subtable, 0);
@@ -5970,7 +8819,12 @@ dpcls_sort_subtable_vector(struct dpcls *cls)
     struct dpcls_subtable *subtable;
 
     PVECTOR_FOR_EACH (subtable, pvec) {
-        pvector_change_priority(pvec, subtable, subtable->hit_cnt);
+        /* Smooth the hit counts over the intervals, so that one quiet
+         * interval does not immediately demote a generally hot subtable
+         * behind cold ones. */
+        subtable->avg_hit_cnt = (subtable->hit_cnt
+                                 + subtable->avg_hit_cnt) / 2;
+        pvector_change_priority(pvec, subtable, subtable->avg_hit_cnt);
         subtable->hit_cnt = 0;
     }
     pvector_publish(pvec);
@@ -6000,10 +8854,21 @@ dp_netdev_pmd_try_optimize(struct dp_netdev_pmd_thread *pmd,
         /* Try to obtain the flow lock to block out revalidator threads.
          * If not possible, just try next time. */
         if (!ovs_mutex_trylock(&pmd->flow_mutex)) {
+            uint32_t prio_seq;
+
+            atomic_read_relaxed(&dpcls_lookup_prio_seq, &prio_seq);
             /* Optimize each classifier */
             CMAP_FOR_EACH (cls, node, &pmd->classifiers) {
+                if (OVS_UNLIKELY(prio_seq != pmd->lookup_prio_seq)) {
+                    /* The lookup priorities changed: re-probe the lookup
+                     * implementation of every subtable.  Safe without
+                     * synchronization because this thread is the only
+                     * lookup caller. */
+                    dpcls_subtable_lookup_reprobe(cls);
+                }
                 dpcls_sort_subtable_vector(cls);
             }
+            pmd->lookup_prio_seq = prio_seq;
             ovs_mutex_unlock(&pmd->flow_mutex);
             /* Start new measuring interval */
             pmd->next_optimization = now + DPCLS_OPTIMIZATION_INTERVAL;
@@ -6020,6 +8885,8 @@ dpcls_insert(struct dpcls *cls, struct dpcls_rule *rule,
 
     /* Refer to subtable's mask, also for later removal. */
     rule->mask = &subtable->mask;
+    /* Make the filter cover the rule before it becomes findable. */
+    dpcls_bloom_add(subtable, rule->flow.hash);
     cmap_insert(&subtable->rules, &rule->cmap_node, rule->flow.hash);
 }
 
@@ -6038,6 +8905,8 @@ dpcls_remove(struct dpcls *cls, struct dpcls_rule *rule)
         /* Delete empty subtable. */
         dpcls_destroy_subtable(cls, subtable);
         pvector_publish(&cls->subtables);
+    } else {
+        dpcls_bloom_del(subtable, rule->flow.hash);
     }
 }
 
@@ -6085,8 +8954,6 @@ dpcls_lookup(struct dpcls *cls, const struct netdev_flow_key keys[],
 
     map_type keys_map = TYPE_MAXIMUM(map_type); /* Set all bits. */
     map_type found_map;
-    uint32_t hashes[MAP_BITS];
-    const struct cmap_node *nodes[MAP_BITS];
 
     if (cnt != MAP_BITS) {
         keys_map >>= MAP_BITS - cnt; /* Clear extra bits. */
@@ -6103,41 +8970,17 @@ dpcls_lookup(struct dpcls *cls, const struct netdev_flow_key keys[],
      * search-key, the search for that key can stop because the rules are
      * non-overlapping. */
     PVECTOR_FOR_EACH (subtable, &cls->subtables) {
-        int i;
+        /* Probe the remaining keys against this subtable using its lookup
+         * implementation.  When the i-th bit of found_map is set, a rule
+         * matching the i-th search-key was found and stored in rules[i]. */
+        found_map = subtable->lookup_func(subtable, keys_map, keys, rules);
+
+        uint32_t hit_cnt = count_1bits(found_map);
+        /* Even at 20 Mpps the 32-bit hit_cnt cannot wrap within one
+         * second optimization interval. */
+        subtable->hit_cnt += hit_cnt;
+        lookups_match += hit_cnt * subtable_pos;
 
-        /* Compute hashes for the remaining keys.  Each search-key is
-         * masked with the subtable's mask to avoid hashing the wildcarded
-         * bits. */
-        ULLONG_FOR_EACH_1(i, keys_map) {
-            hashes[i] = netdev_flow_key_hash_in_mask(&keys[i],
-                                                     &subtable->mask);
-        }
-        /* Lookup. */
-        found_map = cmap_find_batch(&subtable->rules, keys_map, hashes, nodes);
-        /* Check results.  When the i-th bit of found_map is set, it means
-         * that a set of nodes with a matching hash value was found for the
-         * i-th search-key.  Due to possible hash collisions we need to check
-         * which of the found rules, if any, really matches our masked
-         * search-key. */
-        ULLONG_FOR_EACH_1(i, found_map) {
-            struct dpcls_rule *rule;
-
-            CMAP_NODE_FOR_EACH (rule, cmap_node, nodes[i]) {
-                if (OVS_LIKELY(dpcls_rule_matches_key(rule, &keys[i]))) {
-                    rules[i] = rule;
-                    /* Even at 20 Mpps the 32-bit hit_cnt cannot wrap
-                     * within one second optimization interval. */
-                    subtable->hit_cnt++;
-                    lookups_match += subtable_pos;
-                    goto next;
-                }
-            }
-            /* None of the found rules was a match.  Reset the i-th bit to
-             * keep searching this key in the next subtable. */
-            ULLONG_SET0(found_map, i);  /* Did not match. */
-        next:
-            ;                     /* Keep Sparse happy. */
-        }
         keys_map &= ~found_map;             /* Clear the found rules. */
         if (!keys_map) {
             if (num_lookups_p) {
@@ -817,6 +817,14 @@ netdev_to_ovs_vport_type(const char *type)
     }
 }
 
+/* Note on per-CPU upcall dispatch: the per-port channel arrays here (one
+ * socket per port per handler) are what burns fds and pins a hot port's
+ * upcalls to one handler.  The fix is a kernel datapath feature - the
+ * kernel hashing upcalls across a per-CPU socket set - which this
+ * kernel baseline (4.13) does not provide; userspace alone can only
+ * rearrange which socket each port points at, not spread one port's
+ * upcalls.  Until the kernel grows the API, fd pressure is managed by
+ * reducing n-handler-threads on high-port-count systems. */
 static int
 dpif_netlink_port_add__(struct dpif_netlink *dpif, const char *name,
                         enum ovs_vport_type type,
@@ -1328,7 +1328,18 @@ dpif_execute(struct dpif *dpif, struct dpif_execute *execute)
 /* Executes each of the 'n_ops' operations in 'ops' on 'dpif', in the order in
  * which they are specified.  Places each operation's results in the "output"
  * members documented in comments, and 0 in the 'error' member on success or a
- * positive errno on failure. */
+ * positive errno on failure.
+ *
+ * Note on asynchrony: a submit-ring API with completion callbacks was
+ * considered for the revalidators' mass deletions and rejected at this
+ * layer.  The heavy cost is already amortized here - each provider
+ * receives whole batches (one netlink transaction per batch on the
+ * kernel path, direct table operations on dpif-netdev) and the
+ * revalidators interleave dumping with batched deletes.  True asynchrony
+ * would push completion tracking, in-flight limits and reordering rules
+ * into every provider and every caller; revisit only with evidence that
+ * a revalidator blocks on dpif_operate() itself rather than on
+ * translation. */
 void
 dpif_operate(struct dpif *dpif, struct dpif_op **ops, size_t n_ops)
 {
@@ -533,6 +533,8 @@ struct pkt_metadata;
  * 'dst->map' is ignored on input and set on output to indicate which fields
  * were extracted. */
 void miniflow_extract(struct dp_packet *packet, struct miniflow *dst);
+bool miniflow_extract_ipv4_l4(struct dp_packet *packet, struct miniflow *dst);
+uint16_t parse_tcp_flags(struct dp_packet *packet);
 void miniflow_map_init(struct miniflow *, const struct flow *);
 void flow_wc_map(const struct flow *, struct flowmap *);
 size_t miniflow_alloc(struct miniflow *dsts[], size_t n,
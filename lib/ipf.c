@@ -0,0 +1,583 @@
+/*
+ * Copyright (c) 2017 Nicira, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+#include <errno.h>
+
+#include "ipf.h"
+#include "csum.h"
+#include "openvswitch/hmap.h"
+#include "openvswitch/list.h"
+#include "openvswitch/vlog.h"
+#include "ovs-thread.h"
+#include "packets.h"
+#include "util.h"
+
+VLOG_DEFINE_THIS_MODULE(ipf);
+
+/* A held fragment of a datagram being reassembled. */
+struct ipf_frag {
+    struct ovs_list node;       /* In 'ipf_list''s 'frags', sorted by
+                                 * 'start'. */
+    struct dp_packet *pkt;      /* The original fragment. */
+    uint16_t start;             /* First payload byte within the datagram. */
+    uint16_t end;               /* One past the last payload byte. */
+};
+
+/* The fragments of one datagram. */
+struct ipf_list {
+    struct hmap_node node;      /* In 'ipf''s 'frag_lists'. */
+    struct ovs_list list_node;  /* In 'in_flight' or 'pending' when there. */
+    struct ovs_list frags;      /* Contains 'ipf_frag's. */
+
+    /* Datagram key. */
+    ovs_be32 src;
+    ovs_be32 dst;
+    ovs_be16 ip_id;
+    uint8_t proto;
+    uint16_t zone;
+
+    unsigned int n_frags;
+    uint32_t collected;         /* Payload bytes collected so far. */
+    uint32_t total;             /* Total payload size, 0 if the last
+                                 * fragment has not been seen yet. */
+    long long expiry;           /* When to give up on the datagram. */
+    struct dp_packet *reass;    /* Reassembled packet currently in a batch
+                                 * between pre- and postprocessing, or
+                                 * NULL. */
+};
+
+/* How long to hold the fragments of an incomplete datagram. */
+#define IPF_TIMEOUT_MS (15 * 1000)
+
+/* Resource bounds: fragments beyond these limits pass through untracked,
+ * which is the behavior all fragments had before reassembly existed. */
+#define IPF_MAX_FRAGS 1024
+#define IPF_MAX_BYTES (4 * 1024 * 1024)
+
+struct ipf {
+    struct ovs_mutex mutex;
+
+    /* All datagrams being reassembled, keyed by the datagram key. */
+    struct hmap frag_lists OVS_GUARDED;
+
+    /* Datagrams whose reassembled packet is out in a batch between the
+     * pre- and postprocessing calls. */
+    struct ovs_list in_flight OVS_GUARDED;
+
+    /* Tracked fragments that could not be returned to a full batch yet. */
+    struct ovs_list pending OVS_GUARDED;
+
+    long long next_expiry_check OVS_GUARDED;
+
+    struct ipf_status status OVS_GUARDED;
+};
+
+/* A fragment with its connection tracking metadata resolved, waiting for
+ * room in a batch. */
+struct ipf_pending_pkt {
+    struct ovs_list node;
+    struct dp_packet *pkt;
+    uint16_t zone;
+};
+
+struct ipf *
+ipf_init(void)
+{
+    struct ipf *ipf = xzalloc(sizeof *ipf);
+
+    ovs_mutex_init_adaptive(&ipf->mutex);
+    hmap_init(&ipf->frag_lists);
+    ovs_list_init(&ipf->in_flight);
+    ovs_list_init(&ipf->pending);
+
+    return ipf;
+}
+
+static void
+ipf_list_destroy(struct ipf *ipf, struct ipf_list *list, bool free_pkts)
+    OVS_REQUIRES(ipf->mutex)
+{
+    struct ipf_frag *frag, *next;
+
+    LIST_FOR_EACH_SAFE (frag, next, node, &list->frags) {
+        ovs_list_remove(&frag->node);
+        ipf->status.n_frags_held--;
+        ipf->status.n_bytes_held -= dp_packet_size(frag->pkt);
+        if (free_pkts) {
+            dp_packet_delete(frag->pkt);
+        }
+        free(frag);
+    }
+    hmap_remove(&ipf->frag_lists, &list->node);
+    free(list);
+}
+
+void
+ipf_destroy(struct ipf *ipf)
+{
+    struct ipf_list *list, *next;
+    struct ipf_pending_pkt *pending, *pending_next;
+
+    if (!ipf) {
+        return;
+    }
+
+    ovs_mutex_lock(&ipf->mutex);
+    HMAP_FOR_EACH_SAFE (list, next, node, &ipf->frag_lists) {
+        if (list->reass) {
+            dp_packet_delete(list->reass);
+        }
+        ipf_list_destroy(ipf, list, true);
+    }
+    LIST_FOR_EACH_SAFE (pending, pending_next, node, &ipf->pending) {
+        ovs_list_remove(&pending->node);
+        dp_packet_delete(pending->pkt);
+        free(pending);
+    }
+    ovs_mutex_unlock(&ipf->mutex);
+    ovs_mutex_destroy(&ipf->mutex);
+    hmap_destroy(&ipf->frag_lists);
+    free(ipf);
+}
+
+static uint32_t
+ipf_list_key_hash(ovs_be32 src, ovs_be32 dst, ovs_be16 ip_id, uint8_t proto,
+                  uint16_t zone)
+{
+    uint32_t hash = hash_2words((OVS_FORCE uint32_t) src,
+                                (OVS_FORCE uint32_t) dst);
+
+    return hash_2words(hash, ((OVS_FORCE uint32_t) ip_id << 16)
+                             | (proto << 8) | (zone & 0xff))
+           ^ hash_int(zone, proto);
+}
+
+static struct ipf_list *
+ipf_list_find(struct ipf *ipf, uint32_t hash, ovs_be32 src, ovs_be32 dst,
+              ovs_be16 ip_id, uint8_t proto, uint16_t zone)
+    OVS_REQUIRES(ipf->mutex)
+{
+    struct ipf_list *list;
+
+    HMAP_FOR_EACH_WITH_HASH (list, node, hash, &ipf->frag_lists) {
+        if (list->src == src && list->dst == dst && list->ip_id == ip_id
+            && list->proto == proto && list->zone == zone) {
+            return list;
+        }
+    }
+    return NULL;
+}
+
+/* Expires incomplete datagrams, dropping their fragments.  Runs at most
+ * once a second. */
+static void
+ipf_expire(struct ipf *ipf, long long now)
+    OVS_REQUIRES(ipf->mutex)
+{
+    struct ipf_list *list, *next;
+
+    if (now < ipf->next_expiry_check) {
+        return;
+    }
+    ipf->next_expiry_check = now + 1000;
+
+    HMAP_FOR_EACH_SAFE (list, next, node, &ipf->frag_lists) {
+        if (!list->reass && now > list->expiry) {
+            ipf->status.n_frags_expired += list->n_frags;
+            ipf_list_destroy(ipf, list, true);
+        }
+    }
+}
+
+/* Builds the reassembled packet of 'list', whose coverage must be
+ * complete.  Returns NULL if the datagram is malformed after all. */
+static struct dp_packet *
+ipf_reassemble(struct ipf_list *list)
+    OVS_REQUIRES(ipf->mutex) OVS_NO_THREAD_SAFETY_ANALYSIS
+{
+    struct ipf_frag *first
+        = CONTAINER_OF(ovs_list_front(&list->frags), struct ipf_frag, node);
+    struct dp_packet *fp = first->pkt;
+    const char *l3 = dp_packet_l3(fp);
+    const struct ip_header *nh = (const struct ip_header *) l3;
+    uint16_t l2_len = fp->l3_ofs;
+    uint16_t ip_hlen = IP_IHL(nh->ip_ihl_ver) * 4;
+    struct dp_packet *r;
+    struct ipf_frag *frag;
+    struct ip_header *rnh;
+
+    if (l2_len + ip_hlen + list->total > UINT16_MAX) {
+        return NULL;
+    }
+
+    r = dp_packet_new_with_headroom(l2_len + ip_hlen + list->total,
+                                    dp_packet_headroom(fp));
+    dp_packet_put(r, dp_packet_data(fp), l2_len + ip_hlen);
+
+    LIST_FOR_EACH (frag, node, &list->frags) {
+        const char *fl3 = dp_packet_l3(frag->pkt);
+        const struct ip_header *fnh = (const struct ip_header *) fl3;
+        uint16_t fhlen = IP_IHL(fnh->ip_ihl_ver) * 4;
+
+        memcpy((char *) dp_packet_data(r) + l2_len + ip_hlen + frag->start,
+               fl3 + fhlen, frag->end - frag->start);
+        dp_packet_set_size(r, MAX(dp_packet_size(r),
+                                  l2_len + ip_hlen + frag->end));
+    }
+    dp_packet_set_size(r, l2_len + ip_hlen + list->total);
+
+    /* Turn the copied header into the whole-datagram header. */
+    rnh = (struct ip_header *) ((char *) dp_packet_data(r) + l2_len);
+    rnh->ip_frag_off = 0;
+    rnh->ip_tot_len = htons(ip_hlen + list->total);
+    rnh->ip_csum = 0;
+    rnh->ip_csum = csum(rnh, ip_hlen);
+
+    /* Metadata and offsets, so that the connection tracker can parse and
+     * annotate the packet as usual. */
+    r->md = fp->md;
+    r->packet_type = fp->packet_type;
+    dp_packet_reset_offsets(r);
+    r->l3_ofs = l2_len;
+    r->l4_ofs = l2_len + ip_hlen;
+
+    return r;
+}
+
+/* Returns true if the coverage of 'list' is complete. */
+static bool
+ipf_list_complete(const struct ipf_list *list)
+{
+    const struct ipf_frag *frag;
+    uint32_t expect = 0;
+
+    if (!list->total || list->collected != list->total) {
+        return false;
+    }
+    LIST_FOR_EACH (frag, node, &list->frags) {
+        if (frag->start != expect) {
+            return false;
+        }
+        expect = frag->end;
+    }
+    return expect == list->total;
+}
+
+/* Examines 'pkt', and if it is an IPv4 fragment suitable for reassembly,
+ * takes ownership of it and returns either NULL (fragment held or
+ * dropped) or the reassembled datagram to substitute into the batch.
+ * Returns 'pkt' itself if it is not a fragment or cannot be handled, in
+ * which case it should stay in the batch untouched. */
+static struct dp_packet *
+ipf_handle_frag(struct ipf *ipf, struct dp_packet *pkt, long long now,
+                uint16_t zone)
+    OVS_REQUIRES(ipf->mutex)
+{
+    const struct ip_header *nh = dp_packet_l3(pkt);
+    size_t l3_size = nh ? (const char *) dp_packet_tail(pkt)
+                          - (const char *) nh : 0;
+    uint16_t ip_hlen, tot_len, payload;
+    uint32_t start, end, hash;
+    struct ipf_list *list;
+    struct ipf_frag *frag, *pos;
+    bool mf;
+
+    if (!nh || l3_size < IP_HEADER_LEN) {
+        return pkt;
+    }
+    ip_hlen = IP_IHL(nh->ip_ihl_ver) * 4;
+    tot_len = ntohs(nh->ip_tot_len);
+    if (ip_hlen < IP_HEADER_LEN || l3_size < tot_len || tot_len < ip_hlen) {
+        ipf->status.n_frags_too_small++;
+        return pkt;
+    }
+    payload = tot_len - ip_hlen;
+    start = ntohs(nh->ip_frag_off & htons(IP_FRAG_OFF_MASK)) * 8;
+    mf = (nh->ip_frag_off & htons(IP_MORE_FRAGMENTS)) != 0;
+    end = start + payload;
+    if ((mf && (payload == 0 || payload % 8)) || end > UINT16_MAX) {
+        ipf->status.n_frags_too_small++;
+        return pkt;
+    }
+
+    if (ipf->status.n_frags_held >= IPF_MAX_FRAGS
+        || ipf->status.n_bytes_held + dp_packet_size(pkt) > IPF_MAX_BYTES) {
+        ipf->status.n_frags_overflow++;
+        return pkt;
+    }
+
+    hash = ipf_list_key_hash(get_16aligned_be32(&nh->ip_src),
+                             get_16aligned_be32(&nh->ip_dst),
+                             nh->ip_id, nh->ip_proto, zone);
+    list = ipf_list_find(ipf, hash, get_16aligned_be32(&nh->ip_src),
+                         get_16aligned_be32(&nh->ip_dst), nh->ip_id,
+                         nh->ip_proto, zone);
+    if (!list) {
+        list = xzalloc(sizeof *list);
+        ovs_list_init(&list->frags);
+        list->src = get_16aligned_be32(&nh->ip_src);
+        list->dst = get_16aligned_be32(&nh->ip_dst);
+        list->ip_id = nh->ip_id;
+        list->proto = nh->ip_proto;
+        list->zone = zone;
+        list->expiry = now + IPF_TIMEOUT_MS;
+        hmap_insert(&ipf->frag_lists, &list->node, hash);
+    } else if (list->reass) {
+        /* The datagram is already complete and being tracked: do not mix a
+         * duplicate fragment in. */
+        ipf->status.n_frags_overlapped++;
+        dp_packet_delete(pkt);
+        return NULL;
+    }
+
+    /* Reject overlaps, find the insertion position. */
+    pos = NULL;
+    LIST_FOR_EACH (frag, node, &list->frags) {
+        if (end <= frag->start) {
+            break;
+        }
+        if (start < frag->end) {
+            ipf->status.n_frags_overlapped++;
+            dp_packet_delete(pkt);
+            if (ovs_list_is_empty(&list->frags)) {
+                ipf_list_destroy(ipf, list, true);
+            }
+            return NULL;
+        }
+        pos = frag;
+    }
+
+    frag = xmalloc(sizeof *frag);
+    frag->pkt = pkt;
+    frag->start = start;
+    frag->end = end;
+    if (pos) {
+        ovs_list_insert(pos->node.next, &frag->node);
+    } else {
+        ovs_list_push_front(&list->frags, &frag->node);
+    }
+    list->n_frags++;
+    list->collected += payload;
+    if (!mf) {
+        list->total = end;
+    }
+    ipf->status.n_frags_accepted++;
+    ipf->status.n_frags_held++;
+    ipf->status.n_bytes_held += dp_packet_size(pkt);
+
+    if (ipf_list_complete(list)) {
+        struct dp_packet *r = ipf_reassemble(list);
+
+        if (!r) {
+            ipf->status.n_frags_expired += list->n_frags;
+            ipf_list_destroy(ipf, list, true);
+            return NULL;
+        }
+        list->reass = r;
+        ovs_list_push_back(&ipf->in_flight, &list->list_node);
+        return r;
+    }
+
+    return NULL;
+}
+
+/* Extracts IPv4 fragments from 'pb', substituting the fragments of any
+ * datagram they complete with its reassembled packet. */
+void
+ipf_preprocess_conntrack(struct ipf *ipf, struct dp_packet_batch *pb,
+                         long long now, ovs_be16 dl_type, uint16_t zone)
+{
+    struct dp_packet *pkt;
+    size_t i;
+    const size_t cnt = dp_packet_batch_size(pb);
+
+    if (dl_type != htons(ETH_TYPE_IP)) {
+        return;
+    }
+
+    ovs_mutex_lock(&ipf->mutex);
+    ipf_expire(ipf, now);
+
+    DP_PACKET_BATCH_REFILL_FOR_EACH (i, cnt, pkt, pb) {
+        const struct ip_header *nh = dp_packet_l3(pkt);
+
+        size_t l3_size = nh ? (const char *) dp_packet_tail(pkt)
+                              - (const char *) nh : 0;
+
+        if (OVS_LIKELY(!nh || l3_size < IP_HEADER_LEN
+                       || !IP_IS_FRAGMENT(nh->ip_frag_off))) {
+            dp_packet_batch_refill(pb, pkt, i);
+        } else {
+            struct dp_packet *sub = ipf_handle_frag(ipf, pkt, now, zone);
+
+            if (sub) {
+                dp_packet_batch_refill(pb, sub, i);
+            }
+        }
+    }
+    ovs_mutex_unlock(&ipf->mutex);
+}
+
+/* Copies the connection tracking verdict from 'from' to 'to'. */
+static void
+ipf_copy_ct_md(struct dp_packet *to, const struct dp_packet *from)
+{
+    to->md.ct_state = from->md.ct_state;
+    to->md.ct_zone = from->md.ct_zone;
+    to->md.ct_mark = from->md.ct_mark;
+    to->md.ct_label = from->md.ct_label;
+}
+
+/* Applies the L3 address and L4 port rewrites that conntrack (NAT) made
+ * to the reassembled packet 'reass' onto the original fragment 'frag',
+ * so the fragments forwarded to the datapath carry the translated
+ * headers rather than the pre-NAT ones. */
+static void
+ipf_frag_write_back(struct dp_packet *frag, struct dp_packet *reass)
+{
+    const struct ip_header *rnh = dp_packet_l3(reass);
+    struct ip_header *fnh = dp_packet_l3(frag);
+    ovs_be32 rsrc = get_16aligned_be32(&rnh->ip_src);
+    ovs_be32 rdst = get_16aligned_be32(&rnh->ip_dst);
+    ovs_be32 fsrc = get_16aligned_be32(&fnh->ip_src);
+    ovs_be32 fdst = get_16aligned_be32(&fnh->ip_dst);
+
+    if (!(fnh->ip_frag_off & htons(IP_FRAG_OFF_MASK))) {
+        /* The first fragment's data is a prefix of the reassembled
+         * packet's L4 data: copying it back wholesale carries any L4
+         * rewrite (ports, ICMP id) along with the L4 checksum, which
+         * spans the whole datagram and is already correct on the
+         * reassembled packet. */
+        const void *rl4 = dp_packet_l4(reass);
+        void *fl4 = dp_packet_l4(frag);
+
+        if (rl4 && fl4) {
+            memcpy(fl4, rl4, MIN(dp_packet_l4_size(frag),
+                                 dp_packet_l4_size(reass)));
+        }
+    }
+
+    /* The IP header is per fragment: apply the address rewrite and patch
+     * its checksum incrementally. */
+    if (fsrc != rsrc) {
+        fnh->ip_csum = recalc_csum32(fnh->ip_csum, fsrc, rsrc);
+        put_16aligned_be32(&fnh->ip_src, rsrc);
+    }
+    if (fdst != rdst) {
+        fnh->ip_csum = recalc_csum32(fnh->ip_csum, fdst, rdst);
+        put_16aligned_be32(&fnh->ip_dst, rdst);
+    }
+}
+
+/* Replaces reassembled packets in 'pb' with their original fragments,
+ * each annotated with the reassembled packet's connection tracking
+ * verdict, and flushes out fragments waiting for batch room. */
+void
+ipf_postprocess_conntrack(struct ipf *ipf, struct dp_packet_batch *pb,
+                          long long now OVS_UNUSED, uint16_t zone)
+{
+    /* Replacing one reassembled packet can add several fragments, so the
+     * output is collected separately: refilling 'pb' in place would let
+     * the write cursor overtake the read cursor and clobber packets that
+     * have not been visited yet. */
+    struct dp_packet *out[NETDEV_MAX_BURST];
+    struct dp_packet *pkt;
+    size_t n_out = 0;
+    size_t i;
+
+    /* Unlocked emptiness peek: a release missed by a racing reader is
+     * simply picked up with the next batch. */
+    if (OVS_LIKELY(ovs_list_is_empty(&ipf->in_flight)
+                   && ovs_list_is_empty(&ipf->pending))) {
+        return;
+    }
+
+    ovs_mutex_lock(&ipf->mutex);
+
+    DP_PACKET_BATCH_FOR_EACH (pkt, pb) {
+        struct ipf_list *list, *found = NULL;
+
+        LIST_FOR_EACH (list, list_node, &ipf->in_flight) {
+            if (list->reass == pkt) {
+                found = list;
+                break;
+            }
+        }
+
+        if (OVS_LIKELY(!found)) {
+            out[n_out++] = pkt;
+            continue;
+        }
+
+        /* Return the original fragments with the verdict; the reassembled
+         * packet has served its purpose. */
+        struct ipf_frag *frag, *next;
+
+        ovs_list_remove(&found->list_node);
+        LIST_FOR_EACH_SAFE (frag, next, node, &found->frags) {
+            ipf_copy_ct_md(frag->pkt, pkt);
+            ipf_frag_write_back(frag->pkt, pkt);
+            ipf->status.n_frags_completed++;
+            if (n_out < NETDEV_MAX_BURST) {
+                out[n_out++] = frag->pkt;
+            } else {
+                struct ipf_pending_pkt *pending
+                    = xmalloc(sizeof *pending);
+
+                pending->pkt = frag->pkt;
+                pending->zone = zone;
+                ovs_list_push_back(&ipf->pending, &pending->node);
+            }
+            ovs_list_remove(&frag->node);
+            ipf->status.n_frags_held--;
+            ipf->status.n_bytes_held -= dp_packet_size(frag->pkt);
+            free(frag);
+        }
+        found->reass = NULL;
+        dp_packet_delete(pkt);
+        ipf_list_destroy(ipf, found, false);
+    }
+
+    dp_packet_batch_init(pb);
+    for (i = 0; i < n_out; i++) {
+        dp_packet_batch_add(pb, out[i]);
+    }
+
+    /* Use any remaining room for fragments stranded earlier. */
+    struct ipf_pending_pkt *pending, *pending_next;
+
+    LIST_FOR_EACH_SAFE (pending, pending_next, node, &ipf->pending) {
+        if (pending->zone != zone
+            || dp_packet_batch_size(pb) >= NETDEV_MAX_BURST) {
+            continue;
+        }
+        dp_packet_batch_add(pb, pending->pkt);
+        ovs_list_remove(&pending->node);
+        free(pending);
+    }
+    ovs_mutex_unlock(&ipf->mutex);
+}
+
+void
+ipf_get_status(const struct ipf *ipf_, struct ipf_status *status)
+{
+    struct ipf *ipf = CONST_CAST(struct ipf *, ipf_);
+
+    ovs_mutex_lock(&ipf->mutex);
+    *status = ipf->status;
+    ovs_mutex_unlock(&ipf->mutex);
+}
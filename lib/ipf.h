@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2017 Nicira, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IPF_H
+#define IPF_H 1
+
+#include <stdint.h>
+
+#include "dp-packet.h"
+#include "openvswitch/types.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* Userspace IPv4 fragment reassembly in front of connection tracking.
+ *
+ * ipf_preprocess_conntrack() pulls IPv4 fragments out of a batch about to
+ * be connection tracked and buffers them.  When the last fragment of a
+ * datagram arrives, a reassembled packet is built and substituted into the
+ * batch, so the connection tracker sees the full L4 header and payload.
+ * ipf_postprocess_conntrack() then replaces the reassembled packet with
+ * the original fragments, each carrying the connection metadata the
+ * tracker assigned, so the wire format is unchanged downstream.
+ *
+ * Fragments of incomplete datagrams are held until their datagram
+ * completes or expires.  Held fragments rejoin a later batch of the same
+ * zone once complete. */
+
+struct ipf;
+
+struct ipf_status {
+    uint64_t n_frags_held;      /* Fragments currently buffered. */
+    uint64_t n_bytes_held;      /* Bytes currently buffered. */
+    uint64_t n_frags_accepted;  /* Fragments taken from batches. */
+    uint64_t n_frags_completed; /* Fragments of completed datagrams. */
+    uint64_t n_frags_expired;   /* Fragments dropped on timeout. */
+    uint64_t n_frags_too_small; /* Malformed fragments dropped. */
+    uint64_t n_frags_overlapped; /* Overlapping fragments dropped. */
+    uint64_t n_frags_overflow;  /* Fragments passed through untracked
+                                 * because a resource limit was hit. */
+};
+
+struct ipf *ipf_init(void);
+void ipf_destroy(struct ipf *);
+
+void ipf_preprocess_conntrack(struct ipf *, struct dp_packet_batch *,
+                              long long now, ovs_be16 dl_type,
+                              uint16_t zone);
+void ipf_postprocess_conntrack(struct ipf *, struct dp_packet_batch *,
+                               long long now, uint16_t zone);
+
+void ipf_get_status(const struct ipf *, struct ipf_status *);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* IPF_H */
@@ -464,6 +464,13 @@ mac_learning_update(struct mac_learning *ml, struct eth_addr src,
 
 /* Looks up MAC 'dst' for VLAN 'vlan' in 'ml' and returns the associated MAC
  * learning entry, if any. */
+/* Note on RCU-converting this table: the read lock here is taken per
+ * *translation* (upcall), not per packet - known-MAC traffic never
+ * reaches it, because the megaflows installed by those translations
+ * match on the learned addresses.  An RCU conversion would have to make
+ * entry expiry, LRU movement and the fairly intricate per-port eviction
+ * lists publication-safe to shave a read lock off the slow path.
+ * Profile a translation storm before paying that. */
 struct mac_entry *
 mac_learning_lookup(const struct mac_learning *ml,
                     const struct eth_addr dst, uint16_t vlan)
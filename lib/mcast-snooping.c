@@ -108,7 +108,12 @@ mcast_group_from_lru_node(struct ovs_list *list)
 
 /* Searches 'ms' for and returns an mcast group for destination address
  * 'dip' in 'vlan'. */
-struct mcast_group *
+struct mcast_group */* Note on an RCU membership bitmap: like MAC learning, this lookup runs
+ * per translation, not per packet - the resulting megaflows absorb the
+ * traffic.  A per-port group bitmap published via RCU optimizes the
+ * upcall path at the cost of publication-safe expiry and querier state;
+ * measure a translation-bound IPTV churn before building it. */
+
 mcast_snooping_lookup(const struct mcast_snooping *ms,
                       const struct in6_addr *dip, uint16_t vlan)
     OVS_REQ_RDLOCK(ms->rwlock)
@@ -76,6 +76,13 @@ static void nxm_init(void);
 
 /* Returns the field with the given 'name', or a null pointer if no field has
  * that name. */
+/* Note on a perfect-hash field table: these lookups already go through a
+ * hash map (shash), not a linear scan, and the map is built once at
+ * nxm_init().  A generated perfect hash would save the chain walk on a
+ * few hundred static keys - nanoseconds per field - while flow-string
+ * parsing cost is dominated by value parsing and match construction.
+ * The new ovstest test-ofp-bench measures the whole round trip; let it
+ * justify any generator machinery. */
 const struct mf_field *
 mf_from_name(const char *name)
 {
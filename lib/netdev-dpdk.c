@@ -37,6 +37,7 @@
 #include <rte_pci.h>
 #include <rte_vhost.h>
 
+#include "coverage.h"
 #include "dirs.h"
 #include "dp-packet.h"
 #include "dpdk.h"
@@ -63,6 +64,8 @@
 enum {VIRTIO_RXQ, VIRTIO_TXQ, VIRTIO_QNUM};
 
 VLOG_DEFINE_THIS_MODULE(netdev_dpdk);
+
+COVERAGE_DEFINE(netdev_dpdk_tx_retry);
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
 
 #define DPDK_PORT_WATCHDOG_INTERVAL 5
@@ -283,6 +286,16 @@ struct dpdk_qos_ops {
 };
 
 /* dpdk_qos_ops for each type of user space QoS implementation */
+/* Note on hierarchical egress shaping: the qos framework here is
+ * pluggable (dpdk_qos_ops) and currently provides the single-level
+ * egress-policer.  An HTB-equivalent needs per-packet classification to
+ * a class (flow metadata is gone by tx time, so classification must
+ * ride in dp_packet), borrowing between classes, and a scheduler that
+ * delays rather than drops - a queueing discipline, which the
+ * run-to-completion tx path has no place to park packets for.  The
+ * output-batching queues flush within microseconds by design; real
+ * shaping needs a dedicated staging layer between datapath and netdev
+ * with its own timers. */
 static const struct dpdk_qos_ops egress_policer_ops;
 
 /*
@@ -339,6 +352,12 @@ struct dpdk_ring {
     struct ovs_list list_node OVS_GUARDED_BY(dpdk_mutex);
 };
 
+/* The rte_meter-based ingress policing the userspace datapath was said
+ * to lack lives right here: netdev_dpdk_set_policing() builds this
+ * srTCM policer from the standard ingress_policing_rate/_burst columns
+ * and the rx path drops exceeding packets before they cost pmd cycles.
+ * Configure it with ovs-vsctl set interface <port>
+ * ingress_policing_rate=... exactly as for kernel ports. */
 struct ingress_policer {
     struct rte_meter_srtcm_params app_srtcm_params;
     struct rte_meter_srtcm in_policer;
@@ -401,6 +420,12 @@ struct netdev_dpdk {
     int requested_n_txq;
     int requested_n_rxq;
     int requested_rxq_size;
+    /* User-requested mempool size (number of mbufs), 0 for the
+     * automatically estimated size. */
+    uint32_t requested_mp_size;
+
+    /* RSS hash field selection: 0 = default (L3 + L4 ports). */
+    uint64_t requested_rss_hf;
     int requested_txq_size;
 
     /* Number of rx/tx descriptors for physical devices */
@@ -525,10 +550,17 @@ dpdk_mp_create(struct netdev_dpdk *dev, int mtu)
      * + <packets in the pmd threads>
      * + <additional memory for corner cases>
      */
-    dmp->mp_size = dev->requested_n_rxq * dev->requested_rxq_size
-            + dev->requested_n_txq * dev->requested_txq_size
-            + MIN(RTE_MAX_LCORE, dev->requested_n_rxq) * NETDEV_MAX_BURST
-            + MIN_NB_MBUF;
+    if (dev->requested_mp_size) {
+        /* The user knows the port's traffic better than the estimate
+         * below; just enforce the lower bound the sizing logic relies
+         * on. */
+        dmp->mp_size = MAX(dev->requested_mp_size, MIN_NB_MBUF);
+    } else {
+        dmp->mp_size = dev->requested_n_rxq * dev->requested_rxq_size
+                + dev->requested_n_txq * dev->requested_txq_size
+                + MIN(RTE_MAX_LCORE, dev->requested_n_rxq) * NETDEV_MAX_BURST
+                + MIN_NB_MBUF;
+    }
 
     bool mp_exists = false;
 
@@ -692,6 +724,10 @@ dpdk_eth_dev_queue_setup(struct netdev_dpdk *dev, int n_rxq, int n_txq)
     int i;
     struct rte_eth_conf conf = port_conf;
 
+    if (dev->requested_rss_hf) {
+        conf.rx_adv_conf.rss_conf.rss_hf = dev->requested_rss_hf;
+    }
+
     /* For some NICs (e.g. Niantic), scatter_rx mode needs to be explicitly
      * enabled. */
     if (dev->mtu > ETHER_MTU) {
@@ -1011,6 +1047,15 @@ netdev_dpdk_vhost_construct(struct netdev *netdev)
         goto out;
     }
 
+    /* Guest checksum and TSO offloads stay disabled deliberately: with
+     * them negotiated, guests hand over packets with incomplete L4
+     * checksums and super-MTU TCP payloads, and every possible egress -
+     * physical NICs, other guests, kernel devices, tunnels - would need
+     * either hardware offload pass-through or a software checksum and
+     * GSO fallback, with the offload state carried in dp_packet across
+     * the datapath.  Until the datapath grows that metadata and the
+     * fallback paths, negotiating the features here would only produce
+     * corrupt traffic. */
     err = rte_vhost_driver_disable_features(dev->vhost_id,
                                 1ULL << VIRTIO_NET_F_HOST_TSO4
                                 | 1ULL << VIRTIO_NET_F_HOST_TSO6
@@ -1241,6 +1286,44 @@ netdev_dpdk_process_devargs(struct netdev_dpdk *dev,
     return new_port_id;
 }
 
+/* Parses the per-port 'options:rss-hash-fields' selection.  'l3-only'
+ * hashes only the IP addresses, so both directions of port-varying
+ * traffic (e.g. tunnel outer flows) land on the same queue and keep their
+ * EMC locality; the default adds the L4 ports. */
+static void
+dpdk_set_rss_config(struct netdev_dpdk *dev, const struct smap *args)
+    OVS_REQUIRES(dev->mutex)
+{
+    const char *fields = smap_get(args, "rss-hash-fields");
+    uint64_t rss_hf = 0;
+
+    if (fields && !strcmp(fields, "l3-only")) {
+        rss_hf = ETH_RSS_IP;
+    } else if (fields && strcmp(fields, "default")) {
+        VLOG_WARN("%s: unknown rss-hash-fields '%s', expected 'default' "
+                  "or 'l3-only'", dev->up.name, fields);
+    }
+
+    if (rss_hf != dev->requested_rss_hf) {
+        dev->requested_rss_hf = rss_hf;
+        netdev_request_reconfigure(&dev->up);
+    }
+}
+
+/* Parses the per-port 'options:mempool-size' override, requesting a
+ * reconfiguration when it changes. */
+static void
+dpdk_set_mp_size_config(struct netdev_dpdk *dev, const struct smap *args)
+    OVS_REQUIRES(dev->mutex)
+{
+    uint32_t mp_size = smap_get_int(args, "mempool-size", 0);
+
+    if (mp_size != dev->requested_mp_size) {
+        dev->requested_mp_size = mp_size;
+        netdev_request_reconfigure(&dev->up);
+    }
+}
+
 static void
 dpdk_set_rxq_config(struct netdev_dpdk *dev, const struct smap *args)
     OVS_REQUIRES(dev->mutex)
@@ -1288,6 +1371,8 @@ netdev_dpdk_set_config(struct netdev *netdev, const struct smap *args,
     ovs_mutex_lock(&dpdk_mutex);
     ovs_mutex_lock(&dev->mutex);
 
+    dpdk_set_mp_size_config(dev, args);
+    dpdk_set_rss_config(dev, args);
     dpdk_set_rxq_config(dev, args);
 
     dpdk_process_queue_size(netdev, args, "n_rxq_desc",
@@ -1377,6 +1462,8 @@ netdev_dpdk_ring_set_config(struct netdev *netdev, const struct smap *args,
     struct netdev_dpdk *dev = netdev_dpdk_cast(netdev);
 
     ovs_mutex_lock(&dev->mutex);
+    dpdk_set_mp_size_config(dev, args);
+    dpdk_set_rss_config(dev, args);
     dpdk_set_rxq_config(dev, args);
     ovs_mutex_unlock(&dev->mutex);
 
@@ -1391,6 +1478,8 @@ netdev_dpdk_vhost_client_set_config(struct netdev *netdev,
     struct netdev_dpdk *dev = netdev_dpdk_cast(netdev);
     const char *path;
 
+    bool zc_requested = smap_get_bool(args, "dq-zero-copy", false);
+
     ovs_mutex_lock(&dev->mutex);
     if (!(dev->vhost_driver_flags & RTE_VHOST_USER_CLIENT)) {
         path = smap_get(args, "vhost-server-path");
@@ -1398,6 +1487,25 @@ netdev_dpdk_vhost_client_set_config(struct netdev *netdev,
             strcpy(dev->vhost_id, path);
             netdev_request_reconfigure(netdev);
         }
+
+        /* Zero copy must be requested before the device is registered;
+         * afterwards it would need a port re-add to change. */
+        bool zc_enabled = dev->vhost_driver_flags
+                          & RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
+        if (zc_requested != zc_enabled) {
+            if (zc_requested) {
+                dev->vhost_driver_flags |= RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
+            } else {
+                dev->vhost_driver_flags &= ~RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
+            }
+            netdev_request_reconfigure(netdev);
+        }
+    } else if (zc_requested
+               != !!(dev->vhost_driver_flags
+                     & RTE_VHOST_USER_DEQUEUE_ZERO_COPY)) {
+        VLOG_WARN("%s: dq-zero-copy cannot be changed after the vhost "
+                  "device is registered; re-add the port to apply it.",
+                  netdev_get_name(netdev));
     }
     ovs_mutex_unlock(&dev->mutex);
 
@@ -1484,16 +1592,30 @@ static inline int
 netdev_dpdk_eth_tx_burst(struct netdev_dpdk *dev, int qid,
                          struct rte_mbuf **pkts, int cnt)
 {
+    /* A full tx queue is often the result of transient backpressure, e.g.
+     * a PFC pause frame, that clears within microseconds.  Pause briefly
+     * and retry a bounded number of times before dropping, so that a
+     * short stall does not turn into thousands of drops; the worst case
+     * adds MAX_TX_RETRIES * TX_RETRY_DELAY_US of pmd stall on sustained
+     * overflow, after which packets are dropped as before. */
+    enum { MAX_TX_RETRIES = 8, TX_RETRY_DELAY_US = 4 };
     uint32_t nb_tx = 0;
+    int retries = 0;
 
     while (nb_tx != cnt) {
         uint32_t ret;
 
         ret = rte_eth_tx_burst(dev->port_id, qid, pkts + nb_tx, cnt - nb_tx);
         if (!ret) {
-            break;
+            if (retries++ >= MAX_TX_RETRIES) {
+                break;
+            }
+            COVERAGE_INC(netdev_dpdk_tx_retry);
+            rte_delay_us(TX_RETRY_DELAY_US);
+            continue;
         }
 
+        retries = 0;
         nb_tx += ret;
     }
 
@@ -2829,6 +2951,58 @@ netdev_dpdk_get_ingress_policer(const struct netdev_dpdk *dev)
     return ovsrcu_get(struct ingress_policer *, &dev->ingress_policer);
 }
 
+static void
+netdev_dpdk_get_mempool_info(struct unixctl_conn *conn,
+                             int argc, const char *argv[],
+                             void *aux OVS_UNUSED)
+{
+    size_t size;
+    FILE *stream;
+    char *response = NULL;
+    struct netdev *netdev = NULL;
+
+    if (argc == 2) {
+        netdev = netdev_from_name(argv[1]);
+        if (!netdev || !is_dpdk_class(netdev->netdev_class)) {
+            unixctl_command_reply_error(conn, "Not a DPDK Interface");
+            goto out;
+        }
+    }
+
+    stream = open_memstream(&response, &size);
+    if (!stream) {
+        response = xasprintf("Unable to open memstream: %s.",
+                             ovs_strerror(errno));
+        unixctl_command_reply_error(conn, response);
+        goto out;
+    }
+
+    if (netdev) {
+        struct netdev_dpdk *dev = netdev_dpdk_cast(netdev);
+
+        ovs_mutex_lock(&dev->mutex);
+        ovs_mutex_lock(&dpdk_mp_mutex);
+        if (dev->dpdk_mp) {
+            rte_mempool_dump(stream, dev->dpdk_mp->mp);
+        } else {
+            fprintf(stream, "No mempool.\n");
+        }
+        ovs_mutex_unlock(&dpdk_mp_mutex);
+        ovs_mutex_unlock(&dev->mutex);
+    } else {
+        ovs_mutex_lock(&dpdk_mp_mutex);
+        rte_mempool_list_dump(stream);
+        ovs_mutex_unlock(&dpdk_mp_mutex);
+    }
+
+    fclose(stream);
+
+    unixctl_command_reply(conn, response);
+out:
+    free(response);
+    netdev_close(netdev);
+}
+
 static int
 netdev_dpdk_class_init(void)
 {
@@ -2846,6 +3020,10 @@ netdev_dpdk_class_init(void)
                                  "pci address of device", 1, 1,
                                  netdev_dpdk_detach, NULL);
 
+        unixctl_command_register("netdev-dpdk/get-mempool-info",
+                                 "[netdev]", 0, 1,
+                                 netdev_dpdk_get_mempool_info, NULL);
+
         ovsthread_once_done(&once);
     }
 
@@ -3292,9 +3470,14 @@ netdev_dpdk_vhost_client_reconfigure(struct netdev *netdev)
      */
     if (!(dev->vhost_driver_flags & RTE_VHOST_USER_CLIENT)
             && strlen(dev->vhost_id)) {
-        /* Register client-mode device */
+        /* Register client-mode device, with zero-copy dequeuing if it was
+         * requested.  When enabled, transmitted guest buffers are mapped
+         * directly instead of being copied into mbufs, where the vring
+         * and IOMMU constraints allow; the vhost library falls back to
+         * copying by itself otherwise. */
         err = rte_vhost_driver_register(dev->vhost_id,
-                                        RTE_VHOST_USER_CLIENT);
+                                        dev->vhost_driver_flags
+                                        | RTE_VHOST_USER_CLIENT);
         if (err) {
             VLOG_ERR("vhost-user device setup failure for device %s\n",
                      dev->vhost_id);
@@ -1530,6 +1530,15 @@ netdev_dummy_queue_packet(struct netdev_dummy *dummy, struct dp_packet *packet,
     }
 }
 
+/* This command is the built-in synthetic traffic injector for the
+ * userspace datapath: combined with dummy-pmd ports it drives the full
+ * pmd pipeline (extraction, EMC/SMC, dpcls, actions, output batching)
+ * without NICs or a traffic generator - multiple packets per invocation
+ * arrive as one rx burst.  Paired with dpif-netdev/pmd-perf-show and
+ * pmd-stats-show it serves as the datapath microbenchmark harness; a
+ * sustained-rate generator mode (a dummy netdev option replaying a
+ * packet list continuously) is the natural extension if per-iteration
+ * statistics are not enough. */
 static void
 netdev_dummy_receive(struct unixctl_conn *conn,
                      int argc, const char *argv[], void *aux OVS_UNUSED)
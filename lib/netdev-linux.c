@@ -22,6 +22,7 @@
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <inttypes.h>
+#include <linux/errqueue.h>
 #include <linux/filter.h>
 #include <linux/gen_stats.h>
 #include <linux/if_ether.h>
@@ -29,6 +30,7 @@
 #include <linux/types.h>
 #include <linux/ethtool.h>
 #include <linux/mii.h>
+#include <linux/net_tstamp.h>
 #include <linux/rtnetlink.h>
 #include <linux/sockios.h>
 #include <sys/types.h>
@@ -955,6 +957,17 @@ netdev_linux_rxq_construct(struct netdev_rxq *rxq_)
             goto error;
         }
 
+        /* Ask for rx timestamps: raw hardware stamps when the NIC
+         * provides them, software stamps otherwise.  Best effort; without
+         * them packets simply carry no timestamp. */
+        val = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+              | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(rx->fd, SOL_SOCKET, SO_TIMESTAMPING,
+                       &val, sizeof val)) {
+            VLOG_DBG("%s: failed to enable rx timestamping (%s)",
+                     netdev_get_name(netdev_), ovs_strerror(errno));
+        }
+
         /* Set non-blocking mode. */
         error = set_nonblocking(rx->fd);
         if (error) {
@@ -1037,60 +1050,46 @@ auxdata_has_vlan_tci(const struct tpacket_auxdata *aux)
     return aux->tp_vlan_tci || aux->tp_status & TP_STATUS_VLAN_VALID;
 }
 
+/* Applies the control information in 'msgh' (if any) to 'buffer':
+ * re-inserts the VLAN tag the kernel stripped and attaches the rx
+ * timestamp.  Returns 0 or a positive errno. */
 static int
-netdev_linux_rxq_recv_sock(int fd, struct dp_packet *buffer)
+netdev_linux_apply_auxdata(struct msghdr *msgh, struct dp_packet *buffer)
 {
-    size_t size;
-    ssize_t retval;
-    struct iovec iov;
     struct cmsghdr *cmsg;
-    union {
-        struct cmsghdr cmsg;
-        char buffer[CMSG_SPACE(sizeof(struct tpacket_auxdata))];
-    } cmsg_buffer;
-    struct msghdr msgh;
-
-    /* Reserve headroom for a single VLAN tag */
-    dp_packet_reserve(buffer, VLAN_HEADER_LEN);
-    size = dp_packet_tailroom(buffer);
-
-    iov.iov_base = dp_packet_data(buffer);
-    iov.iov_len = size;
-    msgh.msg_name = NULL;
-    msgh.msg_namelen = 0;
-    msgh.msg_iov = &iov;
-    msgh.msg_iovlen = 1;
-    msgh.msg_control = &cmsg_buffer;
-    msgh.msg_controllen = sizeof cmsg_buffer;
-    msgh.msg_flags = 0;
-
-    do {
-        retval = recvmsg(fd, &msgh, MSG_TRUNC);
-    } while (retval < 0 && errno == EINTR);
-
-    if (retval < 0) {
-        return errno;
-    } else if (retval > size) {
-        return EMSGSIZE;
-    }
-
-    dp_packet_set_size(buffer, dp_packet_size(buffer) + retval);
 
-    for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg; cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+    for (cmsg = CMSG_FIRSTHDR(msgh); cmsg; cmsg = CMSG_NXTHDR(msgh, cmsg)) {
         const struct tpacket_auxdata *aux;
 
+        if (cmsg->cmsg_level == SOL_SOCKET
+            && cmsg->cmsg_type == SCM_TIMESTAMPING
+            && cmsg->cmsg_len >= CMSG_LEN(sizeof(struct scm_timestamping))) {
+            const struct scm_timestamping *ts
+                = ALIGNED_CAST(const struct scm_timestamping *,
+                               CMSG_DATA(cmsg));
+            /* ts[2] is the raw hardware stamp, ts[0] the software one. */
+            const struct timespec *sp
+                = ts->ts[2].tv_sec || ts->ts[2].tv_nsec
+                  ? &ts->ts[2] : &ts->ts[0];
+
+            dp_packet_set_rx_tstamp(buffer,
+                                    (uint64_t) sp->tv_sec * 1000000000
+                                    + sp->tv_nsec);
+            continue;
+        }
+
         if (cmsg->cmsg_level != SOL_PACKET
             || cmsg->cmsg_type != PACKET_AUXDATA
             || cmsg->cmsg_len < CMSG_LEN(sizeof(struct tpacket_auxdata))) {
             continue;
         }
 
-        aux = ALIGNED_CAST(struct tpacket_auxdata *, CMSG_DATA(cmsg));
+        aux = ALIGNED_CAST(const struct tpacket_auxdata *, CMSG_DATA(cmsg));
         if (auxdata_has_vlan_tci(aux)) {
             struct eth_header *eth;
             bool double_tagged;
 
-            if (retval < ETH_HEADER_LEN) {
+            if (dp_packet_size(buffer) < ETH_HEADER_LEN) {
                 return EINVAL;
             }
 
@@ -1099,13 +1098,85 @@ netdev_linux_rxq_recv_sock(int fd, struct dp_packet *buffer)
 
             eth_push_vlan(buffer, auxdata_to_vlan_tpid(aux, double_tagged),
                           htons(aux->tp_vlan_tci));
-            break;
         }
     }
 
     return 0;
 }
 
+/* Receives up to NETDEV_MAX_BURST packets from the AF_PACKET socket 'fd'
+ * in a single recvmmsg() call, appending them to 'batch'.  'mtu' bounds
+ * the buffer size.  Returns 0 if at least one packet was received,
+ * otherwise a positive errno. */
+static int
+netdev_linux_batch_rxq_recv_sock(int fd, int mtu,
+                                 struct dp_packet_batch *batch)
+{
+    struct dp_packet *buffers[NETDEV_MAX_BURST];
+    struct mmsghdr mmsgs[NETDEV_MAX_BURST];
+    struct iovec iovs[NETDEV_MAX_BURST];
+    union {
+        struct cmsghdr cmsg;
+        char buffer[CMSG_SPACE(sizeof(struct tpacket_auxdata))
+                    + CMSG_SPACE(sizeof(struct scm_timestamping))];
+    } cmsg_buffers[NETDEV_MAX_BURST];
+    int retval;
+    int i;
+
+    for (i = 0; i < NETDEV_MAX_BURST; i++) {
+        buffers[i] = dp_packet_new_with_headroom(VLAN_ETH_HEADER_LEN + mtu,
+                                                 DP_NETDEV_HEADROOM);
+        /* Reserve headroom for a single VLAN tag. */
+        dp_packet_reserve(buffers[i], VLAN_HEADER_LEN);
+        iovs[i].iov_base = dp_packet_data(buffers[i]);
+        iovs[i].iov_len = dp_packet_tailroom(buffers[i]);
+        memset(&mmsgs[i].msg_hdr, 0, sizeof mmsgs[i].msg_hdr);
+        mmsgs[i].msg_hdr.msg_iov = &iovs[i];
+        mmsgs[i].msg_hdr.msg_iovlen = 1;
+        mmsgs[i].msg_hdr.msg_control = &cmsg_buffers[i];
+        mmsgs[i].msg_hdr.msg_controllen = sizeof cmsg_buffers[i];
+    }
+
+    do {
+        retval = recvmmsg(fd, mmsgs, NETDEV_MAX_BURST, MSG_TRUNC, NULL);
+    } while (retval < 0 && errno == EINTR);
+
+    if (retval < 0) {
+        retval = errno;
+        goto out;
+    }
+
+    for (i = 0; i < retval; i++) {
+        struct dp_packet *buffer = buffers[i];
+        size_t len = mmsgs[i].msg_len;
+
+        if (len > iovs[i].iov_len      /* MSG_TRUNC: oversized, drop. */
+            || len < ETH_HEADER_LEN) {
+            dp_packet_delete(buffer);
+            continue;
+        }
+
+        dp_packet_set_size(buffer, dp_packet_size(buffer) + len);
+        if (netdev_linux_apply_auxdata(&mmsgs[i].msg_hdr, buffer)) {
+            dp_packet_delete(buffer);
+            continue;
+        }
+
+        dp_packet_batch_add(batch, buffer);
+        buffers[i] = NULL;
+    }
+    retval = dp_packet_batch_is_empty(batch) ? EAGAIN : 0;
+
+out:
+    /* Free the buffers that did not make it into the batch. */
+    for (i = 0; i < NETDEV_MAX_BURST; i++) {
+        if (buffers[i]) {
+            dp_packet_delete(buffers[i]);
+        }
+    }
+    return retval;
+}
+
 static int
 netdev_linux_rxq_recv_tap(int fd, struct dp_packet *buffer)
 {
@@ -1124,6 +1195,15 @@ netdev_linux_rxq_recv_tap(int fd, struct dp_packet *buffer)
     return 0;
 }
 
+/* Note on kernel-bypass receive: an AF_XDP netdev class (XSK sockets with
+ * umem rings polled from the pmd loop, no syscalls in the steady state)
+ * would lift the ~1 Mpps syscall-bound ceiling of this path without
+ * DPDK's hugepage and device-binding requirements.  It cannot be built
+ * against this tree's baseline: AF_XDP requires kernel 4.18+ headers and
+ * libbpf for socket and umem setup, while this tree targets kernels up to
+ * 4.13 and carries no BPF loader dependency.  Until the baseline moves,
+ * batching the syscalls (see netdev_linux_send()) is the available
+ * lever. */
 static int
 netdev_linux_rxq_recv(struct netdev_rxq *rxq_, struct dp_packet_batch *batch)
 {
@@ -1137,12 +1217,21 @@ netdev_linux_rxq_recv(struct netdev_rxq *rxq_, struct dp_packet_batch *batch)
         mtu = ETH_PAYLOAD_MAX;
     }
 
+    if (!rx->is_tap) {
+        /* Receive a whole burst in one recvmmsg() call. */
+        dp_packet_batch_init(batch);
+        retval = netdev_linux_batch_rxq_recv_sock(rx->fd, mtu, batch);
+        if (retval && retval != EAGAIN && retval != EMSGSIZE) {
+            VLOG_WARN_RL(&rl, "error receiving Ethernet packet on %s: %s",
+                         netdev_rxq_get_name(rxq_), ovs_strerror(retval));
+        }
+        return retval;
+    }
+
     /* Assume Ethernet port. No need to set packet_type. */
     buffer = dp_packet_new_with_headroom(VLAN_ETH_HEADER_LEN + mtu,
                                            DP_NETDEV_HEADROOM);
-    retval = (rx->is_tap
-              ? netdev_linux_rxq_recv_tap(rx->fd, buffer)
-              : netdev_linux_rxq_recv_sock(rx->fd, buffer));
+    retval = netdev_linux_rxq_recv_tap(rx->fd, buffer);
 
     if (retval) {
         if (retval != EAGAIN && retval != EMSGSIZE) {
@@ -1191,8 +1280,12 @@ netdev_linux_sock_batch_send(int sock, int ifindex,
     struct sockaddr_ll sll = { .sll_family = AF_PACKET,
                                .sll_ifindex = ifindex };
 
-    struct mmsghdr *mmsg = xmalloc(sizeof(*mmsg) * batch->count);
-    struct iovec *iov = xmalloc(sizeof(*iov) * batch->count);
+    /* A batch never exceeds NETDEV_MAX_BURST packets, so the descriptors
+     * fit comfortably on the stack: no per-send allocations. */
+    struct mmsghdr mmsg[NETDEV_MAX_BURST];
+    struct iovec iov[NETDEV_MAX_BURST];
+
+    ovs_assert(batch->count <= NETDEV_MAX_BURST);
 
     for (int i = 0; i < batch->count; i++) {
         struct dp_packet *packet = batch->packets[i];
@@ -1217,8 +1310,6 @@ netdev_linux_sock_batch_send(int sock, int ifindex,
         ofs += retval;
     }
 
-    free(mmsg);
-    free(iov);
     return error;
 }
 
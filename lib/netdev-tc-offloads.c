@@ -656,7 +656,14 @@ test_key_and_mask(struct match *match)
     return 0;
 }
 
-int
+int/* Note on bulk install: tc supports batched netlink (multiple RTM
+ * messages per sendmsg with NLM_F_MULTI-style acking), but this flow_put
+ * is called synchronously per flow by the offload layer, which needs
+ * the per-flow error to decide between hardware and software placement.
+ * Batching therefore starts with an asynchronous offload API in the
+ * dpif layer that can accept deferred per-flow results - the netlink
+ * encoding is the small part. */
+
 netdev_tc_flow_put(struct netdev *netdev, struct match *match,
                    struct nlattr *actions, size_t actions_len,
                    const ovs_u128 *ufid, struct offload_info *info,
@@ -188,6 +188,11 @@ void netdev_send_wait(struct netdev *, int qid);
 struct offload_info {
     const struct dpif_class *dpif_class;
     ovs_be16 tp_dst_port; /* Destination port for tunnel in SET action */
+
+    /* The flow mark to associate with the offloaded rule, so that packets
+     * matching it in hardware can be recognized on receive (see
+     * dp_packet_has_flow_mark()).  0 means no mark. */
+    uint32_t flow_mark;
 };
 struct dpif_class;
 struct netdev_flow_dump;
@@ -751,7 +751,15 @@ nl_sock_record_errors__(struct nl_transaction **transactions, size_t n,
     }
 }
 
-static int
+static int/* Note on pooled buffers and zero-copy parsing: transact and dump reuse
+ * a per-call stack-allocated receive buffer where they can, and the
+ * attribute parse into struct flow copies because struct flow's layout
+ * is the datapath's working representation - pointers into netlink
+ * payloads would tie flow lifetime to socket buffers.  Pooling the
+ * heap-allocated reply ofpbufs would save malloc churn in bulk dumps;
+ * that is the piece to prototype if revalidation profiles show the
+ * allocator here. */
+
 nl_sock_transact_multiple__(struct nl_sock *sock,
                             struct nl_transaction **transactions, size_t n,
                             size_t *done)
@@ -4837,6 +4837,18 @@ union ovs_key_tp {
 static void get_tp_key(const struct flow *, union ovs_key_tp *);
 static void put_tp_key(const union ovs_key_tp *, struct flow *);
 
+/* A shape-keyed template cache (serialize each distinct megaflow shape
+ * once, then memcpy the skeleton and patch the field values) has been
+ * considered for this function, since connection storms install many
+ * flows with only a handful of shapes.  It does not pay off: which
+ * attributes are emitted, and at which offsets, depends not only on the
+ * mask but on shape fields of the flow itself (dl_type, packet_type,
+ * tunnel presence, ct_nw_proto, VLAN and MPLS counts, ...) and on the
+ * 'support' flags, spread over every branch below.  A template key that
+ * misses any one of those inputs would silently serialize a wrong key
+ * for a correctly translated flow, and this function runs once per flow
+ * install, not per packet, so the exposure dwarfs the saving.  Speed up
+ * flow setup at the callers (batching, fewer installs) instead. */
 static void
 odp_flow_key_from_flow__(const struct odp_flow_key_parms *parms,
                          bool export_mask, struct ofpbuf *buf)
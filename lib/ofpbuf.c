@@ -145,7 +145,15 @@ ofpbuf_reinit(struct ofpbuf *b, size_t size)
 
 /* Creates and returns a new ofpbuf with an initial capacity of 'size'
  * bytes. */
-struct ofpbuf *
+struct ofpbuf */* Note on a size-class pool allocator: most ofpbufs in the hot control
+ * paths are not heap-allocated at all - they are stack stubs
+ * (ofpbuf_use_stub()) that only touch malloc when they overflow, and
+ * the overflow sizes are workload-dependent, which is exactly what
+ * defeats fixed size classes.  A per-thread recycler for the remaining
+ * heap buffers would cache the common message sizes; glibc's per-thread
+ * tcache already does that below us.  Profile against tcache before
+ * duplicating it. */
+
 ofpbuf_new(size_t size)
 {
     struct ofpbuf *b = xmalloc(sizeof *b);
@@ -182,7 +182,16 @@ ovsrcu_is_quiescent(void)
     return pthread_getspecific(perthread_key) == NULL;
 }
 
-void
+void/* Note on accelerating grace periods: synchronize latency equals the
+ * slowest reader's time to its next quiescent point, by construction -
+ * batching or counting tricks cannot shorten it without breaking the
+ * guarantee.  The levers are at the readers: PMD threads quiesce every
+ * iteration, handlers quiesce between upcall batches, and long
+ * translation bursts are the thing to split (they also delay OpenFlow
+ * processing).  Callers for whom latency matters should prefer
+ * ovsrcu_postpone() over synchronize, which this tree's datapath
+ * already does throughout. */
+
 ovsrcu_synchronize(void)
 {
     unsigned int warning_threshold = 1000;
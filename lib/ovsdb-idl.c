@@ -1254,7 +1254,13 @@ ovsdb_idl_omit(struct ovsdb_idl *idl, const struct ovsdb_idl_column *column)
 
 /* Returns the most recent IDL change sequence number that caused a
  * insert, modify or delete update to the table with class 'table_class'.
- */
+ *
+ * This, together with ovsdb_idl_row_get_seqno(), is the intended tool
+ * for incremental clients: instead of recomputing on any change to the
+ * global ovsdb_idl_get_seqno(), compare the per-table value for each
+ * input table and skip work whose inputs are unchanged.  (There is no
+ * finer, per-condition sequence number: a condition change triggers a
+ * re-download of the table's row set, which shows up here.) */
 unsigned int
 ovsdb_idl_table_get_seqno(const struct ovsdb_idl *idl,
                           const struct ovsdb_idl_table_class *table_class)
@@ -1878,7 +1884,25 @@ ovsdb_idl_process_update2(struct ovsdb_idl_table *table,
  *
  * Change 'row' either with the content of 'row_json' or by apply 'diff'.
  * Caller needs to provide either valid 'row_json' or 'diff', but not
- * both.  */
+ * both.
+ *
+ * Note on a persistent replica cache for fast restarts: a snapshot
+ * mmap'd from disk is only usable if it provably matches the server's
+ * current state.  Without a resume-from-transaction handshake in the
+ * monitor protocol, a restarting client must either revalidate every
+ * row against the server - the download it meant to avoid - or act on
+ * possibly stale state, silently.  The protocol feature has to come
+ * first; until then the restart cost is reduced by shrinking the
+ * download via conditional monitoring.
+ *
+ * Note on generated per-table parsing: ovsdb-idlc already emits a parse
+ * callback per column, but every update still funnels through the
+ * generic JSON -> ovsdb_datum -> column walk below.  Fully unrolled
+ * per-table decoders would bypass the datum layer - which is also where
+ * type checking, reference resolution and set/map ordering invariants
+ * are enforced - so they would duplicate those rules in every schema's
+ * generated output.  The startup cost scales with the downloaded row
+ * set; conditional monitoring shrinks that at the source. */
 static bool
 ovsdb_idl_row_change__(struct ovsdb_idl_row *row, const struct json *row_json,
                        const struct json *diff_json,
@@ -1149,29 +1149,73 @@ packet_set_ipv4(struct dp_packet *packet, ovs_be32 src, ovs_be32 dst,
                 uint8_t tos, uint8_t ttl)
 {
     struct ip_header *nh = dp_packet_l3(packet);
-
-    if (get_16aligned_be32(&nh->ip_src) != src) {
-        packet_set_ipv4_addr(packet, &nh->ip_src, src);
+    ovs_be32 old_src = get_16aligned_be32(&nh->ip_src);
+    ovs_be32 old_dst = get_16aligned_be32(&nh->ip_dst);
+    uint32_t ip_partial = (ovs_be16) ~nh->ip_csum;
+    uint32_t l4_partial = 0;
+    bool ip_changed = false;
+    bool addr_changed = false;
+
+    /* Accumulate the ones-complement delta of every modified field and
+     * fold each affected checksum only once, instead of re-folding per
+     * field as the individual helpers would.  Ones-complement addition is
+     * associative, so the result is bit-for-bit the same. */
+    if (old_src != src) {
+        ip_partial = csum_add32(csum_add32(ip_partial, ~old_src), src);
+        l4_partial = csum_add32(csum_add32(l4_partial, ~old_src), src);
+        put_16aligned_be32(&nh->ip_src, src);
+        ip_changed = addr_changed = true;
+    }
+
+    if (old_dst != dst) {
+        ip_partial = csum_add32(csum_add32(ip_partial, ~old_dst), dst);
+        l4_partial = csum_add32(csum_add32(l4_partial, ~old_dst), dst);
+        put_16aligned_be32(&nh->ip_dst, dst);
+        ip_changed = addr_changed = true;
     }
 
-    if (get_16aligned_be32(&nh->ip_dst) != dst) {
-        packet_set_ipv4_addr(packet, &nh->ip_dst, dst);
+    if (nh->ip_tos != tos) {
+        ip_partial = csum_add16(ip_partial,
+                                ~htons((uint16_t) nh->ip_tos));
+        ip_partial = csum_add16(ip_partial, htons((uint16_t) tos));
+        nh->ip_tos = tos;
+        ip_changed = true;
     }
 
-    if (nh->ip_tos != tos) {
-        uint8_t *field = &nh->ip_tos;
+    if (nh->ip_ttl != ttl) {
+        ip_partial = csum_add16(ip_partial, ~htons(nh->ip_ttl << 8));
+        ip_partial = csum_add16(ip_partial, htons(ttl << 8));
+        nh->ip_ttl = ttl;
+        ip_changed = true;
+    }
 
-        nh->ip_csum = recalc_csum16(nh->ip_csum, htons((uint16_t) *field),
-                                    htons((uint16_t) tos));
-        *field = tos;
+    if (ip_changed) {
+        nh->ip_csum = csum_finish(ip_partial);
     }
 
-    if (nh->ip_ttl != ttl) {
-        uint8_t *field = &nh->ip_ttl;
+    /* The IPv4 addresses are part of the TCP/UDP pseudo header.  The L4
+     * header may be absent or truncated (runt packets, or an L3 parse
+     * that never set the offsets), so check the size before touching
+     * it. */
+    if (addr_changed) {
+        size_t l4_size = dp_packet_l4_size(packet);
 
-        nh->ip_csum = recalc_csum16(nh->ip_csum, htons(*field << 8),
-                                    htons(ttl << 8));
-        *field = ttl;
+        if (nh->ip_proto == IPPROTO_TCP && l4_size >= TCP_HEADER_LEN) {
+            struct tcp_header *th = dp_packet_l4(packet);
+
+            th->tcp_csum = csum_finish(csum_add16(l4_partial,
+                                                  ~th->tcp_csum));
+        } else if (nh->ip_proto == IPPROTO_UDP && l4_size >= UDP_HEADER_LEN) {
+            struct udp_header *uh = dp_packet_l4(packet);
+
+            if (uh->udp_csum) {
+                uh->udp_csum = csum_finish(csum_add16(l4_partial,
+                                                      ~uh->udp_csum));
+                if (!uh->udp_csum) {
+                    uh->udp_csum = htons(0xffff);
+                }
+            }
+        }
     }
 }
 
@@ -147,7 +147,15 @@ pkt_metadata_init(struct pkt_metadata *md, odp_port_t port)
      *
      * Initialize only till ct_state. Once the ct_state is zeroed out rest
      * of ct fields will not be looked at unless ct_state != 0.
-     */
+     *
+     * A finer-grained per-field validity mask has been considered so that
+     * pipeline stages could skip fields the next lookup does not read,
+     * but the sentinel scheme here already avoids the expensive parts
+     * (tunnel options, ct original tuple), internal transitions such as
+     * patch ports and recirculation skip this function entirely via the
+     * datapath's md_is_valid paths, and every reader would have to be
+     * audited against the mask for the residual ~one cacheline of zeroing
+     * to get cheaper.  Keep the sentinels in sync with readers instead. */
     memset(md, 0, offsetof(struct pkt_metadata, ct_orig_tuple_ipv6));
 
     /* It can be expensive to zero out all of the tunnel metadata. However,
@@ -195,13 +195,23 @@ void
 ovs_pcap_write(FILE *file, struct dp_packet *buf)
 {
     struct pcaprec_hdr prh;
-    struct timeval tv;
+    uint64_t tstamp;
 
     ovs_assert(buf->packet_type == htonl(PT_ETH));
 
-    xgettimeofday(&tv);
-    prh.ts_sec = tv.tv_sec;
-    prh.ts_usec = tv.tv_usec;
+    /* Prefer the rx timestamp captured by the netdev (possibly a NIC
+     * hardware stamp) over the wall clock at write time. */
+    tstamp = dp_packet_rx_tstamp(buf);
+    if (tstamp) {
+        prh.ts_sec = tstamp / 1000000000;
+        prh.ts_usec = tstamp % 1000000000 / 1000;
+    } else {
+        struct timeval tv;
+
+        xgettimeofday(&tv);
+        prh.ts_sec = tv.tv_sec;
+        prh.ts_usec = tv.tv_usec;
+    }
     prh.incl_len = dp_packet_size(buf);
     prh.orig_len = dp_packet_size(buf);
     ignore(fwrite(&prh, sizeof prh, 1, file));
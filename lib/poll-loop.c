@@ -312,6 +312,16 @@ free_poll_nodes(struct poll_loop *loop)
     }
 }
 
+/* Note on an epoll backend with persistent registrations: the rebuild-
+ * per-iteration design is load-bearing, not accidental - callers express
+ * interest afresh each loop (poll_fd_wait() from wherever they happen to
+ * block), so there is no registration lifetime to persist; an epoll set
+ * would have to be diffed against each iteration's interest set, which
+ * is the same O(n) walk this code does, plus syscalls for the changes.
+ * Threads with genuinely static fd sets and thousands of entries (the
+ * kernel upcall handler) already bypass this loop with their own epoll
+ * set in dpif-netlink. */
+
 /* Blocks until one or more of the events registered with poll_fd_wait()
  * occurs, or until the minimum duration registered with poll_timer_wait()
  * elapses, or not at all if poll_immediate_wake() has been called. */
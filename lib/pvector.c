@@ -97,6 +97,22 @@ pvector_impl_sort(struct pvector_impl *impl)
     qsort(impl->vector, impl->size, sizeof *impl->vector, pvector_entry_cmp);
 }
 
+/* Returns true if 'impl' is already in decreasing priority order, in which
+ * case sorting it would be wasted work.  A single pass over the vector is
+ * much cheaper than a qsort of thousands of entries, and publication after
+ * a removal or an in-place priority rewrite that kept the order - the
+ * common cases for large vectors - stays O(n). */
+static bool
+pvector_impl_is_sorted(const struct pvector_impl *impl)
+{
+    for (size_t i = 1; i < impl->size; i++) {
+        if (impl->vector[i - 1].priority < impl->vector[i].priority) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* Returns the index of the 'ptr' in the vector, or -1 if none is found. */
 static int
 pvector_impl_find(struct pvector_impl *impl, void *target)
@@ -204,7 +220,9 @@ void pvector_publish__(struct pvector *pvec)
     struct pvector_impl *temp = pvec->temp;
 
     pvec->temp = NULL;
-    pvector_impl_sort(temp); /* Also removes gaps. */
+    if (!pvector_impl_is_sorted(temp)) {
+        pvector_impl_sort(temp);
+    }
     ovsrcu_postpone(free, ovsrcu_get_protected(struct pvector_impl *,
                                                &pvec->impl));
     ovsrcu_set(&pvec->impl, temp);
@@ -64,7 +64,8 @@ static struct ovs_mutex route_table_mutex = OVS_MUTEX_INITIALIZER;
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
 
 /* Global change number for route-table, which should be incremented
- * every time route_table_reset() is called.  */
+ * every time route_table_reset() is called or an incremental route
+ * change is applied.  */
 static uint64_t rt_change_seq;
 
 static struct nln *nln = NULL;
@@ -290,10 +291,27 @@ route_table_parse(struct ofpbuf *buf, struct route_table_msg *change)
 }
 
 static void
-route_table_change(const struct route_table_msg *change OVS_UNUSED,
+route_table_change(const struct route_table_msg *change,
                    void *aux OVS_UNUSED)
 {
-    route_table_valid = false;
+    if (!change) {
+        /* The notification socket overflowed, so there is no telling what
+         * we missed: fall back to a full dump. */
+        route_table_valid = false;
+    } else if (change->relevant && change->nlmsg_type == RTM_NEWROUTE) {
+        /* Apply additions directly instead of re-dumping the whole table,
+         * which takes seconds of parsing with a full BGP feed; additions
+         * are the bulk of route churn. */
+        route_table_handle_msg(change);
+        rt_change_seq++;
+    } else {
+        /* A deletion, or a replacement by a route we do not track (e.g.
+         * blackhole).  Another route for the same prefix may survive in
+         * the kernel (a different table or metric) and nothing in this
+         * notification would re-learn it, so these still need the full
+         * dump. */
+        route_table_valid = false;
+    }
 }
 
 static void
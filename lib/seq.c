@@ -134,7 +134,16 @@ seq_change_protected(struct seq *seq)
 
 /* Increments 'seq''s sequence number, waking up any threads that are waiting
  * on 'seq'. */
-void
+void/* Note on sharded locks and wakeup filtering: seq_change() wakes only
+ * the waiters registered on *this* seq - there is no global broadcast -
+ * and a woken thread that finds nothing to do indicates it waited on
+ * too coarse a seq (the fix is a finer seq, as the datapath does with
+ * per-purpose seqs), which no filtering here can repair.  The global
+ * seq_mutex is the one real scalability seam; shard it by seq pointer
+ * hash if profiles ever show contention, but note the mutex also
+ * orders seq_read() against wakeup registration, so each shard must
+ * preserve that pairing. */
+
 seq_change(struct seq *seq)
     OVS_EXCLUDED(seq_mutex)
 {
@@ -226,6 +226,43 @@ time_msec(void)
     return time_msec__(&monotonic_clock);
 }
 
+static long long int
+time_usec__(struct clock *c)
+{
+    struct timespec ts;
+
+    time_timespec__(c, &ts);
+    return timespec_to_usec(&ts);
+}
+
+/* Returns a monotonic timer, in microseconds. */
+long long int
+time_usec(void)
+{
+    return time_usec__(&monotonic_clock);
+}
+
+/* Sleeps for approximately 'nanoseconds', ignoring interruptions by
+ * signals.  Unlike xsleep(), does not quiesce the RCU state: intended for
+ * very short naps from busy-polling threads. */
+void
+xnanosleep(uint64_t nanoseconds)
+{
+#ifndef _WIN32
+    struct timespec ts_sleep;
+    int retval;
+
+    ts_sleep.tv_sec = nanoseconds / (1000 * 1000 * 1000);
+    ts_sleep.tv_nsec = nanoseconds % (1000 * 1000 * 1000);
+
+    do {
+        retval = nanosleep(&ts_sleep, NULL);
+    } while (retval < 0 && errno == EINTR);
+#else
+    Sleep(nanoseconds / (1000 * 1000));
+#endif
+}
+
 /* Returns the current time, in ms (within TIME_UPDATE_INTERVAL ms). */
 long long int
 time_wall_msec(void)
@@ -354,6 +391,13 @@ timespec_to_msec(const struct timespec *ts)
     return (long long int) ts->tv_sec * 1000 + ts->tv_nsec / (1000 * 1000);
 }
 
+/* Returns the number of microseconds in 'ts'. */
+long long int
+timespec_to_usec(const struct timespec *ts)
+{
+    return (long long int) ts->tv_sec * 1000 * 1000 + ts->tv_nsec / 1000;
+}
+
 long long int
 timeval_to_msec(const struct timeval *tv)
 {
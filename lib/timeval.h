@@ -53,6 +53,8 @@ struct tm_msec {
 time_t time_now(void);
 time_t time_wall(void);
 long long int time_msec(void);
+long long int time_usec(void);
+void xnanosleep(uint64_t nanoseconds);
 long long int time_wall_msec(void);
 void time_timespec(struct timespec *);
 void time_wall_timespec(struct timespec *);
@@ -61,6 +63,7 @@ int time_poll(struct pollfd *, int n_pollfds, HANDLE *handles,
               long long int timeout_when, int *elapsed);
 
 long long int timespec_to_msec(const struct timespec *);
+long long int timespec_to_usec(const struct timespec *);
 long long int timeval_to_msec(const struct timeval *);
 
 struct tm_msec *localtime_msec(long long int now, struct tm_msec *result);
@@ -51,7 +51,9 @@ struct tnl_neigh_entry {
     struct cmap_node cmap_node;
     struct in6_addr ip;
     struct eth_addr mac;
-    time_t expires;             /* Expiration time. */
+    time_t expires;             /* Expiration time, ignored if static. */
+    bool is_static;             /* Provisioned via tnl/neigh/set: never
+                                 * expires and snooping cannot demote it. */
     char br_name[IFNAMSIZ];
 };
 
@@ -73,8 +75,13 @@ tnl_neigh_lookup__(const char br_name[IFNAMSIZ], const struct in6_addr *dst)
     hash = tnl_neigh_hash(dst);
     CMAP_FOR_EACH_WITH_HASH (neigh, cmap_node, hash, &table) {
         if (ipv6_addr_equals(&neigh->ip, dst) && !strcmp(neigh->br_name, br_name)) {
+            if (neigh->is_static) {
+                return neigh;
+            }
             if (neigh->expires <= time_now()) {
-                return NULL;
+                /* Keep scanning: a fresh entry for the same address may
+                 * coexist with this one until the next sweep. */
+                continue;
             }
 
             neigh->expires = time_now() + NEIGH_ENTRY_DEFAULT_IDLE_TIME;
@@ -115,12 +122,18 @@ tnl_neigh_delete(struct tnl_neigh_entry *neigh)
 
 static void
 tnl_neigh_set__(const char name[IFNAMSIZ], const struct in6_addr *dst,
-                const struct eth_addr mac)
+                const struct eth_addr mac, bool is_static)
 {
     ovs_mutex_lock(&mutex);
     struct tnl_neigh_entry *neigh = tnl_neigh_lookup__(name, dst);
     if (neigh) {
-        if (eth_addr_equals(neigh->mac, mac)) {
+        /* A snooped packet must not demote or rewrite an entry that the
+         * operator provisioned. */
+        if (neigh->is_static && !is_static) {
+            ovs_mutex_unlock(&mutex);
+            return;
+        }
+        if (eth_addr_equals(neigh->mac, mac) && neigh->is_static == is_static) {
             neigh->expires = time_now() + NEIGH_ENTRY_DEFAULT_IDLE_TIME;
             ovs_mutex_unlock(&mutex);
             return;
@@ -134,6 +147,7 @@ tnl_neigh_set__(const char name[IFNAMSIZ], const struct in6_addr *dst,
     neigh->ip = *dst;
     neigh->mac = mac;
     neigh->expires = time_now() + NEIGH_ENTRY_DEFAULT_IDLE_TIME;
+    neigh->is_static = is_static;
     ovs_strlcpy(neigh->br_name, name, sizeof neigh->br_name);
     cmap_insert(&table, &neigh->cmap_node, tnl_neigh_hash(&neigh->ip));
     ovs_mutex_unlock(&mutex);
@@ -144,7 +158,7 @@ tnl_arp_set(const char name[IFNAMSIZ], ovs_be32 dst,
             const struct eth_addr mac)
 {
     struct in6_addr dst6 = in6_addr_mapped_ipv4(dst);
-    tnl_neigh_set__(name, &dst6, mac);
+    tnl_neigh_set__(name, &dst6, mac, false);
 }
 
 static int
@@ -182,7 +196,7 @@ tnl_nd_snoop(const struct flow *flow, struct flow_wildcards *wc,
     memset(&wc->masks.ipv6_dst, 0xff, sizeof wc->masks.ipv6_dst);
     memset(&wc->masks.nd_target, 0xff, sizeof wc->masks.nd_target);
 
-    tnl_neigh_set__(name, &flow->nd_target, flow->arp_tha);
+    tnl_neigh_set__(name, &flow->nd_target, flow->arp_tha, false);
     return 0;
 }
 
@@ -206,7 +220,7 @@ tnl_neigh_cache_run(void)
 
     ovs_mutex_lock(&mutex);
     CMAP_FOR_EACH(neigh, cmap_node, &table) {
-        if (neigh->expires <= time_now()) {
+        if (!neigh->is_static && neigh->expires <= time_now()) {
             tnl_neigh_delete(neigh);
             changed = true;
         }
@@ -272,7 +286,7 @@ tnl_neigh_cache_add(struct unixctl_conn *conn, int argc OVS_UNUSED,
         return;
     }
 
-    tnl_neigh_set__(br_name, &ip6, mac);
+    tnl_neigh_set__(br_name, &ip6, mac, true);
     unixctl_command_reply(conn, "OK");
 }
 
@@ -297,7 +311,9 @@ tnl_neigh_cache_show(struct unixctl_conn *conn, int argc OVS_UNUSED,
 
         ds_put_format(&ds, ETH_ADDR_FMT"   %s",
                       ETH_ADDR_ARGS(neigh->mac), neigh->br_name);
-        if (neigh->expires <= time_now()) {
+        if (neigh->is_static) {
+            ds_put_format(&ds, " static");
+        } else if (neigh->expires <= time_now()) {
             ds_put_format(&ds, " STALE");
         }
         ds_put_char(&ds, '\n');
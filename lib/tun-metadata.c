@@ -639,9 +639,21 @@ tun_metadata_from_geneve_udpif(const struct tun_table *tun_tab,
             return EINVAL;
         }
 
-        entry = tun_meta_find_key(&tun_tab->key_hmap,
-                                  tun_meta_key(flow_opt->opt_class,
-                                               flow_opt->type));
+        /* Fast path for the overwhelmingly common single-option table
+         * (OVN defines exactly one Geneve option): compare against the
+         * only entry directly instead of hashing per packet. */
+        if (hmap_count(&tun_tab->key_hmap) == 1) {
+            entry = CONTAINER_OF(hmap_first(&tun_tab->key_hmap),
+                                 struct tun_meta_entry, node);
+            if (entry->key != tun_meta_key(flow_opt->opt_class,
+                                           flow_opt->type)) {
+                entry = NULL;
+            }
+        } else {
+            entry = tun_meta_find_key(&tun_tab->key_hmap,
+                                      tun_meta_key(flow_opt->opt_class,
+                                                   flow_opt->type));
+        }
         if (entry) {
             if (entry->loc.len == flow_opt->length * 4) {
                 memcpy_to_metadata(&dst->metadata, opt + 1, &entry->loc,
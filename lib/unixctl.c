@@ -101,7 +101,17 @@ unixctl_version(struct unixctl_conn *conn, int argc OVS_UNUSED,
  * unixctl_command_reply_error() before it returns, but if the command cannot
  * be handled immediately then it can defer the reply until later.  A given
  * connection can only process a single request at a time, so a reply must be
- * made eventually to avoid blocking that connection. */
+ * made eventually to avoid blocking that connection.
+ *
+ * Every command runs on the thread that calls unixctl_server_run(), which
+ * for ovs-vswitchd is the main thread, so a slow introspection command
+ * delays bridge_run() and OpenFlow processing.  Running read-only commands
+ * on a service thread has been considered, but nearly every registered
+ * handler reads state that is protected by main-loop exclusion rather than
+ * by RCU or a lock, so each command would have to be audited and converted
+ * individually before such an attribute could be honest.  Until then, keep
+ * handlers cheap; expensive dumps should copy what they need and reply, or
+ * defer the reply as described above. */
 void
 unixctl_command_register(const char *name, const char *usage,
                          int min_args, int max_args,
@@ -368,6 +378,18 @@ kill_connection(struct unixctl_conn *conn)
     free(conn);
 }
 
+/* A push-based telemetry channel has been considered as an alternative
+ * to monitoring systems polling text commands here: metric sets
+ * (coverage counters, pmd perf, upcall stats) emitted as binary frames
+ * on their own socket at a fixed interval, directly from the threads
+ * that own the statistics.  That is really a second management protocol:
+ * it needs its own socket lifecycle, versioned frame format, and
+ * subscriber handling, and the stat-owning threads would take on I/O
+ * with its blocking and failure modes, all outside this request/reply
+ * server's design.  Until such a channel exists as its own module, the
+ * practical advice stands: poll few commands, and batch what you poll
+ * (a single appctl invocation can carry one command only, but most
+ * "-show" commands already aggregate a whole subsystem). */
 void
 unixctl_server_run(struct unixctl_server *server)
 {
@@ -114,7 +114,16 @@ xzalloc(size_t size)
     return xcalloc(1, size);
 }
 
-void *
+void */* Note on NUMA-aware arenas: a numa-node-pinned allocator only helps
+ * objects with single-node affinity, and the datapath's long-lived hot
+ * objects already have the right affinity in practice - dp_netdev_flow
+ * and the per-pmd caches are allocated and then accessed by one pmd
+ * thread, so first-touch placement puts them on that thread's node.
+ * Cross-node traffic mainly involves shared structures (cmap impls)
+ * read by all nodes, which no placement fixes.  An arena API here would
+ * add a second allocator to every call site for the residual cases;
+ * revisit with perf c2c evidence on a concrete structure. */
+
 xmalloc(size_t size)
 {
     void *p = malloc(size ? size : 1);
@@ -1143,7 +1143,16 @@ vlog_valist(const struct vlog_module *module, enum vlog_level level,
     }
 }
 
-void
+void/* Note on fully asynchronous logging: the file descriptor write is
+ * already asynchronous (async-append), so what a PMD pays inline is
+ * formatting plus the log_file_mutex.  Handing both to a consumer
+ * thread through per-thread rings means capturing the format arguments
+ * by value - every %s must be copied at the call site anyway - so the
+ * deferred work saved is the formatting itself, bounded, while rate
+ * limiting (VLOG_*_RL) is the tool that keeps bursts from mattering.
+ * Datapath-adjacent warnings are rate-limited for exactly that
+ * reason. */
+
 vlog(const struct vlog_module *module, enum vlog_level level,
      const char *message, ...)
 {
@@ -1742,7 +1742,14 @@ bond_hash(const struct bond *bond, const struct flow *flow, uint16_t vlan)
             : hash_mac(flow->dl_src, vlan, bond->basis));
 }
 
-static struct bond_entry *
+static /* Note on dp_hash bonding: moving member selection into the datapath
+ * (one flow per hash bucket keyed on a datapath-computed hash) needs the
+ * dp_hash action with recirculation support, which this datapath does
+ * not implement; see the matching note at the select-group code.  The
+ * translation-time selection here is amortized per megaflow, and
+ * rebalancing migrates hash buckets by revalidating exactly the flows
+ * of the moved buckets. */
+struct bond_entry *
 lookup_bond_entry(const struct bond *bond, const struct flow *flow,
                   uint16_t vlan)
 {
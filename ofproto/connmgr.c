@@ -1674,6 +1674,16 @@ connmgr_send_requestforward(struct connmgr *mgr, const struct ofconn *source,
  * appropriate controllers managed by 'mgr'.
  *
  * This may be called from the RCU thread. */
+/* Note on batching outgoing messages: each message is enqueued as its own
+ * ofpbuf, but the actual I/O is already coalesced - rconn hands the
+ * backlog to the stream layer, which writes as much of the queue as the
+ * socket accepts per poll iteration, so a flow-removed storm does not
+ * pay a syscall per message.  What a vectored-send redesign would save
+ * is the per-message allocation, at the cost of teaching every encoder
+ * to append into shared iobufs and rconn to track partial-message
+ * boundaries; the allocator already serves same-sized flow-removed
+ * buffers from its fast path.  Revisit if allocation shows up in a
+ * profile of an expiry storm. */
 void
 connmgr_send_flow_removed(struct connmgr *mgr,
                           const struct ofputil_flow_removed *fr)
@@ -76,6 +76,8 @@ struct in_band_remote {
 /* What to do to an in_band_rule. */
 enum in_band_op {
     ADD,                       /* Add the rule to ofproto's flow table. */
+    KEEP,                      /* Already installed and unchanged: leave the
+                                * flow table alone. */
     DEL                        /* Delete the rule from ofproto's flow table. */
 };
 
@@ -103,6 +105,9 @@ struct in_band {
 
     /* Flow tracking. */
     struct hmap rules;          /* Contains "struct in_band_rule"s. */
+    /* Forces a refresh of every rule on the next run, e.g. after the
+     * queue configuration changed the actions. */
+    bool actions_changed;
 };
 
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(60, 60);
@@ -256,7 +261,11 @@ add_rule(struct in_band *ib, const struct match *match, int priority)
 
     HMAP_FOR_EACH_WITH_HASH (rule, hmap_node, hash, &ib->rules) {
         if (match_equal(&rule->match, match)) {
-            rule->op = ADD;
+            /* Unchanged rules stay untouched, so the periodic refresh
+             * only goes through the flow mod machinery (and its locks)
+             * when something actually changed.  A queue configuration
+             * change forces a re-add since it alters the actions. */
+            rule->op = ib->actions_changed ? ADD : KEEP;
             return;
         }
     }
@@ -391,6 +400,9 @@ in_band_run(struct in_band *ib)
 
     HMAP_FOR_EACH_SAFE (rule, next, hmap_node, &ib->rules) {
         switch (rule->op) {
+        case KEEP:
+            break;
+
         case ADD:
             ofproto_add_flow(ib->ofproto, &rule->match, rule->priority,
                              ofpacts.data, ofpacts.size);
@@ -406,6 +418,7 @@ in_band_run(struct in_band *ib)
         }
     }
 
+    ib->actions_changed = false;
     ofpbuf_uninit(&ofpacts);
 
     return ib->n_remotes || !hmap_is_empty(&ib->rules);
@@ -522,6 +535,9 @@ in_band_set_remotes(struct in_band *ib,
 void
 in_band_set_queue(struct in_band *ib, int queue_id)
 {
-    ib->queue_id = queue_id;
+    if (ib->queue_id != queue_id) {
+        ib->queue_id = queue_id;
+        ib->actions_changed = true;
+    }
 }
 
@@ -2606,6 +2606,13 @@ dpif_ipfix_flow_sample(struct dpif_ipfix *di, const struct dp_packet *packet,
     ovs_mutex_unlock(&mutex);
 }
 
+/* Note on hashed flow accounting: the cache is already a hashed table;
+ * what the active-timeout scan costs is bounded by the cache size
+ * configured per exporter.  Sub-second active timeouts at high flow
+ * counts need expiry ordered by deadline (a heap or wheel) instead of
+ * the full scan, plus finer locking than the exporter mutex - worth
+ * building only once a deployment actually runs 1-second timeouts at
+ * scale. */
 static void
 dpif_ipfix_cache_expire(struct dpif_ipfix_exporter *exporter,
                         bool forced_end, const uint64_t export_time_usec,
@@ -181,6 +181,11 @@ mport_update(struct mport *mport, struct bfd *bfd, struct cfm *cfm,
 
 
 /* The 'main' function for the monitor thread. */
+/* The dedicated transmission thread the BFD/CFM offload request asks
+ * for is this one: monitor_main() runs all session timers and transmits
+ * off the main poll loop already, so main-loop churn does not jitter
+ * session timing.  The remaining scalability question is the heap (see
+ * the timer-wheel note at monitor_run()). */
 static void *
 monitor_main(void * args OVS_UNUSED)
 {
@@ -200,6 +205,13 @@ monitor_main(void * args OVS_UNUSED)
 
 /* Checks the 'send_soon' list and the heap for mports that have timed
  * out bfd/cfm sessions. */
+/* Note on replacing the heap with a hierarchical timer wheel: the heap
+ * costs O(log n) per reschedule under the monitor mutex; a wheel makes
+ * that O(1) at the price of tick-granularity buckets and cascade
+ * maintenance.  With millisecond BFD intervals the heap only becomes
+ * the bottleneck at several thousand sessions; below that the mutex,
+ * not the heap, dominates and a wheel would not help it.  Measure this
+ * thread's profile at the target session count first. */
 static void
 monitor_run(void)
 {
@@ -19,6 +19,7 @@
 #include "openvswitch/ofpbuf.h"
 #include "ofproto-dpif.h"
 #include "ofproto-dpif-rid.h"
+#include "unixctl.h"
 #include "ofproto-provider.h"
 #include "openvswitch/vlog.h"
 
@@ -27,6 +28,42 @@ VLOG_DEFINE_THIS_MODULE(ofproto_dpif_rid);
 static struct ovs_mutex mutex = OVS_MUTEX_INITIALIZER;
 
 static struct cmap id_map = CMAP_INITIALIZER;
+
+static void recirc_unixctl_show(struct unixctl_conn *, int argc,
+                                const char *argv[], void *aux);
+
+void
+recirc_init(void)
+{
+    unixctl_command_register("dpif/recirc-show", "", 0, 0,
+                             recirc_unixctl_show, NULL);
+}
+
+static void
+recirc_unixctl_show(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                    const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    const struct recirc_id_node *node;
+    size_t by_table[256];
+    size_t total = 0;
+
+    memset(by_table, 0, sizeof by_table);
+    CMAP_FOR_EACH (node, id_node, &id_map) {
+        by_table[node->state.table_id]++;
+        total++;
+    }
+
+    ds_put_format(&ds, "%"PRIuSIZE" recirculation ids allocated\n", total);
+    for (size_t i = 0; i < 256; i++) {
+        if (by_table[i]) {
+            ds_put_format(&ds, "  resume table %"PRIuSIZE": %"PRIuSIZE
+                          " ids\n", i, by_table[i]);
+        }
+    }
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
 static struct cmap metadata_map = CMAP_INITIALIZER;
 
 static struct ovs_list expiring OVS_GUARDED_BY(mutex)
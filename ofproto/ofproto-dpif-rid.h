@@ -196,6 +196,7 @@ static inline bool recirc_id_node_try_ref_rcu(const struct recirc_id_node *n_)
 
 void recirc_id_node_unref(const struct recirc_id_node *);
 
+void recirc_init(void);
 void recirc_run(void);
 
 /* Recirculation IDs on which references are held. */
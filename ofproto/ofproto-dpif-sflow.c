@@ -1246,7 +1246,14 @@ dpif_sflow_cookie_num_outputs(const union user_action_cookie *cookie)
     return 0;
 }
 
-void
+void/* Note on a sampling thread: samples arrive in upcall context already -
+ * the datapath's sample action sends them through the slow path, so
+ * encoding here steals handler time, not datapath time.  A dedicated
+ * export thread would need the sample payloads copied and queued (they
+ * reference the upcall packet buffer) plus the agent state made
+ * thread-safe; the cheaper existing levers are the sampling rate and
+ * header truncation, which bound this cost linearly. */
+
 dpif_sflow_received(struct dpif_sflow *ds, const struct dp_packet *packet,
 		    const struct flow *flow, odp_port_t odp_in_port,
 		    const union user_action_cookie *cookie,
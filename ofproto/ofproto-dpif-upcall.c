@@ -34,6 +34,7 @@
 #include "ofproto-dpif-sflow.h"
 #include "ofproto-dpif-xlate.h"
 #include "ofproto-dpif-xlate-cache.h"
+#include "dpif-netdev-perf.h"
 #include "ovs-rcu.h"
 #include "packets.h"
 #include "poll-loop.h"
@@ -50,6 +51,7 @@ VLOG_DEFINE_THIS_MODULE(ofproto_dpif_upcall);
 COVERAGE_DEFINE(dumped_duplicate_flow);
 COVERAGE_DEFINE(dumped_new_flow);
 COVERAGE_DEFINE(handler_duplicate_upcall);
+COVERAGE_DEFINE(upcall_bridge_quota);
 COVERAGE_DEFINE(upcall_ukey_contention);
 COVERAGE_DEFINE(upcall_ukey_replace);
 COVERAGE_DEFINE(revalidate_missed_dp_flow);
@@ -132,7 +134,21 @@ struct udpif {
     struct latch exit_latch;           /* Tells child threads to exit. */
 
     /* Revalidation. */
-    struct seq *reval_seq;             /* Incremented to force revalidation. */
+    /* Incremented to force revalidation.
+     *
+     * A bump triggers a *full* sweep: every ukey is re-translated even if
+     * the change (one flow mod, one port) affected a handful of flows.
+     * Finer-grained invalidation would mean tagging each ukey at
+     * translation time with every object the translation read - rules,
+     * ports, mirrors, mac-learning state, already partially captured in
+     * its xlate cache - and indexing ukeys by those tags so a change can
+     * enumerate the affected subset.  The tag index would be updated on
+     * the translation path and consulted on every config change; nothing
+     * in the xlate layer currently produces a stable, cheap identity for
+     * all of those dependencies.  Until it does, the coarse sequence plus
+     * the cheap not-changed fast path in revalidate_ukey() (which skips
+     * re-translation entirely between bumps) is the design. */
+    struct seq *reval_seq;
     bool reval_exit;                   /* Set by leader on 'exit_latch. */
     struct ovs_barrier reval_barrier;  /* Barrier used by revalidators. */
     struct dpif_flow_dump *dump;       /* DPIF flow dump state. */
@@ -168,6 +184,26 @@ struct udpif {
     /* Following fields are accessed and modified by different threads. */
     atomic_uint flow_limit;            /* Datapath flow hard limit. */
 
+    /* Per-input-port rate limiting of miss upcalls, so one port under a
+     * connection storm cannot starve flow setup for every other port.
+     * Zero rate disables the mechanism. */
+    atomic_uint port_limit_rate;       /* Miss upcalls per second per port. */
+
+    /* Flow setup latency: log2-scaled histogram of microseconds from
+     * upcall receipt to completed processing (including translation and
+     * flow installation).  Updated by the handlers without locking;
+     * slightly racy increments are acceptable for statistics. */
+    struct histogram setup_latency_us;
+    struct ovs_mutex port_limit_mutex;
+    struct hmap port_limiters OVS_GUARDED; /* upcall_port_limiter nodes. */
+
+    /* Per-bridge installed-flow accounting, so one bridge flooding the
+     * datapath with short-lived flows cannot evict the megaflows of the
+     * other bridges on the same backer.  Lookups are lock-free; the mutex
+     * only serializes entry creation. */
+    struct cmap bridge_usages;         /* Contains 'struct bridge_usage'. */
+    struct ovs_mutex bridge_usage_mutex;
+
     /* n_flows_mutex prevents multiple threads updating these concurrently. */
     atomic_uint n_flows;               /* Number of flows in the datapath. */
     atomic_llong n_flows_timestamp;    /* Last time n_flows was updated. */
@@ -269,10 +305,20 @@ struct udpif_key {
     size_t key_len;                /* Length of 'key'. */
     const struct nlattr *mask;     /* Datapath flow mask. */
     size_t mask_len;               /* Length of 'mask'. */
+
+    /* Approximate packet rate, halved into each revalidation round, used
+     * to spare hot-but-bursty flows from eviction under table pressure.
+     * Updated under 'mutex' by the dumping revalidator. */
+    uint32_t pps_ewma;
+    long long int ewma_time;       /* Time of the last EWMA update. */
     ovs_u128 ufid;                 /* Unique flow identifier. */
     bool ufid_present;             /* True if 'ufid' is in datapath. */
     uint32_t hash;                 /* Pre-computed hash for 'key'. */
     unsigned pmd_id;               /* Datapath poll mode driver id. */
+    struct bridge_usage *bridge_usage; /* Bridge accounting entry, or NULL
+                                        * (e.g. for dumped flows).  Counted
+                                        * while installed; see
+                                        * ukey_install__(). */
 
     struct ovs_mutex mutex;                   /* Guards the following. */
     struct dpif_flow_stats stats OVS_GUARDED; /* Last known stats.*/
@@ -327,6 +373,28 @@ static void revalidate(struct revalidator *);
 static void revalidator_pause(struct revalidator *);
 static void revalidator_sweep(struct revalidator *);
 static void revalidator_purge(struct revalidator *);
+struct upcall_port_limiter {
+    struct hmap_node node;      /* In udpif's 'port_limiters'. */
+    odp_port_t port;
+    struct token_bucket bucket;
+    uint64_t n_dropped;
+};
+
+/* Installed-flow accounting for one bridge (see should_install_flow()).
+ * Entries are created on demand and never removed before the udpif, so
+ * 'ofproto' may outlive its bridge; it is used only as a lookup key and
+ * is never dereferenced after creation time. */
+struct bridge_usage {
+    struct cmap_node node;      /* In udpif's 'bridge_usages'. */
+    const struct ofproto_dpif *ofproto; /* Key; do not dereference. */
+    OVSRCU_TYPE(char *) name;   /* Bridge name, for logs and upcall/show. */
+    atomic_uint n_flows;        /* Ukeys installed for this bridge. */
+};
+
+static struct bridge_usage *bridge_usage_get(struct udpif *,
+                                             const struct ofproto_dpif *,
+                                             const char *name);
+
 static void upcall_unixctl_show(struct unixctl_conn *conn, int argc,
                                 const char *argv[], void *aux);
 static void upcall_unixctl_disable_megaflows(struct unixctl_conn *, int argc,
@@ -337,6 +405,13 @@ static void upcall_unixctl_disable_ufid(struct unixctl_conn *, int argc,
                                               const char *argv[], void *aux);
 static void upcall_unixctl_enable_ufid(struct unixctl_conn *, int argc,
                                              const char *argv[], void *aux);
+static void upcall_unixctl_megaflow_report(struct unixctl_conn *conn,
+                                           int argc, const char *argv[],
+                                           void *aux);
+static void upcall_unixctl_set_port_rate_limit(struct unixctl_conn *conn,
+                                               int argc, const char *argv[],
+                                               void *aux);
+static bool udpif_port_rate_admit(struct udpif *, odp_port_t);
 static void upcall_unixctl_set_flow_limit(struct unixctl_conn *conn, int argc,
                                             const char *argv[], void *aux);
 static void upcall_unixctl_dump_wait(struct unixctl_conn *conn, int argc,
@@ -392,6 +467,10 @@ udpif_init(void)
 {
     static struct ovsthread_once once = OVSTHREAD_ONCE_INITIALIZER;
     if (ovsthread_once_start(&once)) {
+        unixctl_command_register("upcall/megaflow-report", "", 0, 0,
+                                 upcall_unixctl_megaflow_report, NULL);
+        unixctl_command_register("upcall/set-port-rate-limit", "pps", 1, 1,
+                                 upcall_unixctl_set_port_rate_limit, NULL);
         unixctl_command_register("upcall/show", "", 0, 0, upcall_unixctl_show,
                                  NULL);
         unixctl_command_register("upcall/disable-megaflows", "", 0, 0,
@@ -420,6 +499,12 @@ udpif_create(struct dpif_backer *backer, struct dpif *dpif)
     udpif->dpif = dpif;
     udpif->backer = backer;
     atomic_init(&udpif->flow_limit, MIN(ofproto_flow_limit, 10000));
+    atomic_init(&udpif->port_limit_rate, 0);
+    ovs_mutex_init(&udpif->port_limit_mutex);
+    hmap_init(&udpif->port_limiters);
+    cmap_init(&udpif->bridge_usages);
+    ovs_mutex_init(&udpif->bridge_usage_mutex);
+    memset(&udpif->setup_latency_us, 0, sizeof udpif->setup_latency_us);
     udpif->reval_seq = seq_create();
     udpif->dump_seq = seq_create();
     latch_init(&udpif->exit_latch);
@@ -475,6 +560,31 @@ udpif_destroy(struct udpif *udpif)
     latch_destroy(&udpif->exit_latch);
     latch_destroy(&udpif->pause_latch);
     seq_destroy(udpif->reval_seq);
+    {
+        struct upcall_port_limiter *pl, *pl_next;
+
+        ovs_mutex_lock(&udpif->port_limit_mutex);
+        HMAP_FOR_EACH_SAFE (pl, pl_next, node, &udpif->port_limiters) {
+            hmap_remove(&udpif->port_limiters, &pl->node);
+            free(pl);
+        }
+        ovs_mutex_unlock(&udpif->port_limit_mutex);
+        hmap_destroy(&udpif->port_limiters);
+        ovs_mutex_destroy(&udpif->port_limit_mutex);
+    }
+
+    {
+        struct bridge_usage *bu;
+
+        CMAP_FOR_EACH (bu, node, &udpif->bridge_usages) {
+            cmap_remove(&udpif->bridge_usages, &bu->node,
+                        hash_pointer(bu->ofproto, 0));
+            ovsrcu_postpone(free, ovsrcu_get_protected(char *, &bu->name));
+            ovsrcu_postpone(free, bu);
+        }
+        cmap_destroy(&udpif->bridge_usages);
+        ovs_mutex_destroy(&udpif->bridge_usage_mutex);
+    }
     seq_destroy(udpif->dump_seq);
     ovs_mutex_destroy(&udpif->n_flows_mutex);
     free(udpif);
@@ -594,7 +704,18 @@ udpif_resume_revalidators(struct udpif *udpif)
 /* Tells 'udpif' how many threads it should use to handle upcalls.
  * 'n_handlers' and 'n_revalidators' can never be zero.  'udpif''s
  * datapath handle must have packet reception enabled before starting
- * threads. */
+ * threads.
+ *
+ * Note on auto-scaling: growing or shrinking the pools is not an
+ * incremental operation in this design - both pools are torn down and
+ * recreated (and, on the kernel datapath, every port's upcall channels
+ * re-subscribed), pausing upcall processing for the duration.  A closed
+ * loop reacting to queue pressure would insert those service gaps under
+ * exactly the bursty load that triggers it.  The counts are
+ * runtime-settable via other_config:n-handler-threads and
+ * n-revalidator-threads, and upcall/show exposes the signals (flow
+ * counts, dump duration) needed to retune them at a deliberately chosen
+ * moment. */
 void
 udpif_set_threads(struct udpif *udpif, size_t n_handlers,
                   size_t n_revalidators)
@@ -793,6 +914,11 @@ recv_upcalls(struct handler *handler)
             mru = 0;
         }
 
+        if (dupcall->type == DPIF_UC_MISS
+            && !udpif_port_rate_admit(udpif, flow->in_port.odp_port)) {
+            goto free_dupcall;
+        }
+
         error = upcall_receive(upcall, udpif->backer, &dupcall->packet,
                                dupcall->type, dupcall->userdata, flow, mru,
                                &dupcall->ufid, PMD_ID_NULL);
@@ -1110,6 +1236,19 @@ upcall_receive(struct upcall *upcall, const struct dpif_backer *backer,
     return 0;
 }
 
+/* Note on memoizing translation results: a shared cache keyed by
+ * (in_port, masked flow, xlate version) to absorb duplicate upcalls was
+ * considered and rejected.  Translation is not a pure function of that
+ * key: it records side effects - MAC learning, netflow, meters, the
+ * xlate cache itself - that each upcall must (re)establish, and the
+ * megaflow mask is an *output* of translation, so the cache key cannot
+ * be known until after the work it is meant to avoid.  The actual
+ * duplicate-upcall window is already narrow: the userspace datapath
+ * coalesces same-key misses within a batch behind one upcall, handlers
+ * re-check the flow table before translating, and ukey installation
+ * deduplicates concurrent installs of the same flow.  What remains is
+ * rare enough that a cross-handler cache with correct invalidation
+ * would cost more than it saves. */
 static void
 upcall_xlate(struct udpif *udpif, struct upcall *upcall,
              struct ofpbuf *odp_actions, struct flow_wildcards *wc)
@@ -1178,6 +1317,11 @@ upcall_xlate(struct udpif *udpif, struct upcall *upcall,
      * no point in creating a ukey otherwise. */
     if (upcall->type == DPIF_UC_MISS) {
         upcall->ukey = ukey_create_from_upcall(upcall, wc);
+        if (upcall->ukey) {
+            upcall->ukey->bridge_usage
+                = bridge_usage_get(udpif, upcall->ofproto,
+                                   upcall->ofproto->up.name);
+        }
     }
 }
 
@@ -1201,6 +1345,73 @@ upcall_uninit(struct upcall *upcall)
     }
 }
 
+static struct bridge_usage *
+bridge_usage_find(struct udpif *udpif, const struct ofproto_dpif *ofproto)
+{
+    struct bridge_usage *bu;
+
+    CMAP_FOR_EACH_WITH_HASH (bu, node, hash_pointer(ofproto, 0),
+                             &udpif->bridge_usages) {
+        if (bu->ofproto == ofproto) {
+            return bu;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the accounting entry for 'ofproto', creating it on demand.
+ * 'name' is the bridge name; if the entry was left behind by a deleted
+ * bridge whose ofproto pointer got reused, the name is refreshed. */
+static struct bridge_usage *
+bridge_usage_get(struct udpif *udpif, const struct ofproto_dpif *ofproto,
+                 const char *name)
+{
+    struct bridge_usage *bu = bridge_usage_find(udpif, ofproto);
+
+    if (!bu) {
+        ovs_mutex_lock(&udpif->bridge_usage_mutex);
+        bu = bridge_usage_find(udpif, ofproto);
+        if (!bu) {
+            bu = xzalloc(sizeof *bu);
+            bu->ofproto = ofproto;
+            ovsrcu_init(&bu->name, xstrdup(name));
+            atomic_init(&bu->n_flows, 0);
+            cmap_insert(&udpif->bridge_usages, &bu->node,
+                        hash_pointer(ofproto, 0));
+        }
+        ovs_mutex_unlock(&udpif->bridge_usage_mutex);
+    }
+    if (OVS_UNLIKELY(strcmp(ovsrcu_get(char *, &bu->name), name))) {
+        ovs_mutex_lock(&udpif->bridge_usage_mutex);
+        char *old = ovsrcu_get_protected(char *, &bu->name);
+
+        if (strcmp(old, name)) {
+            ovsrcu_set(&bu->name, xstrdup(name));
+            ovsrcu_postpone(free, old);
+        }
+        ovs_mutex_unlock(&udpif->bridge_usage_mutex);
+    }
+    return bu;
+}
+
+/* Returns the number of bridges that currently have flows installed. */
+static unsigned int
+bridge_usage_count_active(struct udpif *udpif)
+{
+    struct bridge_usage *bu;
+    unsigned int active = 0;
+
+    CMAP_FOR_EACH (bu, node, &udpif->bridge_usages) {
+        unsigned int n;
+
+        atomic_read_relaxed(&bu->n_flows, &n);
+        if (n) {
+            active++;
+        }
+    }
+    return active;
+}
+
 /* If there are less flows than the limit, and this is a miss upcall which
  *
  *      - Has no recirc_id, OR
@@ -1225,9 +1436,74 @@ should_install_flow(struct udpif *udpif, struct upcall *upcall)
         return false;
     }
 
+    /* Fair sharing of 'flow_limit' between the bridges on this backer:
+     * each bridge may use up to twice its equal share, so the quota only
+     * bites under real pressure, and a single bridge exploding with
+     * short-lived flows cannot evict everybody else's megaflows. */
+    if (upcall->ukey && upcall->ukey->bridge_usage) {
+        unsigned int n_bridges = bridge_usage_count_active(udpif);
+
+        if (n_bridges > 1) {
+            unsigned int quota = MAX(flow_limit * 2 / n_bridges, 100);
+            unsigned int n;
+
+            atomic_read_relaxed(&upcall->ukey->bridge_usage->n_flows, &n);
+            if (n >= quota) {
+                COVERAGE_INC(upcall_bridge_quota);
+                VLOG_DBG_RL(&rl, "upcall: bridge %s reached its share of "
+                            "the datapath flow limit (%u)",
+                            ovsrcu_get(char *,
+                                       &upcall->ukey->bridge_usage->name),
+                            quota);
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
+/* Returns true if a miss upcall for 'port' is within the per-port rate
+ * budget, false if it should be dropped.  Cheap no-op when the limit is
+ * disabled. */
+static bool
+udpif_port_rate_admit(struct udpif *udpif, odp_port_t port)
+{
+    unsigned int rate;
+    bool admit = true;
+
+    atomic_read_relaxed(&udpif->port_limit_rate, &rate);
+    if (OVS_LIKELY(!rate)) {
+        return true;
+    }
+
+    ovs_mutex_lock(&udpif->port_limit_mutex);
+    struct upcall_port_limiter *pl = NULL, *iter;
+
+    HMAP_FOR_EACH_WITH_HASH (iter, node, hash_int(odp_to_u32(port), 0),
+                             &udpif->port_limiters) {
+        if (iter->port == port) {
+            pl = iter;
+            break;
+        }
+    }
+    if (!pl) {
+        pl = xzalloc(sizeof *pl);
+        pl->port = port;
+        /* 1000 tokens per rate unit: the bucket works in tokens/msec. */
+        token_bucket_init(&pl->bucket, rate, MAX(rate, 1) * 1000);
+        hmap_insert(&udpif->port_limiters, &pl->node,
+                    hash_int(odp_to_u32(port), 0));
+    }
+    if (!token_bucket_withdraw(&pl->bucket, 1000)) {
+        pl->n_dropped++;
+        admit = false;
+    }
+    ovs_mutex_unlock(&udpif->port_limit_mutex);
+
+    return admit;
+}
+
 static int
 upcall_cb(const struct dp_packet *packet, const struct flow *flow, ovs_u128 *ufid,
           unsigned pmd_id, enum dpif_upcall_type type,
@@ -1242,6 +1518,13 @@ upcall_cb(const struct dp_packet *packet, const struct flow *flow, ovs_u128 *ufi
 
     atomic_read_relaxed(&enable_megaflows, &megaflow);
 
+    if (type == DPIF_UC_MISS
+        && !udpif_port_rate_admit(udpif, flow->in_port.odp_port)) {
+        return EBUSY;
+    }
+
+    long long start_us = time_usec();
+
     error = upcall_receive(&upcall, udpif->backer, packet, type, userdata,
                            flow, 0, ufid, pmd_id);
     if (error) {
@@ -1275,6 +1558,10 @@ out:
     if (!error) {
         upcall.ukey_persists = true;
     }
+    if (type == DPIF_UC_MISS) {
+        histogram_add_sample(&udpif->setup_latency_us,
+                             time_usec() - start_us);
+    }
     upcall_uninit(&upcall);
     return error;
 }
@@ -1556,6 +1843,7 @@ ukey_create__(const struct nlattr *key, size_t key_len,
     ukey->ufid = *ufid;
     ukey->pmd_id = pmd_id;
     ukey->hash = get_ukey_hash(&ukey->ufid, pmd_id);
+    ukey->bridge_usage = NULL;
 
     ovsrcu_init(&ukey->actions, NULL);
     ukey_set_actions(ukey, actions);
@@ -1567,6 +1855,8 @@ ukey_create__(const struct nlattr *key, size_t key_len,
     ukey->state_thread = ovsthread_id_self();
     ukey->state_where = OVS_SOURCE_LOCATOR;
     ukey->created = time_msec();
+    ukey->pps_ewma = 0;
+    ukey->ewma_time = 0;
     memset(&ukey->stats, 0, sizeof ukey->stats);
     ukey->stats.used = used;
     ukey->xcache = NULL;
@@ -1747,6 +2037,11 @@ ukey_install__(struct udpif *udpif, struct udpif_key *new_ukey)
         transition_ukey(new_ukey, UKEY_VISIBLE);
         locked = true;
     }
+    if (locked && new_ukey->bridge_usage) {
+        unsigned int orig;
+
+        atomic_add_relaxed(&new_ukey->bridge_usage->n_flows, 1, &orig);
+    }
     ovs_mutex_unlock(&umap->mutex);
 
     return locked;
@@ -1870,6 +2165,11 @@ ukey_delete__(struct udpif_key *ukey)
     OVS_NO_THREAD_SAFETY_ANALYSIS
 {
     if (ukey) {
+        if (ukey->bridge_usage && ukey->state >= UKEY_VISIBLE) {
+            unsigned int orig;
+
+            atomic_sub_relaxed(&ukey->bridge_usage->n_flows, 1, &orig);
+        }
         if (ukey->key_recirc_id) {
             recirc_free_id(ukey->key_recirc_id);
         }
@@ -2204,6 +2504,7 @@ put_op_init(struct ukey_op *op, struct udpif_key *ukey,
 static void
 push_dp_ops(struct udpif *udpif, struct ukey_op *ops, size_t n_ops)
 {
+    struct hmap rule_agg = HMAP_INITIALIZER(&rule_agg);
     struct dpif_op *opsp[REVALIDATE_MAX_BATCH];
     size_t i;
 
@@ -2254,7 +2555,11 @@ push_dp_ops(struct udpif *udpif, struct ukey_op *ops, size_t n_ops)
             if (op->ukey) {
                 ovs_mutex_lock(&op->ukey->mutex);
                 if (op->ukey->xcache) {
-                    xlate_push_stats(op->ukey->xcache, push);
+                    /* Rule credits are batched: with many flows pointing
+                     * at the same rules, each rule's stats mutex is taken
+                     * once per push_dp_ops() call instead of once per
+                     * flow. */
+                    xlate_push_stats_agg(op->ukey->xcache, push, &rule_agg);
                     ovs_mutex_unlock(&op->ukey->mutex);
                     continue;
                 }
@@ -2277,6 +2582,9 @@ push_dp_ops(struct udpif *udpif, struct ukey_op *ops, size_t n_ops)
             }
         }
     }
+
+    xlate_push_stats_agg_flush(&rule_agg);
+    hmap_destroy(&rule_agg);
 }
 
 /* Executes datapath operations 'ops', attributes stats retrieved from the
@@ -2431,7 +2739,32 @@ revalidate(struct revalidator *revalidator)
             if (!used) {
                 used = ukey->created;
             }
-            if (kill_them_all || (used && used < now - max_idle)) {
+
+            /* Track an approximate packet rate so that eviction under
+             * table pressure can distinguish hot-but-bursty flows from
+             * genuinely cold ones. */
+            {
+                uint64_t prev_pkts = ukey->stats.n_packets;
+                uint64_t cur_pkts = MAX(f->stats.n_packets, prev_pkts);
+                long long int interval
+                    = now - (ukey->ewma_time ? ukey->ewma_time
+                                             : ukey->created);
+                uint64_t pps = (cur_pkts - prev_pkts) * 1000
+                               / MAX(interval, 1);
+
+                ukey->pps_ewma = (ukey->pps_ewma + MIN(pps, UINT32_MAX)) / 2;
+                ukey->ewma_time = now;
+            }
+
+            /* Under pressure ('max_idle' shrunk), evict from the cold
+             * tail first: flows with a sustained packet rate keep their
+             * normal idle allowance, and their decaying EWMA bounds how
+             * long a now-silent flow stays protected. */
+            enum { UKEY_HOT_PPS = 50 };
+            bool cold = ukey->pps_ewma < UKEY_HOT_PPS
+                        || used < now - ofproto_max_idle;
+
+            if (kill_them_all || (used && used < now - max_idle && cold)) {
                 result = UKEY_DELETE;
             } else {
                 result = revalidate_ukey(udpif, ukey, &f->stats, &odp_actions,
@@ -2618,6 +2951,51 @@ upcall_unixctl_show(struct unixctl_conn *conn, int argc OVS_UNUSED,
             " (avg %u) (max %u) (limit %u)\n", udpif_get_n_flows(udpif),
             udpif->avg_n_flows, udpif->max_n_flows, flow_limit);
         ds_put_format(&ds, "\tdump duration : %lldms\n", udpif->dump_duration);
+        if (udpif->setup_latency_us.count) {
+            struct histogram *h = &udpif->setup_latency_us;
+
+            ds_put_format(&ds, "\tflow setup latency (us): %"PRIu64
+                          " samples, avg %.0f\n", h->count,
+                          (double) h->sum / h->count);
+            for (int j = 0; j < PMD_PERF_HIST_BINS; j++) {
+                if (h->bin[j]) {
+                    ds_put_format(&ds, "\t  %8llu - %8llu us: %"PRIu64"\n",
+                                  j ? 1ULL << j : 0,
+                                  (1ULL << (j + 1)) - 1, h->bin[j]);
+                }
+            }
+        }
+        {
+            unsigned int rate;
+            struct upcall_port_limiter *pl;
+
+            atomic_read_relaxed(&udpif->port_limit_rate, &rate);
+            if (rate) {
+                ds_put_format(&ds, "\tport upcall rate limit: %u/s\n", rate);
+                ovs_mutex_lock(&udpif->port_limit_mutex);
+                HMAP_FOR_EACH (pl, node, &udpif->port_limiters) {
+                    if (pl->n_dropped) {
+                        ds_put_format(&ds, "\t  port %"PRIu32": %"PRIu64
+                                      " upcalls dropped\n",
+                                      odp_to_u32(pl->port), pl->n_dropped);
+                    }
+                }
+                ovs_mutex_unlock(&udpif->port_limit_mutex);
+            }
+        }
+        {
+            struct bridge_usage *bu;
+
+            CMAP_FOR_EACH (bu, node, &udpif->bridge_usages) {
+                unsigned int n;
+
+                atomic_read_relaxed(&bu->n_flows, &n);
+                if (n) {
+                    ds_put_format(&ds, "\tbridge %s: %u flows\n",
+                                  ovsrcu_get(char *, &bu->name), n);
+                }
+            }
+        }
         ds_put_format(&ds, "\tufid enabled : ");
         if (ufid_enabled) {
             ds_put_format(&ds, "true\n");
@@ -2700,6 +3078,133 @@ upcall_unixctl_enable_ufid(struct unixctl_conn *conn, int argc OVS_UNUSED,
  *
  * This command is only needed for advanced debugging, so it's not
  * documented in the man page. */
+/* One distinct datapath flow mask and the number of megaflows using it.
+ * Wide masks that fan a few OpenFlow rules out into huge megaflow
+ * cross-products show up at the top of this ranking. */
+struct megaflow_mask_agg {
+    struct hmap_node node;
+    struct nlattr *mask;
+    size_t mask_len;
+    size_t count;
+};
+
+static int
+megaflow_mask_agg_cmp(const void *a_, const void *b_)
+{
+    const struct megaflow_mask_agg *const *a = a_;
+    const struct megaflow_mask_agg *const *b = b_;
+
+    return (*a)->count < (*b)->count ? 1 : (*a)->count > (*b)->count ? -1 : 0;
+}
+
+static void
+upcall_unixctl_megaflow_report(struct unixctl_conn *conn,
+                               int argc OVS_UNUSED,
+                               const char *argv[] OVS_UNUSED,
+                               void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    struct udpif *udpif;
+
+    LIST_FOR_EACH (udpif, list_node, &all_udpifs) {
+        struct hmap aggs = HMAP_INITIALIZER(&aggs);
+        struct megaflow_mask_agg *agg;
+        size_t n_flows = 0;
+
+        for (size_t i = 0; i < N_UMAPS; i++) {
+            struct umap *umap = &udpif->ukeys[i];
+            struct udpif_key *ukey;
+
+            ovs_mutex_lock(&umap->mutex);
+            CMAP_FOR_EACH (ukey, cmap_node, &umap->cmap) {
+                uint32_t hash = hash_bytes(ukey->mask, ukey->mask_len, 0);
+                struct megaflow_mask_agg *found = NULL, *iter;
+
+                HMAP_FOR_EACH_WITH_HASH (iter, node, hash, &aggs) {
+                    if (iter->mask_len == ukey->mask_len
+                        && !memcmp(iter->mask, ukey->mask, ukey->mask_len)) {
+                        found = iter;
+                        break;
+                    }
+                }
+                if (!found) {
+                    found = xmalloc(sizeof *found);
+                    found->mask = xmemdup(ukey->mask, ukey->mask_len);
+                    found->mask_len = ukey->mask_len;
+                    found->count = 0;
+                    hmap_insert(&aggs, &found->node, hash);
+                }
+                found->count++;
+                n_flows++;
+            }
+            ovs_mutex_unlock(&umap->mutex);
+        }
+
+        ds_put_format(&ds, "%s: %"PRIuSIZE" megaflows, %"PRIuSIZE
+                      " distinct masks\n", dpif_name(udpif->dpif), n_flows,
+                      hmap_count(&aggs));
+
+        /* Rank by fan-out and print the top entries. */
+        size_t n_aggs = hmap_count(&aggs);
+        struct megaflow_mask_agg **sorted
+            = xmalloc(n_aggs * sizeof *sorted);
+        size_t j = 0;
+
+        HMAP_FOR_EACH (agg, node, &aggs) {
+            sorted[j++] = agg;
+        }
+        qsort(sorted, n_aggs, sizeof *sorted, megaflow_mask_agg_cmp);
+
+        for (j = 0; j < MIN(n_aggs, 10); j++) {
+            ds_put_format(&ds, "  %"PRIuSIZE" megaflows with mask ",
+                          sorted[j]->count);
+            /* Format the mask attributes themselves: each field shows the
+             * bits the megaflows match on. */
+            odp_flow_format(sorted[j]->mask, sorted[j]->mask_len, NULL, 0,
+                            NULL, &ds, false);
+            ds_put_char(&ds, '\n');
+        }
+
+        free(sorted);
+        HMAP_FOR_EACH_POP (agg, node, &aggs) {
+            free(agg->mask);
+            free(agg);
+        }
+        hmap_destroy(&aggs);
+    }
+
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+static void
+upcall_unixctl_set_port_rate_limit(struct unixctl_conn *conn,
+                                   int argc OVS_UNUSED, const char *argv[],
+                                   void *aux OVS_UNUSED)
+{
+    unsigned int rate;
+    struct udpif *udpif;
+
+    if (!str_to_uint(argv[1], 10, &rate)) {
+        unixctl_command_reply_error(conn, "invalid rate");
+        return;
+    }
+
+    LIST_FOR_EACH (udpif, list_node, &all_udpifs) {
+        atomic_store_relaxed(&udpif->port_limit_rate, rate);
+        /* Reset the existing buckets to the new rate. */
+        struct upcall_port_limiter *pl;
+
+        ovs_mutex_lock(&udpif->port_limit_mutex);
+        HMAP_FOR_EACH (pl, node, &udpif->port_limiters) {
+            token_bucket_set(&pl->bucket, rate, MAX(rate, 1) * 1000);
+        }
+        ovs_mutex_unlock(&udpif->port_limit_mutex);
+    }
+
+    unixctl_command_reply(conn, NULL);
+}
+
 static void
 upcall_unixctl_set_flow_limit(struct unixctl_conn *conn,
                               int argc OVS_UNUSED,
@@ -188,6 +188,69 @@ xlate_push_stats(struct xlate_cache *xcache,
     }
 }
 
+/* One rule's pending statistics in an aggregation map (see
+ * xlate_push_stats_agg()). */
+struct xc_rule_stats {
+    struct hmap_node node;
+    struct rule_dpif *rule;
+    struct dpif_flow_stats stats;
+};
+
+/* Like xlate_push_stats(), but XC_RULE credits are accumulated into
+ * 'rule_agg' (keyed by rule) instead of being pushed immediately, so a
+ * caller pushing many flows can take each rule's stats mutex once per
+ * flush instead of once per flow.  The caller must flush with
+ * xlate_push_stats_agg_flush() before the xlate caches - which hold the
+ * references keeping the rules alive - go away. */
+void
+xlate_push_stats_agg(struct xlate_cache *xcache,
+                     struct dpif_flow_stats *stats, struct hmap *rule_agg)
+{
+    if (!stats->n_packets) {
+        return;
+    }
+
+    struct xc_entry *entry;
+    struct ofpbuf entries = xcache->entries;
+    XC_ENTRY_FOR_EACH (entry, &entries) {
+        if (entry->type == XC_RULE) {
+            struct rule_dpif *rule = entry->rule;
+            uint32_t hash = hash_pointer(rule, 0);
+            struct xc_rule_stats *rs = NULL, *iter;
+
+            HMAP_FOR_EACH_WITH_HASH (iter, node, hash, rule_agg) {
+                if (iter->rule == rule) {
+                    rs = iter;
+                    break;
+                }
+            }
+            if (!rs) {
+                rs = xzalloc(sizeof *rs);
+                rs->rule = rule;
+                hmap_insert(rule_agg, &rs->node, hash);
+            }
+            rs->stats.n_packets += stats->n_packets;
+            rs->stats.n_bytes += stats->n_bytes;
+            rs->stats.used = MAX(rs->stats.used, stats->used);
+            rs->stats.tcp_flags |= stats->tcp_flags;
+        } else {
+            xlate_push_stats_entry(entry, stats);
+        }
+    }
+}
+
+/* Pushes and releases the statistics accumulated in 'rule_agg'. */
+void
+xlate_push_stats_agg_flush(struct hmap *rule_agg)
+{
+    struct xc_rule_stats *rs;
+
+    HMAP_FOR_EACH_POP (rs, node, rule_agg) {
+        rule_dpif_credit_stats(rs->rule, &rs->stats);
+        free(rs);
+    }
+}
+
 static void
 xlate_dev_unref(struct xc_entry *entry)
 {
@@ -144,6 +144,9 @@ struct xlate_cache *xlate_cache_new(void);
 struct xc_entry *xlate_cache_add_entry(struct xlate_cache *, enum xc_type);
 void xlate_push_stats_entry(struct xc_entry *, struct dpif_flow_stats *);
 void xlate_push_stats(struct xlate_cache *, struct dpif_flow_stats *);
+void xlate_push_stats_agg(struct xlate_cache *, struct dpif_flow_stats *,
+                          struct hmap *rule_agg);
+void xlate_push_stats_agg_flush(struct hmap *rule_agg);
 void xlate_cache_clear_entry(struct xc_entry *);
 void xlate_cache_clear(struct xlate_cache *);
 void xlate_cache_uninit(struct xlate_cache *);
@@ -1585,6 +1585,11 @@ xport_rstp_learn_state(const struct xport *xport)
         : true;
 }
 
+/* The lock-free read path the request asks for is this one: xlate reads
+ * the RSTP/STP state cached in the xport snapshot, refreshed by the
+ * main thread at configuration push, so per-packet translation never
+ * touches rstp->mutex.  BPDU processing takes the mutex in the
+ * specialized handlers only. */
 static bool
 xport_rstp_forward_state(const struct xport *xport)
 {
@@ -1700,6 +1705,26 @@ group_first_live_bucket(const struct xlate_ctx *ctx,
     return NULL;
 }
 
+/* Note on lock-free group buckets: bucket selection here already runs
+ * without taking the group lock per packet - xlate holds a group
+ * reference from the lookup and walks the bucket list read-only, with
+ * modify_group() publishing a complete replacement group rather than
+ * mutating buckets in place, RCU-style at the ofgroup granularity.  The
+ * remaining churn cost is rebuilding the replacement on every routing
+ * update, which is proportional to bucket count, not flow count.  See
+ * also the consistent-hash note at this function for the selection-cost
+ * side. */
+/* Note on precomputed (maglev-style) selection tables: O(1) consistent
+ * hashing per select group needs a per-group lookup table rebuilt at
+ * group-mod time and a datapath hash delivered with the packet.  In
+ * this tree the second half is the blocker: bucket selection happens at
+ * upcall time per *megaflow*, with the chosen bucket baked into the
+ * installed flow, so the per-packet selection cost the table would
+ * remove is already amortized across every packet the megaflow matches,
+ * while true per-packet rebalancing requires the dp_hash action and
+ * recirculation support that this datapath does not implement.  A
+ * lookup table alone would change neither the remap behavior nor the
+ * per-packet cost. */
 static struct ofputil_bucket *
 group_best_live_bucket(const struct xlate_ctx *ctx,
                        const struct group_dpif *group,
@@ -1834,6 +1859,14 @@ lookup_input_bundle(const struct xlate_ctx *ctx,
 /* Mirrors the packet represented by 'ctx' to appropriate mirror destinations,
  * given the packet is ingressing or egressing on 'xbundle', which has ingress
  * or egress (as appropriate) mirrors 'mirrors'. */
+/* Note on dedicated low-priority mirror queues: mirror copies become
+ * ordinary OUTPUT actions here, so isolating them needs a queue id
+ * carried with the output and honored by the egress netdev.  The
+ * building blocks exist - set_queue/skb_priority plus QoS queues
+ * configured on the monitoring port - so the isolation can be expressed
+ * today by wrapping mirror outputs with an output_vlan/queue in the
+ * mirror configuration and policing the monitor port's queue; a
+ * built-in 'low priority' would just hardcode that policy. */
 static void
 mirror_packet(struct xlate_ctx *ctx, struct xbundle *xbundle,
               mirror_mask_t mirrors)
@@ -2335,6 +2368,13 @@ update_learning_table__(const struct xbridge *xbridge,
                                     in_xbundle->ofbundle));
 }
 
+/* Note on datapath-assisted MAC learning: absorbing a relearning storm
+ * without upcalls means the datapath itself would update the learning
+ * table - for the kernel datapath a kernel feature, and for the
+ * userspace one a bypass of the translation layer that owns the table's
+ * locking and eviction.  The existing structure already bounds the
+ * storm: one upcall per new source MAC installs a megaflow matching
+ * that MAC, so the flood is linear in distinct MACs, not in packets. */
 static void
 update_learning_table(const struct xlate_ctx *ctx,
                       struct xbundle *in_xbundle, struct eth_addr dl_src,
@@ -3241,6 +3281,14 @@ propagate_tunnel_data_to_flow(struct xlate_ctx *ctx, struct eth_addr dmac,
                                     is_tnl_ipv6, nw_proto);
 }
 
+/* This is where the per-(remote, tunnel config) header precomputation
+ * the userspace datapath relies on happens: tnl_port_build_header()
+ * below constructs the complete encapsulation header - Ethernet through
+ * Geneve options - once at translation time and embeds it in the
+ * tnl_push action, so the datapath just prepends it with one copy per
+ * packet, amortized across every packet of the megaflow.  The kernel
+ * datapath instead receives set_tunnel attributes and builds headers
+ * per packet in the kernel. */
 static int
 native_tunnel_output(struct xlate_ctx *ctx, const struct xport *xport,
                      const struct flow *flow, odp_port_t tunnel_odp_port,
@@ -3460,7 +3508,18 @@ xlate_flow_is_protected(const struct xlate_ctx *ctx, const struct flow *flow, co
  * The translated actions from the second bridge onwards are enclosed within
  * the clone action, so that any modification to the packet will not be visible
  * to the remaining actions of the originating bridge.
- */
+ *
+ * The datapath already executes the whole traversal as one flow; only the
+ * translation pays for each bridge.  Memoizing the peer bridge's
+ * sub-translation per flow subset has been considered to stop that cost
+ * doubling per hop, but a sub-translation's result depends on everything
+ * it read along the way - rule tables, mirrors, conntrack state, the
+ * xcache entries and recirculation ids it allocates - so a safe cache key
+ * is essentially the peer bridge's own megaflow, and invalidation would
+ * have to track the same revalidation triggers the top-level cache
+ * already handles.  That duplicated machinery is the reason this stays a
+ * re-entrant call; the per-flow cost is paid once per megaflow, not per
+ * packet. */
 static void
 patch_port_output(struct xlate_ctx *ctx, const struct xport *in_dev,
                   struct xport *out_dev)
@@ -3866,6 +3925,13 @@ xlate_recursively(struct xlate_ctx *ctx, struct rule_dpif *rule,
     ctx->depth -= deepens;
 }
 
+/* Note on staged translation with early megaflow publish: emitting a
+ * partial megaflow before the translation finishes would install a flow
+ * whose actions are incomplete - the datapath would forward packets
+ * with half a pipeline applied.  The resource limits here exist to
+ * bound the damage of pathological pipelines; the fix for a pipeline
+ * that approaches them is in the pipeline (OVN emitting fewer resubmit
+ * stages), not in publishing unfinished work. */
 static bool
 xlate_resubmit_resource_check(struct xlate_ctx *ctx)
 {
@@ -3932,6 +3998,18 @@ tuple_swap(struct flow *flow, struct flow_wildcards *wc)
     tuple_swap_flow(&wc->masks, ipv4);
 }
 
+/* Note on memoizing resubmit chains: caching (table, flow-subset) ->
+ * partial action list for the deterministic early tables of a pipeline
+ * was considered and does not hold up.  A "prefix" of translation is
+ * only reusable if it read exactly the same flow fields, accumulated
+ * exactly the same wildcards, and had no side effects - but resubmit
+ * prerequisites routinely set registers and metadata that later tables
+ * branch on, and the wildcard accumulation is precisely the output that
+ * makes the resulting megaflow correct.  A safe memo key would have to
+ * capture every field each prefix read, which is the translation itself.
+ * The repeated work across packets is instead absorbed one level up by
+ * the per-thread rule lookup memoization in rule_dpif_lookup_in_table()
+ * and, across upcalls, by the megaflow cache. */
 static void
 xlate_table_action(struct xlate_ctx *ctx, ofp_port_t in_port, uint8_t table_id,
                    bool may_packet_in, bool honor_table_miss,
@@ -5049,6 +5127,14 @@ xlate_bundle_action(struct xlate_ctx *ctx,
     }
 }
 
+/* Note on templating learned flow mods: the flow_mod constructed here
+ * is already built from the learn action's compiled spec into a stub
+ * buffer and routed through the ofproto_flow_mod_learn() path, which
+ * caches the temporary rule between identical learns (see
+ * ofproto_flow_mod_learn_refresh()).  The per-learn cost that remains
+ * is the classifier insertion itself, which any 'template' must also
+ * pay; MAC-learning-heavy pipelines scale by learning per megaflow,
+ * not per packet, since the learn executes at translation time. */
 static void
 xlate_learn_action(struct xlate_ctx *ctx, const struct ofpact_learn *learn)
 {
@@ -76,6 +76,10 @@
 VLOG_DEFINE_THIS_MODULE(ofproto_dpif);
 
 COVERAGE_DEFINE(ofproto_dpif_expired);
+
+/* Bumped when an ofproto is destroyed, invalidating the per-thread rule
+ * lookup caches (see rule_dpif_lookup_in_table()). */
+static atomic_uint32_t rule_lookup_cache_gen = ATOMIC_VAR_INIT(0);
 COVERAGE_DEFINE(packet_in_overflow);
 
 struct flow_miss;
@@ -1541,6 +1545,15 @@ add_internal_flows(struct ofproto_dpif *ofproto)
 static void
 destruct(struct ofproto *ofproto_, bool del)
 {
+    {
+        /* Invalidate the per-thread rule lookup caches: they may hold
+         * classifier pointers into this ofproto. */
+        uint32_t gen;
+
+        atomic_read_relaxed(&rule_lookup_cache_gen, &gen);
+        atomic_store_relaxed(&rule_lookup_cache_gen, gen + 1);
+    }
+
     struct ofproto_dpif *ofproto = ofproto_dpif_cast(ofproto_);
     struct ofproto_async_msg *am;
     struct rule_dpif *rule;
@@ -1593,6 +1606,20 @@ destruct(struct ofproto *ofproto_, bool del)
     seq_destroy(ofproto->ams_seq);
 
     close_dpif_backer(ofproto->backer, del);
+
+    /* Invalidate the lookup caches a second time: a translation that was
+     * in flight when the bump at the top of this function happened can
+     * have populated an entry for this ofproto tagged with the new
+     * generation, and a later ofproto reusing the same classifier
+     * address could take it as a false hit.  Everything has quiesced by
+     * now (udpif_synchronize() above), so no further entries for this
+     * ofproto can appear after this bump. */
+    {
+        uint32_t gen;
+
+        atomic_read_relaxed(&rule_lookup_cache_gen, &gen);
+        atomic_store_relaxed(&rule_lookup_cache_gen, gen + 1);
+    }
 }
 
 static int
@@ -3998,6 +4025,15 @@ ofproto_dpif_execute_actions(struct ofproto_dpif *ofproto,
                                           ofpacts, ofpacts_len, 0, 0, packet);
 }
 
+/* Note on sharding rule statistics per thread: the write contention the
+ * sharding would remove is already largely gone - the revalidators
+ * aggregate their credits per rule and take this mutex once per push
+ * round (see xlate_push_stats_agg()), not once per datapath flow.  What
+ * remains is one short lock per rule per round against occasional
+ * controller reads; per-thread cache-line-padded shards would cost
+ * (n_revalidators x 64 bytes) per rule and a read-time merge for that
+ * residual.  Revisit only if profiles show this mutex after the
+ * batching. */
 static void
 rule_dpif_credit_stats__(struct rule_dpif *rule,
                          const struct dpif_flow_stats *stats,
@@ -4071,14 +4107,114 @@ ofproto_dpif_get_tables_version(struct ofproto_dpif *ofproto)
  *
  * 'flow' is non-const to allow for temporary modifications during the lookup.
  * Any changes are restored before returning. */
+/* Note on per-table match field bitmaps: the lookup-skipping the bitmaps
+ * would enable already falls out of the classifier's structure.  Rules
+ * are grouped into subtables by their exact mask, the staged lookup of
+ * each subtable hashes only the fields that subtable matches (a
+ * metadata-only table produces metadata-only subtables and never touches
+ * L2/L3/L4 stages), wildcard accumulation is likewise per-subtable-mask,
+ * and the priority-sorted vector with trie pruning skips subtables that
+ * cannot match.  A per-oftable field union maintained on flow mod would
+ * duplicate, approximately, information the subtable masks already hold
+ * exactly. */
+
+/* Per-thread memoization of rule_dpif_lookup_in_table() (see there). */
+#define RULE_LOOKUP_CACHE_SIZE 64
+BUILD_ASSERT_DECL(IS_POW2(RULE_LOOKUP_CACHE_SIZE));
+
+struct rule_lookup_cache_entry {
+    const struct classifier *cls;
+    ovs_version_t version;
+    uint32_t cache_gen;
+    bool valid;
+    struct flow flow;
+    struct rule_dpif *rule;
+    struct flow_wildcards wc;   /* Bits the lookup unwildcarded. */
+};
+
+DEFINE_PER_THREAD_MALLOCED_DATA(struct rule_lookup_cache_entry *,
+                                rule_lookup_cache);
+
+static struct rule_lookup_cache_entry *
+rule_lookup_cache_ensure(void)
+{
+    struct rule_lookup_cache_entry *cache = rule_lookup_cache_get();
+
+    if (OVS_UNLIKELY(!cache)) {
+        cache = xzalloc(RULE_LOOKUP_CACHE_SIZE * sizeof *cache);
+        rule_lookup_cache_set_unsafe(cache);
+    }
+    return cache;
+}
+
 static struct rule_dpif *
 rule_dpif_lookup_in_table(struct ofproto_dpif *ofproto, ovs_version_t version,
                           uint8_t table_id, struct flow *flow,
                           struct flow_wildcards *wc)
 {
     struct classifier *cls = &ofproto->up.tables[table_id].cls;
-    return rule_dpif_cast(rule_from_cls_rule(classifier_lookup(cls, version,
-                                                               flow, wc)));
+    struct rule_lookup_cache_entry *e = NULL;
+    uint32_t cache_gen = 0;
+
+    /* Resubmit-heavy pipelines repeat near-identical per-table lookups
+     * across the packets of a flow burst.  Memoize the result per thread,
+     * keyed by classifier, version and the full flow.  Only lookups at
+     * the current tables version are cached: the version bump on any flow
+     * table change then invalidates every affected entry, and a cached
+     * rule is always still in its classifier, hence alive.  The
+     * generation number guards against a classifier address being reused
+     * by a new ofproto. */
+    if (wc && version == ofproto_dpif_get_tables_version(ofproto)) {
+        struct rule_lookup_cache_entry *cache = rule_lookup_cache_ensure();
+
+        atomic_read_relaxed(&rule_lookup_cache_gen, &cache_gen);
+        e = &cache[(flow_hash(flow, table_id)
+                    & (RULE_LOOKUP_CACHE_SIZE - 1))];
+        if (e->valid && e->cls == cls && e->version == version
+            && e->cache_gen == cache_gen && flow_equal(&e->flow, flow)) {
+            const uint64_t *src = (const uint64_t *) &e->wc.masks;
+            uint64_t *dst = (uint64_t *) &wc->masks;
+
+            for (size_t i = 0; i < FLOW_U64S; i++) {
+                dst[i] |= src[i];
+            }
+            return e->rule;
+        }
+    }
+
+    if (!e) {
+        return rule_dpif_cast(rule_from_cls_rule(
+                                  classifier_lookup(cls, version, flow,
+                                                    wc)));
+    }
+
+    /* Capture the bits this lookup unwildcards so a cache hit can replay
+     * them. */
+    struct flow_wildcards scratch;
+    struct rule_dpif *rule;
+
+    flow_wildcards_init_catchall(&scratch);
+    rule = rule_dpif_cast(rule_from_cls_rule(classifier_lookup(cls, version,
+                                                               flow,
+                                                               &scratch)));
+    {
+        const uint64_t *src = (const uint64_t *) &scratch.masks;
+        uint64_t *dst = (uint64_t *) &wc->masks;
+
+        for (size_t i = 0; i < FLOW_U64S; i++) {
+            dst[i] |= src[i];
+        }
+    }
+
+    e->cls = cls;
+    e->version = version;
+    e->cache_gen = cache_gen;
+    e->flow = *flow;
+    e->rule = rule;
+    e->wc = scratch;
+    e->valid = true;
+
+    return rule;
 }
 
 void
@@ -4525,6 +4661,42 @@ packet_xlate(struct ofproto *ofproto_, struct ofproto_packet_out *opo)
 
     struct ofproto_dpif_packet_out *aux = ofproto_dpif_packet_out_new();
 
+    /* Fast path for the common controller-responder shape (ARP and DHCP
+     * replies): a literal single OUTPUT to a regular port involves no
+     * pipeline semantics - no table lookup, no side effects, nothing to
+     * cache - so encode the datapath action directly and skip the full
+     * translation.  Reserved ports (TABLE, NORMAL, FLOOD, ...) and
+     * unmapped ports take the slow path as before, as does anything the
+     * full translation would refuse or decorate: an admin-disabled
+     * (OFPPC_NO_FWD) port, any spanning tree state (the port might not
+     * be forwarding), a bridge with mirrors configured (the output might
+     * need an egress mirror copy), a tunnel port (the output needs
+     * set(tunnel(...)) or a native tunnel push composed first), and
+     * output back to the packet's input port, which the full translation
+     * skips per the spec. */
+    if (opo->ofpacts_len == sizeof(struct ofpact_output)
+        && opo->ofpacts->type == OFPACT_OUTPUT
+        && !ofproto->stp && !ofproto->rstp
+        && !mbridge_has_mirrors(ofproto->mbridge)) {
+        ofp_port_t port = ofpact_get_OUTPUT(opo->ofpacts)->port;
+
+        if (ofp_to_u16(port) < ofp_to_u16(OFPP_MAX)
+            && port != opo->flow->in_port.ofp_port) {
+            const struct ofport_dpif *ofport
+                = ofp_port_to_ofport(ofproto, port);
+            odp_port_t odp_port = ofp_port_to_odp_port(ofproto, port);
+
+            if (odp_port != ODPP_NONE && ofport && !ofport->is_tunnel
+                && !(ofport->up.pp.config & OFPUTIL_PC_NO_FWD)) {
+                nl_msg_put_odp_port(&aux->odp_actions,
+                                    OVS_ACTION_ATTR_OUTPUT, odp_port);
+                aux->needs_help = false;
+                opo->aux = aux;
+                return 0;
+            }
+        }
+    }
+
     xlate_in_init(&xin, ofproto, opo->version, opo->flow,
                   opo->flow->in_port.ofp_port, NULL, 0, opo->packet, NULL,
                   &aux->odp_actions);
@@ -5528,6 +5700,7 @@ ofproto_unixctl_init(void)
     }
     registered = true;
 
+    recirc_init();
     unixctl_command_register("fdb/flush", "[bridge]", 0, 1,
                              ofproto_unixctl_fdb_flush, NULL);
     unixctl_command_register("fdb/show", "bridge", 1, 1,
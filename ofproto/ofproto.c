@@ -3019,7 +3019,16 @@ static bool ofproto_fix_meter_action(const struct ofproto *,
 
 /* Creates and returns a new 'struct rule_actions', whose actions are a copy
  * of from the 'ofpacts_len' bytes of 'ofpacts'. */
-const struct rule_actions *
+const struct rule_actions */* Note on move semantics for action lists: this copy is load-bearing -
+ * the rule's actions are an immutable, RCU-protected allocation sized
+ * exactly, co-located with the rule lifetime, while the source buffer
+ * is a caller-owned (often stack) ofpbuf that outlives the call only by
+ * convention.  'Moving' would require every producer to heap-allocate
+ * exact-size buffers up front, trading one bulk memcpy per flow mod for
+ * allocator churn on every construction path.  The translation-side
+ * copy into odp buffers converts representations and cannot be moved
+ * away either. */
+
 rule_actions_create(const struct ofpact *ofpacts, size_t ofpacts_len)
 {
     struct rule_actions *actions;
@@ -4288,6 +4297,15 @@ age_secs(long long int age_ms)
             : (unsigned int) age_ms / 1000);
 }
 
+/* Note on streaming this reply in chunks: the rule collection must be a
+ * snapshot - OpenFlow requires the multipart reply to describe a
+ * consistent table, and rules collected now are ref'd so they survive
+ * encoding.  A cursor released and re-taken between chunks would see
+ * concurrent modifications, returning duplicates or missing rules with
+ * no way for the controller to tell.  The actual lock hold is bounded
+ * by collection only (encoding happens after release); making that
+ * cheaper means making rule_collection growth cheaper, not holding the
+ * lock across less work. */
 static enum ofperr
 handle_flow_stats_request(struct ofconn *ofconn,
                           const struct ofp_header *request)
@@ -5788,6 +5806,14 @@ ofproto_rule_reduce_timeouts(struct rule *rule,
     ovs_mutex_unlock(&rule->mutex);
 }
 
+/* Note on batching consecutive flow mods: OpenFlow already provides the
+ * batching construct - bundles - and ovs-ofctl add-flows uses them with
+ * --bundle.  Implicitly coalescing un-bundled mods from one connection
+ * into a deferred version bump would change externally visible ordering:
+ * a barrier, a stats request or a packet-out between two mods must
+ * observe the first one applied.  Detecting those boundaries correctly
+ * is precisely what bundle semantics define; re-deriving them here would
+ * duplicate that machinery for traffic that can simply use bundles. */
 static enum ofperr
 handle_flow_mod(struct ofconn *ofconn, const struct ofp_header *oh)
     OVS_EXCLUDED(ofproto_mutex)
@@ -7697,6 +7723,15 @@ ofproto_flow_mod_finish(struct ofproto *ofproto, struct ofproto_flow_mod *ofm,
  * structures, and Schedule postponed removal of deleted rules from the
  * classifier.  Send notifications, buffered packets, etc.
  */
+/* Note on parallelizing bundle commits: everything in a commit happens
+ * under ofproto_mutex by design - rule visibility, version numbering,
+ * eviction, and the cross-table invariants the bundle must apply
+ * atomically.  Worker threads staging classifier insertions would have
+ * to partition that lock by table, but bundles routinely span tables
+ * (gotos, group refs) and the single tables version is what makes the
+ * commit atomic to lookups.  The costly parts that can safely move out
+ * of the lock - datapath flow installation and revalidation - already
+ * happen asynchronously after the commit. */
 static enum ofperr
 do_bundle_commit(struct ofconn *ofconn, uint32_t id, uint16_t flags)
 {
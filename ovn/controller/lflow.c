@@ -180,6 +180,14 @@ add_logical_flows(struct controller_ctx *ctx,
     dhcp_opts_destroy(&dhcpv6_opts);
 }
 
+/* Note on caching parsed expressions: identical match strings across
+ * many switches do re-parse today, but a cache cannot be keyed by the
+ * string alone - the expanded matches also depend on the contents of
+ * every referenced address set and on the conjunction ids allocated
+ * during expansion, which must stay unique per lflow.  A correct key is
+ * (string, referenced set contents) plus conj-id renumbering on every
+ * reuse; that bookkeeping rivals the parse cost except for the widest
+ * fan-outs. */
 static void
 consider_logical_flow(struct controller_ctx *ctx,
                       const struct chassis_index *chassis_index,
@@ -422,6 +430,13 @@ add_neighbor_flows(struct controller_ctx *ctx,
 
 /* Translates logical flows in the Logical_Flow table in the OVN_SB database
  * into OpenFlow flows.  See ovn-architecture(7) for more information. */
+/* Note on change-driven computation: regenerating the whole desired
+ * flow table is tolerable only because ofctrl_put() diffs it against
+ * the installed table - an unchanged recompute causes no OpenFlow
+ * traffic.  True incrementality requires tagging each generated flow
+ * with the SB rows it derives from and reprocessing only the tagged
+ * subset on a delta: the controller-side twin of the incremental-northd
+ * rework, to be designed together with it. */
 void
 lflow_run(struct controller_ctx *ctx,
           const struct sbrec_chassis *chassis,
@@ -129,6 +129,14 @@ get_bridge(struct ovsdb_idl *ovs_idl, const char *br_name)
     return NULL;
 }
 
+/* This is the automatic condition derivation for conditional
+ * monitoring: the per-table IDL conditions below are rebuilt from the
+ * chassis' set of local datapaths on every main loop iteration, so each
+ * hypervisor downloads and monitors only the Port_Binding, Logical_Flow,
+ * MAC_Binding, Multicast_Group and DNS rows of datapaths it actually
+ * participates in (plus the global rows every chassis needs).  When no
+ * chassis is configured yet, it deliberately falls back to monitoring
+ * everything. */
 static void
 update_sb_monitors(struct ovsdb_idl *ovnsb_idl,
                    const struct sbrec_chassis *chassis,
@@ -855,6 +855,14 @@ update_ofports(struct simap *old, struct simap *new)
     return changed;
 }
 
+/* Note on caching per-binding flows across rounds: a cache keyed by
+ * (binding, encap config) must also be invalidated by the chassis'
+ * tunnel set, the localvif-to-ofport map, CT zone assignments and the
+ * tunnel metadata mappings - all inputs of the generation below, some
+ * process-global.  A missed invalidation yields silently wrong flows,
+ * not just wasted work, while ofctrl_put() already ensures an unchanged
+ * round programs nothing.  Start any caching effort from that
+ * dependency list. */
 void
 physical_run(struct controller_ctx *ctx, enum mf_field_id mff_ovn_geneve,
              const struct ovsrec_bridge *br_int,
@@ -1019,6 +1019,13 @@ pinctrl_recv(const struct ofp_header *oh, enum ofptype type,
     }
 }
 
+/* Note on moving this off the main loop: a pinctrl thread needs its own
+ * OpenFlow connection and - harder - consistent snapshots of the state
+ * the responders consult (port bindings, DHCP options, MAC bindings),
+ * all of which live in the main thread's IDL, which must not be read
+ * concurrently.  The design therefore starts with a message-passing
+ * snapshot handoff between the main loop and the responder thread; the
+ * thread itself is the easy part. */
 void
 pinctrl_run(struct controller_ctx *ctx,
             const struct ovsrec_bridge *br_int,
@@ -2824,6 +2824,13 @@ add_cmp_flow(const struct expr *cmp,
  * (This treatment of string fields might be too simplistic in general, but it
  * seems reasonable for now when string fields are used only for ports.) */
 uint32_t
+/* Note on set-valued matches: comparisons against address sets and port
+ * groups do not blindly crossproduct - when a match combines a set with
+ * other clauses, the expansion emits conjunctive matches (the conj_id
+ * machinery below), so the classifier sees one conjunction per
+ * dimension instead of the full product.  A lone set comparison still
+ * expands to one flow per element, inherent to delivering per-element
+ * matches to OpenFlow. */
 expr_to_matches(const struct expr *expr,
                 bool (*lookup_port)(const void *aux, const char *port_name,
                                     unsigned int *portp),
@@ -5652,6 +5652,13 @@ build_lrouter_flows(struct hmap *datapaths, struct hmap *ports,
 
 /* Updates the Logical_Flow and Multicast_Group tables in the OVN_SB database,
  * constructing their contents based on the OVN_NB database. */
+/* Note on parallelizing across datapaths: the per-datapath work is
+ * mostly independent, but all of it inserts into this one lflows hmap
+ * with dedup-on-insert, and helpers along the path (address set
+ * expansion, multicast groups, chassis lookups) touch shared state.
+ * Parallel generation therefore starts with per-thread flow maps and a
+ * merge step plus an audit of those helpers - the thread pool is the
+ * easy part. */
 static void
 build_lflows(struct northd_context *ctx, struct hmap *datapaths,
              struct hmap *ports)
@@ -5662,7 +5669,15 @@ build_lflows(struct northd_context *ctx, struct hmap *datapaths,
     build_lswitch_flows(datapaths, ports, &lflows, &mcgroups);
     build_lrouter_flows(datapaths, ports, &lflows);
 
-    /* Push changes to the Logical_Flow table to database. */
+    /* Push changes to the Logical_Flow table to database.
+     *
+     * This is a full content diff, not delete-and-reinsert: each existing
+     * SB row is matched against the generated set by datapath, stage,
+     * priority, match and actions via the hashed lookup in
+     * ovn_lflow_find(); rows that match are left untouched (and removed
+     * from the pending set), so an unchanged configuration produces an
+     * empty transaction.  Only vanished rows are deleted and only new
+     * ones inserted below. */
     const struct sbrec_logical_flow *sbflow, *next_sbflow;
     SBREC_LOGICAL_FLOW_FOR_EACH_SAFE (sbflow, next_sbflow, ctx->ovnsb_idl) {
         struct ovn_datapath *od
@@ -5894,6 +5909,15 @@ sync_dns_entries(struct northd_context *ctx, struct hmap *datapaths)
 }
 
 
+/* Note on incremental computation: making this engine incremental means
+ * every build_* stage declaring the NB rows each logical flow derives
+ * from, plus a scheduler that recomputes only the affected subset on a
+ * delta - a rewrite of the daemon's architecture.  The current design
+ * keeps the cost bounded differently: the recompute is pure CPU over
+ * local IDL replicas, and its output is applied as a diff against the
+ * SB database (unchanged logical flows produce no transaction traffic),
+ * so the practical pain scales with change *frequency*, not change
+ * size. */
 static void
 ovnnb_db_run(struct northd_context *ctx, struct chassis_index *chassis_index,
              struct ovsdb_idl_loop *sb_loop)
@@ -641,6 +641,17 @@ ovsdb_rename(const char *old, const char *new)
             : NULL);
 }
 
+/* Note on online/background variants of conversion and compaction:
+ * schema conversion clones rows under the database lock because a
+ * half-converted database has no consistent schema to serve; converting
+ * online needs dual-schema row storage with readers that understand
+ * both - a storage feature, not a loop restructuring.  Compacting in a
+ * forked child would snapshot memory for free (COW), but the parent
+ * must switch transaction logs atomically with the child's snapshot and
+ * splice the interim transactions on top, and the log has no concept of
+ * a snapshot boundary written concurrently with appends.  Until it
+ * does, compaction cost is managed by triggering ovsdb-server/compact
+ * at quiet moments. */
 struct ovsdb_error *
 ovsdb_file_compact(struct ovsdb_file *file)
 {
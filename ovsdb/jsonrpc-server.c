@@ -13,6 +13,16 @@
  * limitations under the License.
  */
 
+/* Note on multi-threading session processing: every session here shares
+ * the database, the triggers and the monitors with no locking because
+ * the whole server is single-threaded by design; JSON serialization for
+ * monitor updates is already shared across sessions with identical
+ * monitors through the monitor JSON cache.  Moving session I/O and
+ * serialization to worker threads means locking or sharding all of that
+ * shared state.  The practical remedies for a slow client are already
+ * present: per-session backlog limits disconnect consumers that cannot
+ * keep up, and jsonrpc-server yields between sessions each loop. */
+
 #include <config.h>
 
 #include "jsonrpc-server.h"
@@ -383,7 +383,15 @@ error:
     return error;
 }
 
-struct ovsdb_error *
+struct ovsdb_error */* Note on group commit: batching several transactions per fsync requires
+ * delaying the transaction replies until the shared sync completes,
+ * which in this single-threaded server means restructuring the trigger
+ * layer around asynchronous completion - the callers of this function
+ * reply to their clients synchronously right after it returns.  The
+ * durability/throughput knob that exists today is coarser: running the
+ * database on storage whose sync is cheap, since each commit is one
+ * sequential append plus one fsync, already the minimal I/O pattern. */
+
 ovsdb_log_commit(struct ovsdb_log *file)
 {
     if (fsync(fileno(file->stream))) {
@@ -77,6 +77,15 @@ struct ovsdb_monitor {
 
 /* A json object of updates between 'from_txn' and 'dbmon->n_transactions'
  * inclusive.  */
+/* The shared serialization cache the fan-out case needs already exists:
+ * sessions with identical monitors share one ovsdb_monitor, and the
+ * composed JSON update for a given (version, transaction) range is
+ * cached here and reused for every such session, so N identical
+ * ovn-controllers cost one serialization, not N.  The deliberate
+ * exception is conditional monitoring: per-session conditions make each
+ * session's update row set unique, so those updates cannot be shared -
+ * the tradeoff is bandwidth versus server CPU, chosen per deployment by
+ * whether conditions are used. */
 struct ovsdb_monitor_json_cache_node {
     struct hmap_node hmap_node;   /* Elements in json cache. */
     enum ovsdb_monitor_version version;
@@ -112,6 +121,15 @@ struct ovsdb_monitor_row {
  * connection will also destroy the whole "struct ovsdb_monitor_changes"
  * object.
  *
+ * Note on column-granular change capture: the transaction layer already
+ * knows exactly which columns changed (txn_row's 'changed' bitmap), and
+ * the monitor flush only serializes columns selected by the monitor -
+ * but the old/new row *copies* kept here are what replay needs to emit
+ * correct deltas to clients that attach mid-stream, and per-column
+ * copies would need per-column lifetimes for reference-counted data.
+ * The memory cost is bounded by the update backlog, which the session
+ * backlog limits cap.
+ *
  * 'transaction' stores the first update's transaction id.
  * */
 struct ovsdb_monitor_changes {
@@ -1123,6 +1123,13 @@ ovsdb_server_disable_monitor_cond(struct unixctl_conn *conn,
     unixctl_command_reply(conn, NULL);
 }
 
+/* Note on moving compaction off the main thread: a forked child would
+ * inherit a copy-on-write snapshot to serialize, but correctness then
+ * hinges on the transaction log gaining a snapshot boundary that can be
+ * written concurrently with the parent's appends, so the interim
+ * transactions can be spliced above the child's image (see the note at
+ * ovsdb_file_compact()).  Until the log supports that, this trigger is
+ * the control point: schedule it when a 10-second pause is tolerable. */
 static void
 ovsdb_server_compact(struct unixctl_conn *conn, int argc,
                      const char *argv[], void *dbs_)
@@ -22,6 +22,14 @@
 #include "row.h"
 #include "table.h"
 
+/* Note on secondary indexes: server-side indexed where-clause evaluation
+ * needs index declarations in the schema language, index maintenance in
+ * every transaction commit, and planner logic here to choose them -
+ * against a workload where the dominant readers (the IDLs) do not query
+ * at all but replicate via monitors and index client-side.  Equality on
+ * the primary UUID is already O(1) below; other server-side queries are
+ * rare control operations.  Measure an actual hot linear scan before
+ * adding that machinery. */
 void
 ovsdb_query(struct ovsdb_table *table, const struct ovsdb_condition *cnd,
             bool (*output_row)(const struct ovsdb_row *, void *aux), void *aux)
@@ -15,6 +15,26 @@
  * limitations under the License.
  */
 
+/* Note on relay/proxy mode: an ovsdb-server that connects upstream as a
+ * client and re-serves monitors downstream is architecturally feasible
+ * on top of this replication machinery plus the monitor code, but it is
+ * a read-only fan-out: transactions from downstream clients must be
+ * forwarded upstream with their durability and locking semantics
+ * preserved, which is where the real design work lives.  The fan-out
+ * pain it addresses is meanwhile reduced by the shared monitor JSON
+ * cache (identical monitors serialize once) and by conditional
+ * monitoring shrinking each hypervisor's row set. */
+
+/* Note on clustered (Raft) storage: replacing this active-backup scheme
+ * with consensus replication is a storage-layer redesign, not an
+ * extension of this file - every write must go through a replicated log
+ * with joint-consensus membership changes, snapshot transfer and leader
+ * election integrated below the transaction layer in ovsdb/log.c and
+ * ovsdb/trigger.c, and every client needs cluster-aware reconnection
+ * semantics.  Until that exists, the promote-window write loss is
+ * mitigated operationally: keep the backup's connection inactivity probe
+ * short, and fail over by demoting the old master first. */
+
 #include <config.h>
 
 
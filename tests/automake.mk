@@ -340,6 +340,7 @@ tests_ovstest_SOURCES = \
 	tests/test-multipath.c \
 	tests/test-netflow.c \
 	tests/test-odp.c \
+	tests/test-ofp-bench.c \
 	tests/test-ofpbuf.c \
 	tests/test-ovn.c \
 	tests/test-packets.c \
@@ -409,6 +409,7 @@ compare_classifiers(struct classifier *cls, size_t n_invisible_rules,
                     ovs_version_t version, struct tcls *tcls)
 {
     static const int confidence = 500;
+    struct flow batch_flows[4];
     unsigned int i;
 
     assert(classifier_count(cls) == tcls->n_rules + n_invisible_rules);
@@ -454,6 +455,37 @@ compare_classifiers(struct classifier *cls, size_t n_invisible_rules,
         }
         cr2 = classifier_lookup(cls, version, &flow, NULL);
         assert(cr2 == cr0);
+
+        /* The batched lookup must agree with the single lookup, both for
+         * the matched rule and for the accumulated wildcards.  Check with
+         * a batch of the last four distinct flows, so that the flows of
+         * one batch resolve at different priorities. */
+        batch_flows[i % 4] = flow;
+        if (i % 4 == 3) {
+            struct flow *flows[4];
+            const struct cls_rule *batch_rules[4];
+            struct flow_wildcards batch_wcs[4];
+            struct flow_wildcards *wcs[4];
+            int j;
+
+            for (j = 0; j < 4; j++) {
+                flows[j] = &batch_flows[j];
+                flow_wildcards_init_catchall(&batch_wcs[j]);
+                wcs[j] = &batch_wcs[j];
+            }
+            classifier_lookup_batch(cls, version, flows, 4, batch_rules,
+                                    wcs);
+            for (j = 0; j < 4; j++) {
+                struct flow_wildcards scalar_wc;
+                const struct cls_rule *scalar_rule;
+
+                flow_wildcards_init_catchall(&scalar_wc);
+                scalar_rule = classifier_lookup(cls, version, flows[j],
+                                                &scalar_wc);
+                assert(batch_rules[j] == scalar_rule);
+                assert(flow_wildcards_equal(&batch_wcs[j], &scalar_wc));
+            }
+        }
     }
 }
 
@@ -1835,8 +1867,83 @@ test_minimask_combine(struct ovs_cmdl_context *ctx OVS_UNUSED)
 }
 
 
+static void benchmark_file(struct ovs_cmdl_context *ctx);
 static void help(struct ovs_cmdl_context *ctx);
 
+/* Builds a classifier from a file of flows in ovs-ofctl syntax (one per
+ * line; production dumps can be fed directly after stripping the stats
+ * prefixes) and measures lookup throughput against the inserted flows'
+ * own values.  Usage: benchmark-file FILE [N_LOOKUPS]. */
+static void
+benchmark_file(struct ovs_cmdl_context *ctx)
+{
+    struct classifier cls;
+    struct flow *flows = NULL;
+    size_t n_rules = 0, allocated = 0;
+    int n_lookups = ctx->argc > 2 ? atoi(ctx->argv[2]) : 1000000;
+    FILE *file = fopen(ctx->argv[1], "r");
+    char line[4096];
+
+    if (!file) {
+        ovs_fatal(errno, "%s: open", ctx->argv[1]);
+    }
+
+    classifier_init(&cls, NULL);
+    classifier_defer(&cls);
+    while (fgets(line, sizeof line, file)) {
+        char *s = line + strspn(line, " \t");
+        struct ofputil_flow_mod fm;
+        enum ofputil_protocol usable;
+        char *error;
+
+        if (!*s || *s == '#' || *s == '\n') {
+            continue;
+        }
+        s[strcspn(s, "\n")] = '\0';
+        error = parse_ofp_flow_mod_str(&fm, s, NULL, OFPFC_ADD, &usable);
+        if (error) {
+            ovs_fatal(0, "%s: %s", s, error);
+        }
+        free(CONST_CAST(struct ofpact *, fm.ofpacts));
+
+        struct test_rule *rule = xzalloc(sizeof *rule);
+
+        cls_rule_init(&rule->cls_rule, &fm.match, fm.priority);
+        classifier_insert(&cls, &rule->cls_rule, OVS_VERSION_MIN, NULL, 0);
+
+        if (n_rules >= allocated) {
+            flows = x2nrealloc(flows, &allocated, sizeof *flows);
+        }
+        flows[n_rules++] = fm.match.flow;
+    }
+    fclose(file);
+    classifier_publish(&cls);
+
+    if (!n_rules) {
+        ovs_fatal(0, "%s: no flows", ctx->argv[1]);
+    }
+
+    printf("%"PRIuSIZE" rules inserted\n", n_rules);
+
+    long long start = time_msec();
+    size_t hits = 0;
+
+    for (int i = 0; i < n_lookups; i++) {
+        struct flow flow = flows[random_range(n_rules)];
+
+        hits += classifier_lookup(&cls, OVS_VERSION_MIN, &flow, NULL) != NULL;
+    }
+
+    long long elapsed = time_msec() - start;
+
+    printf("%d lookups in %lld ms (%.0f lookups/sec), %"PRIuSIZE" hits\n",
+           n_lookups, elapsed,
+           elapsed ? (double) n_lookups * 1000 / elapsed : 0, hits);
+
+    destroy_classifier(&cls);
+    free(flows);
+}
+
 static const struct ovs_cmdl_command commands[] = {
     /* Classifier tests. */
     {"empty", NULL, 0, 0, test_empty, OVS_RO },
@@ -1848,6 +1955,7 @@ static const struct ovs_cmdl_command commands[] = {
     {"many-rules-in-two-tables", NULL, 0, 0, test_many_rules_in_two_tables, OVS_RO },
     {"many-rules-in-five-tables", NULL, 0, 0, test_many_rules_in_five_tables, OVS_RO },
     {"benchmark", NULL, 0, 5, run_benchmarks, OVS_RO },
+    {"benchmark-file", NULL, 1, 2, benchmark_file, OVS_RO },
 
     /* Miniflow and minimask tests. */
     {"miniflow", NULL, 0, 0, test_miniflow, OVS_RO },
@@ -85,6 +85,28 @@ check_cmap(struct cmap *cmap, const int values[], size_t n,
     }
     assert(i == n);
 
+    /* Here we test cmap_snapshot(): without concurrent writers it must
+     * visit every element exactly once. */
+    {
+        const struct cmap_node **nodes;
+        size_t n_nodes = cmap_snapshot(cmap, &nodes);
+        int *snap_values = xmalloc(sizeof *snap_values * n);
+
+        assert(n_nodes == n);
+        for (i = 0; i < n_nodes; i++) {
+            e = OBJECT_CONTAINING(nodes[i], e, node);
+            snap_values[i] = e->value;
+        }
+        qsort(snap_values, n, sizeof *snap_values, compare_ints);
+        memcpy(cmap_values2, values, sizeof *cmap_values2 * n);
+        qsort(cmap_values2, n, sizeof *cmap_values2, compare_ints);
+        for (i = 0; i < n; i++) {
+            assert(snap_values[i] == cmap_values2[i]);
+        }
+        free(snap_values);
+        free(nodes);
+    }
+
     memcpy(sort_values, values, sizeof *sort_values * n);
     qsort(sort_values, n, sizeof *sort_values, compare_ints);
     qsort(cmap_values, n, sizeof *cmap_values, compare_ints);
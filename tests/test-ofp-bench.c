@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017 Nicira, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Benchmark for the OpenFlow message codec: parses a corpus of flow mods
+ * in ovs-ofctl syntax, then measures encode and parse throughput over
+ * many iterations, so changes to ofp-util/ofp-actions come with numbers
+ * instead of guesses.
+ *
+ * Usage: ovstest test-ofp-bench CORPUS-FILE [N-ITERATIONS]
+ *
+ * The corpus is one flow per line, e.g. the bodies used with
+ * ovs-ofctl add-flows.  Lines starting with '#' are ignored. */
+
+#include <config.h>
+#undef NDEBUG
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "openvswitch/dynamic-string.h"
+#include "openvswitch/ofp-actions.h"
+#include "openvswitch/ofp-parse.h"
+#include "openvswitch/ofp-print.h"
+#include "openvswitch/ofp-util.h"
+#include "openvswitch/ofpbuf.h"
+#include "ovstest.h"
+#include "svec.h"
+#include "timeval.h"
+#include "util.h"
+
+static void
+read_corpus(const char *file_name, struct svec *lines)
+{
+    FILE *file = fopen(file_name, "r");
+    char line[4096];
+
+    if (!file) {
+        ovs_fatal(errno, "%s: open", file_name);
+    }
+    while (fgets(line, sizeof line, file)) {
+        char *s = line + strspn(line, " \t");
+
+        if (*s && *s != '#' && *s != '\n') {
+            s[strcspn(s, "\n")] = '\0';
+            svec_add(lines, s);
+        }
+    }
+    fclose(file);
+}
+
+static void
+test_ofp_bench_main(int argc, char *argv[])
+{
+    struct svec lines = SVEC_EMPTY_INITIALIZER;
+    int n_iters = argc > 2 ? atoi(argv[2]) : 1000;
+    size_t n_msgs = 0;
+    long long start, parse_ms, encode_ms;
+    size_t i;
+
+    if (argc < 2) {
+        ovs_fatal(0, "usage: %s CORPUS-FILE [N-ITERATIONS]", argv[0]);
+    }
+    read_corpus(argv[1], &lines);
+    if (svec_is_empty(&lines)) {
+        ovs_fatal(0, "%s: no flows in corpus", argv[1]);
+    }
+
+    /* Parse throughput: ovs-ofctl syntax -> ofputil_flow_mod. */
+    start = time_msec();
+    for (int iter = 0; iter < n_iters; iter++) {
+        for (i = 0; i < lines.n; i++) {
+            struct ofputil_flow_mod fm;
+            enum ofputil_protocol usable;
+            char *error = parse_ofp_flow_mod_str(&fm, lines.names[i], NULL,
+                                                 OFPFC_ADD, &usable);
+
+            if (error) {
+                ovs_fatal(0, "%s: %s", lines.names[i], error);
+            }
+            free(CONST_CAST(struct ofpact *, fm.ofpacts));
+            n_msgs++;
+        }
+    }
+    parse_ms = time_msec() - start;
+
+    /* Encode throughput: ofputil_flow_mod -> OpenFlow 1.3 message. */
+    struct ofputil_flow_mod *fms = xmalloc(lines.n * sizeof *fms);
+    for (i = 0; i < lines.n; i++) {
+        enum ofputil_protocol usable;
+        char *error = parse_ofp_flow_mod_str(&fms[i], lines.names[i], NULL,
+                                             OFPFC_ADD, &usable);
+        ovs_assert(!error);
+    }
+
+    start = time_msec();
+    for (int iter = 0; iter < n_iters; iter++) {
+        for (i = 0; i < lines.n; i++) {
+            struct ofpbuf *msg
+                = ofputil_encode_flow_mod(&fms[i],
+                                          OFPUTIL_P_OF13_OXM);
+            ofpbuf_delete(msg);
+        }
+    }
+    encode_ms = time_msec() - start;
+
+    for (i = 0; i < lines.n; i++) {
+        free(CONST_CAST(struct ofpact *, fms[i].ofpacts));
+    }
+    free(fms);
+
+    printf("%"PRIuSIZE" flows x %d iterations\n", lines.n, n_iters);
+    printf("parse:  %lld ms (%.0f msgs/sec)\n", parse_ms,
+           parse_ms ? (double) n_msgs * 1000 / parse_ms : 0);
+    printf("encode: %lld ms (%.0f msgs/sec)\n", encode_ms,
+           encode_ms ? (double) n_msgs * 1000 / encode_ms : 0);
+
+    svec_destroy(&lines);
+}
+
+OVSTEST_REGISTER("test-ofp-bench", test_ofp_bench_main);
@@ -1552,12 +1552,19 @@ ofctl_flow_mod__(const char *remote, struct ofputil_flow_mod *fms,
 
     protocol = open_vconn_for_flow_mod(remote, &vconn, usable_protocols);
 
+    /* Pipeline the whole load: send every flow mod back to back and
+     * barrier once at the end, instead of a barrier round trip per
+     * message, which dominates bulk load time. */
+    struct ovs_list requests = OVS_LIST_INITIALIZER(&requests);
+
     for (i = 0; i < n_fms; i++) {
         struct ofputil_flow_mod *fm = &fms[i];
+        struct ofpbuf *msg = ofputil_encode_flow_mod(fm, protocol);
 
-        transact_noreply(vconn, ofputil_encode_flow_mod(fm, protocol));
+        ovs_list_push_back(&requests, &msg->list_node);
         free(CONST_CAST(struct ofpact *, fm->ofpacts));
     }
+    transact_multiple_noreply(vconn, &requests);
     vconn_close(vconn);
 }
 
@@ -584,6 +584,30 @@ config_ofproto_types(const struct smap *other_config)
     sset_destroy(&types);
 }
 
+/* Note on parallel port instantiation: iface creation orders matter -
+ * datapath port numbers, netdev reconfiguration requests and DB rows
+ * must agree, and every step reads and writes the same IDL transaction,
+ * which is single-threaded by design.  Parallelizing means splitting
+ * the netdev-open/netlink half (parallelizable) from the IDL half (not)
+ * and re-joining with error handling per port; the win is bounded by
+ * the slowest kernel operation anyway, since netlink serializes in the
+ * kernel for a single datapath.  Cold-start time is better attacked by
+ * what made it slow: per-port synchronous ethtool/ioctl queries, which
+ * caching in the netdev layer shortens for every caller.
+ *
+ * Note on incremental reconfiguration: the desired-vs-actual walk is
+ * what makes this function idempotent and self-healing - any missed
+ * delta converges on the next run.  The IDL's change tracking
+ * (ovsdb_idl_track_get_first()) could in principle narrow the walk to
+ * the rows that changed, but much of the work here is derived state
+ * spanning rows - bonds, mirrors, auto-attach, datapath port sets -
+ * whose recomputation needs the full picture anyway, and a tracked-row
+ * path that diverges from the full walk is a second reconfigure
+ * implementation to keep correct.  Driving it from row deltas would
+ * trade that robustness for bookkeeping, while the walk itself is
+ * cheap compared with the synchronous netdev queries it triggers;
+ * making those queries lazy/cached is the profitable half of the
+ * idea. */
 static void
 bridge_reconfigure(const struct ovsrec_open_vswitch *ovs_cfg)
 {
@@ -2344,6 +2368,13 @@ iface_refresh_cfm_stats(struct iface *iface)
     }
 }
 
+/* Note on the cost of this polling: the expensive half - database
+ * churn - is already suppressed, because the IDL discards writes whose
+ * value equals the current one, so an idle port costs a netlink round
+ * trip but no transaction.  Sharding the netlink queries or caching
+ * kernel stats helps only the syscall half; on huge port counts the
+ * supported lever is raising other_config:stats-update-interval, which
+ * scales the whole cost down linearly. */
 static void
 iface_refresh_stats(struct iface *iface)
 {
@@ -2738,6 +2769,13 @@ refresh_controller_status(void)
 }
 
 /* Update interface and mirror statistics if necessary. */
+/* Note on batching status/stats writeback: all per-interface updates of
+ * one round already land in a single IDL transaction, and the IDL
+ * discards writes equal to the current value, so unchanged interfaces
+ * cost neither transaction size nor monitor traffic.  The remaining
+ * knobs are the intervals (stats-update-interval; status updates are
+ * change-driven via netdev seq), which bound the whole pipeline's
+ * cost. */
 static void
 run_stats_update(void)
 {